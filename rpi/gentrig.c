@@ -0,0 +1,68 @@
+/********************************************************************
+ * gentrig.c
+ *
+ *  Build time generator of the quarter-wave sine table used by the
+ *  map patch rotation in map.c.
+ *  The table holds sin() in Q15 fixed-point for angles 0 to 90 degrees
+ *  at the heading resolution MAP_HEADING_RES defined in map.h.
+ *  The generated header is written to stdout.
+ *
+ *  Usage:
+ *      gentrig > inc/trig_table.h
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#include    <stdio.h>
+#include    <math.h>
+
+#include    "map.h"
+
+/********************************************************************
+ * Definitions
+ *
+ */
+#define     Q15_ONE         32768.0
+#define     VALUES_PER_LINE 10
+
+/********************************************************************
+ * main()
+ *
+ * return: 0 if ok
+ *
+ */
+int main(void)
+{
+    int     i;
+    double  angle;
+
+    printf("/********************************************************************\n");
+    printf(" * trig_table.h\n");
+    printf(" *\n");
+    printf(" *  Quarter-wave Q15 sine table, %d steps per degree.\n", MAP_HEADING_RES);
+    printf(" *  Generated by gentrig.c at build time, do not edit.\n");
+    printf(" *\n");
+    printf(" *******************************************************************/\n\n");
+    printf("#ifndef __trig_table_h__\n");
+    printf("#define __trig_table_h__\n\n");
+    printf("#if MAP_HEADING_RES != %d\n", MAP_HEADING_RES);
+    printf("#error \"trig_table.h is out of date, rebuild it with gentrig\"\n");
+    printf("#endif\n\n");
+    printf("static const uint16_t SIN_Q15[%d] = {", MAP_HEADING_QUARTER + 1);
+
+    for ( i = 0; i <= MAP_HEADING_QUARTER; i++ )
+    {
+        angle = (i * M_PI) / (180.0 * MAP_HEADING_RES);
+
+        if ( (i % VALUES_PER_LINE) == 0 )
+            printf("\n   ");
+
+        printf(" %5ld%s", lround(sin(angle) * Q15_ONE), (i < MAP_HEADING_QUARTER) ? "," : "");
+    }
+
+    printf("\n};\n\n");
+    printf("#endif  /* __trig_table_h__ */\n");
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+/********************************************************************
+ * gps.c
+ *
+ *  GPS ingest thread.
+ *  The thread owns the GPS UART, reads and parses the NMEA sentences,
+ *  and publishes a complete position snapshot for every sentence
+ *  through a lock-free single-producer/single-consumer queue.
+ *  The UI thread polls the queue file descriptor together with its
+ *  frame timer and reads the queued fixes without blocking, so push
+ *  button debounce and frame rendering do not delay NMEA processing.
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#include    <stdint.h>
+#include    <string.h>
+#include    <unistd.h>
+#include    <errno.h>
+#include    <poll.h>
+#include    <pthread.h>
+#include    <stdatomic.h>
+#include    <sys/eventfd.h>
+
+#include    "gps.h"
+#include    "util.h"
+
+/********************************************************************
+ * Module definitions
+ *
+ */
+#define     GPS_FIX_MASK        (GPS_FIX_QUEUE - 1)
+#define     GPS_ERROR_WAIT      100             // mSec wait after a UART read or poll error
+
+/********************************************************************
+ * Static functions
+ *
+ */
+static void *gps_thread(void *);
+static void  fix_publish(struct gps_fix_t *);
+
+/********************************************************************
+ * Module globals
+ *
+ */
+static pthread_t    ingest_thread;
+static int          thread_running = 0;
+static int          fix_fd = -1;                    // signals queued fixes to the UI thread
+static int          stop_fd = -1;                   // signals the ingest thread to exit
+static struct uart_reader_t gps_uart;               // NMEA text line reader, used only by the ingest thread
+
+// Fix queue, the ingest thread only writes 'fix_tail' and the UI thread only writes 'fix_head'.
+// Indexes run freely and are masked on access, the queue is full when they are GPS_FIX_QUEUE apart.
+static struct gps_fix_t fix_queue[GPS_FIX_QUEUE];
+static atomic_uint  fix_head;
+static atomic_uint  fix_tail;
+static atomic_uint  fix_overruns;
+
+/********************************************************************
+ * gps_open()
+ *
+ *  Start the GPS ingest thread on an open UART.
+ *  The UART is read only by the thread until gps_close() is called.
+ *
+ *  param:  UART file descriptor
+ *  return: 0 if no error,
+ *         -1 if error creating the queue signals or the thread
+ *
+ */
+int gps_open(int uart_fd)
+{
+    if ( thread_running )
+        return -1;
+
+    uart_reader_init(&gps_uart, uart_fd);
+
+    atomic_store(&fix_head, 0);
+    atomic_store(&fix_tail, 0);
+    atomic_store(&fix_overruns, 0);
+
+    fix_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ( fix_fd == -1 || stop_fd == -1 )
+    {
+        gps_close();
+        return -1;
+    }
+
+    if ( pthread_create(&ingest_thread, NULL, gps_thread, NULL) != 0 )
+    {
+        gps_close();
+        return -1;
+    }
+
+    thread_running = 1;
+
+    return 0;
+}
+
+/********************************************************************
+ * gps_close()
+ *
+ *  Stop the GPS ingest thread and release the queue signals.
+ *  The UART is not closed.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+void gps_close(void)
+{
+    uint64_t    stop = 1;
+
+    if ( thread_running )
+    {
+        write(stop_fd, &stop, sizeof(stop));
+        pthread_join(ingest_thread, NULL);
+        thread_running = 0;
+    }
+
+    if ( fix_fd != -1 )
+        close(fix_fd);
+    if ( stop_fd != -1 )
+        close(stop_fd);
+
+    fix_fd = -1;
+    stop_fd = -1;
+}
+
+/********************************************************************
+ * gps_fix_fd()
+ *
+ *  File descriptor to poll() for queued fixes.
+ *  It stays readable until gps_read() finds the queue empty.
+ *
+ *  param:  none
+ *  return: file descriptor, -1 if the ingest thread is not running
+ *
+ */
+int gps_fix_fd(void)
+{
+    return fix_fd;
+}
+
+/********************************************************************
+ * gps_read()
+ *
+ *  Read the oldest queued fix without blocking.
+ *  Call until it returns '0' to handle every sentence, the
+ *  last fix read is then the newest position.
+ *  Called only by the UI thread.
+ *
+ *  param:  pointer to fix
+ *  return: 1 if a fix was read,
+ *          0 if the queue is empty
+ *
+ */
+int gps_read(struct gps_fix_t *fix)
+{
+    unsigned int    head, tail;
+    uint64_t        count;
+
+    head = atomic_load_explicit(&fix_head, memory_order_relaxed);
+    tail = atomic_load_explicit(&fix_tail, memory_order_acquire);
+
+    if ( head == tail )
+    {
+        // Clear the queue signal before checking again, so a fix that
+        // is published after the check leaves the signal readable
+        read(fix_fd, &count, sizeof(count));
+
+        tail = atomic_load_explicit(&fix_tail, memory_order_acquire);
+        if ( head == tail )
+            return 0;
+    }
+
+    memcpy(fix, &fix_queue[head & GPS_FIX_MASK], sizeof(struct gps_fix_t));
+    atomic_store_explicit(&fix_head, head + 1, memory_order_release);
+
+    return 1;
+}
+
+/********************************************************************
+ * gps_flush()
+ *
+ *  Discard the queued fixes, such as fixes that were queued
+ *  while no screen was reading them.
+ *  Called only by the UI thread.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+void gps_flush(void)
+{
+    uint64_t    count;
+
+    read(fix_fd, &count, sizeof(count));
+    atomic_store_explicit(&fix_head, atomic_load_explicit(&fix_tail, memory_order_acquire), memory_order_release);
+}
+
+/********************************************************************
+ * gps_overruns()
+ *
+ *  Count of fixes dropped because the queue was full since gps_open().
+ *
+ *  param:  none
+ *  return: dropped fix count
+ *
+ */
+unsigned int gps_overruns(void)
+{
+    return atomic_load_explicit(&fix_overruns, memory_order_relaxed);
+}
+
+/********************************************************************
+ * gps_thread()
+ *
+ *  GPS ingest thread.
+ *  Wait for UART text or the stop signal, and publish the position
+ *  after every NMEA sentence. The position accumulates GGA and RMC
+ *  data, as when sentences were parsed by the UI thread.
+ *
+ *  param:  none
+ *  return: NULL
+ *
+ */
+static void *gps_thread(void *arg)
+{
+    struct pollfd       poll_fds[2];
+    struct gps_fix_t    fix;
+    char   *nmea_line;
+    int     read_result;
+
+    memset(&fix, 0, sizeof(struct gps_fix_t));
+
+    poll_fds[0].fd = gps_uart.fd;
+    poll_fds[0].events = POLLIN;
+    poll_fds[1].fd = stop_fd;
+    poll_fds[1].events = POLLIN;
+
+    while ( 1 )
+    {
+        // A signal only interrupts the wait, any other error is
+        // reported and not repeated faster than the error wait
+        if ( poll(poll_fds, 2, -1) == -1 )
+        {
+            if ( errno == EINTR )
+                continue;
+
+            fix.status = GPS_READ_ERROR;
+            fix.error = errno;
+            fix_publish(&fix);
+
+            // The stop signal is checked here too, the error may not go away
+            if ( poll(&poll_fds[1], 1, GPS_ERROR_WAIT) > 0 )
+                break;
+
+            continue;
+        }
+
+        if ( poll_fds[1].revents & POLLIN )
+            break;
+
+        // A closed UART, such as the end of a replayed NMEA file, is not polled anymore
+        if ( (poll_fds[0].revents & (POLLIN | POLLHUP)) == POLLHUP )
+        {
+            poll_fds[0].fd = -1;
+            continue;
+        }
+
+        if ( poll_fds[0].revents == 0 )
+            continue;
+
+        // All buffered lines are handled, because poll()
+        // only reports text that was not read yet
+        do
+        {
+            read_result = uart_read_line(&gps_uart, &nmea_line, 0);
+
+            if ( read_result < 0 )
+            {
+                fix.status = GPS_READ_ERROR;
+                fix.error = errno;
+                fix_publish(&fix);
+
+                // Do not repeat a persistent error faster than the wait
+                poll(&poll_fds[1], 1, GPS_ERROR_WAIT);
+            }
+            else if ( read_result > 0 )
+            {
+                fix.status = nmea_update_pos(nmea_line, &fix.pos) ? GPS_FIX_VALID : GPS_FIX_INVALID;
+                fix.error = 0;
+                fix_publish(&fix);
+            }
+        }
+        while ( read_result > 0 );
+    }
+
+    return NULL;
+}
+
+/********************************************************************
+ * fix_publish()
+ *
+ *  Queue a fix and signal the UI thread.
+ *  The fix is dropped and counted if the queue is full.
+ *  Called only by the ingest thread.
+ *
+ *  param:  pointer to fix
+ *  return: none
+ *
+ */
+static void fix_publish(struct gps_fix_t *fix)
+{
+    unsigned int    head, tail;
+    uint64_t        count = 1;
+
+    tail = atomic_load_explicit(&fix_tail, memory_order_relaxed);
+    head = atomic_load_explicit(&fix_head, memory_order_acquire);
+
+    if ( (tail - head) == GPS_FIX_QUEUE )
+    {
+        atomic_fetch_add_explicit(&fix_overruns, 1, memory_order_relaxed);
+        return;
+    }
+
+    memcpy(&fix_queue[tail & GPS_FIX_MASK], fix, sizeof(struct gps_fix_t));
+    atomic_store_explicit(&fix_tail, tail + 1, memory_order_release);
+
+    write(fix_fd, &count, sizeof(count));
+}
@@ -0,0 +1,195 @@
+/********************************************************************
+ * hal_bcm2835.c
+ *
+ *  IO hardware abstraction layer backend using libbcm2835.
+ *  SPI and GPIO are accessed through the BCM2835 peripheral
+ *  registers, which requires root privileges.
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#include    <stdint.h>
+
+#include    <bcm2835.h>
+
+#include    "hal.h"
+#include    "util.h"
+#include    "config.h"
+
+/********************************************************************
+ * hal_init()
+ *
+ *  Initialize the bcm2835 library.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error initializing the library
+ *
+ */
+int hal_init(void)
+{
+    if ( !bcm2835_init() )
+        return -1;
+
+    return 0;
+}
+
+/********************************************************************
+ * hal_close()
+ *
+ *  Close the bcm2835 library.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+void hal_close(void)
+{
+    bcm2835_close();
+}
+
+/********************************************************************
+ * hal_delay()
+ *
+ *  Delay based on BCM2835 timer.
+ *
+ *  param:  delay in milliseconds
+ *  return: none
+ *
+ */
+void hal_delay(unsigned int milisec)
+{
+    bcm2835_delay(milisec);
+}
+
+/********************************************************************
+ * hal_lcd_open()
+ *
+ *  Setup the LCD SPI bus and the CMD/DATA and RST lines,
+ *  then reset the LCD.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error initializing SPI
+ *
+ */
+int hal_lcd_open(void)
+{
+    // Initialize RST GPIO pin
+    bcm2835_gpio_fsel(LCD_RST, BCM2835_GPIO_FSEL_OUTP);
+    bcm2835_gpio_write(LCD_RST, HIGH);
+
+    // Initialize SPI
+    if ( !bcm2835_spi_begin() )
+        return -1;
+
+    // Initialize SPI for the LCD according to wiring
+    bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
+    bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
+    bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_8);
+    bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
+    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
+
+    // Setup CMD/DATA GPIO line
+    bcm2835_gpio_fsel(LCD_DATA_CMD, BCM2835_GPIO_FSEL_OUTP);
+    bcm2835_gpio_write(LCD_DATA_CMD, HIGH);
+
+    // Reset the devices on the SPI bus
+    bcm2835_gpio_write(LCD_RST, LOW);
+    bcm2835_delay(250);
+    bcm2835_gpio_write(LCD_RST, HIGH);
+
+    return 0;
+}
+
+/********************************************************************
+ * hal_lcd_close()
+ *
+ *  Close the LCD SPI bus.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+void hal_lcd_close(void)
+{
+    bcm2835_spi_end();
+}
+
+/********************************************************************
+ * hal_lcd_dc()
+ *
+ *  Set the level of the LCD CMD/DATA line.
+ *
+ *  param:  HIGH for data or LOW for command
+ *  return: none
+ *
+ */
+void hal_lcd_dc(int level)
+{
+    bcm2835_gpio_write(LCD_DATA_CMD, level);
+}
+
+/********************************************************************
+ * hal_lcd_write()
+ *
+ *  Write bytes to the LCD.
+ *
+ *  param:  pointer to bytes, byte count
+ *  return: none
+ *
+ */
+void hal_lcd_write(const uint8_t *data, int len)
+{
+    if ( len == 1 )
+        bcm2835_spi_transfer(*data);
+    else
+        bcm2835_spi_writenb((const char *)data, len);
+}
+
+/********************************************************************
+ * hal_gpio_input()
+ *
+ *  Setup a GPIO line as an input with pull-up enabled.
+ *
+ *  param:  GPIO line
+ *  return: 0
+ *
+ */
+int hal_gpio_input(int pin)
+{
+    bcm2835_gpio_fsel(pin, BCM2835_GPIO_FSEL_INPT);
+    bcm2835_gpio_set_pud(pin, BCM2835_GPIO_PUD_UP);
+
+    return 0;
+}
+
+/********************************************************************
+ * hal_gpio_read()
+ *
+ *  Read the level of a GPIO line.
+ *
+ *  param:  GPIO line
+ *  return: HIGH or LOW
+ *
+ */
+int hal_gpio_read(int pin)
+{
+    return bcm2835_gpio_lev(pin);
+}
+
+/********************************************************************
+ * hal_uart_open()
+ *
+ *  Open the GPS UART.
+ *
+ *  param:  none
+ *  return: file descriptor,
+ *         -1 if error opening the UART
+ *
+ */
+int hal_uart_open(void)
+{
+    return uart_open(UART0);
+}
@@ -0,0 +1,750 @@
+/********************************************************************
+ * hal_sim.c
+ *
+ *  IO hardware abstraction layer backend that simulates the LCD,
+ *  push buttons and GPS, to run and profile the navigator on a
+ *  Linux PC. The simulation is setup with environment variables:
+ *
+ *  SIM_BUTTONS  push button script, lines of '<msec> <button>' with button
+ *               up, down, left, right or select, or '<msec> dump <file>' to
+ *               save the LCD content as a PPM image. times are from hal_init()
+ *  SIM_GPS      NMEA text file replayed in a loop at SIM_GPS_BAUD
+ *               (default 9600, 0 for no pacing), or a serial device or pty
+ *  SIM_PPM      PPM image file that the LCD content is saved to by hal_close()
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#define     _GNU_SOURCE
+
+#include    <stdlib.h>
+#include    <stdio.h>
+#include    <string.h>
+#include    <stdint.h>
+#include    <signal.h>
+#include    <fcntl.h>
+#include    <unistd.h>
+#include    <time.h>
+#include    <pthread.h>
+#include    <sys/stat.h>
+
+#include    "hal.h"
+#include    "pilcd.h"
+#include    "util.h"
+#include    "config.h"
+
+/********************************************************************
+ * Module definitions
+ *
+ */
+#define     SIM_CASET           0x2A        // decoded ST7735 commands
+#define     SIM_RASET           0x2B
+#define     SIM_RAMWR           0x2C
+#define     SIM_VSCRDEF         0x33
+#define     SIM_MADCTL          0x36
+#define     SIM_VSCSAD          0x37
+#define     SIM_COLMOD          0x3A
+#define     SIM_COLMOD_12BIT    0x03        // interface pixel formats
+#define     SIM_COLMOD_16BIT    0x05
+#define     SIM_MADCTL_MY       0x80        // row address order
+#define     SIM_MADCTL_MX       0x40        // column address order
+#define     SIM_MADCTL_MV       0x20        // row/column exchange, landscape orientation
+
+#define     SIM_LCD_COLUMNS     ST7735_TFTWIDTH     // LCD RAM in panel coordinates, the rows
+#define     SIM_LCD_ROWS        ST7735_TFTHEIGHT    //  are the panel's gate lines
+#define     SIM_LCD_GATES       162                 // gate lines of the LCD RAM, two are past the panel
+#define     SIM_PRESS_READS     2           // a button press reads LOW for the de-bounce read pair
+#define     SIM_PRESS_HOLD      150         //  or until this many mSec from the first read
+#define     SIM_LINE_LEN        256
+#define     SIM_GPS_BAUD        9600
+
+/********************************************************************
+ * Type definitions
+ *
+ */
+struct sim_event_t
+{
+    long    time;                           // mSec from hal_init()
+    int     pin;                            // button GPIO line, -1 for a dump
+    char    file[SIM_LINE_LEN];             // dump file name
+};
+
+/********************************************************************
+ * Static functions
+ *
+ */
+static long sim_time(void);
+static int  sim_script_load(const char *);
+static void sim_events_run(void);
+static int  sim_save_ppm(const char *);
+static void sim_lcd_byte(uint8_t);
+static int  sim_lcd_ram(int, int);
+static int  sim_lcd_line(int);
+static void *sim_gps_feed(void *);
+
+/********************************************************************
+ * Module globals
+ *
+ */
+static struct timespec  start_time;
+
+// push button script
+static struct sim_event_t *events = NULL;
+static int      event_count = 0;
+static int      event_next = 0;
+static int      pressed_pin = -1;           // pressed button line, -1 if none
+static int      pressed_reads = 0;
+static long     pressed_time = 0;
+
+// LCD controller state and RAM, written by the display thread
+static pthread_mutex_t  lcd_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint16_t lcd_ram[SIM_LCD_COLUMNS * SIM_LCD_GATES];
+static int      lcd_dc = HIGH;
+static int      lcd_cmd = 0;
+static int      lcd_argn = 0;
+static int      lcd_madctl = 0;
+static int      lcd_tfa = 0;                // vertical scroll definition and start address
+static int      lcd_vsa = SIM_LCD_GATES;
+static int      lcd_bfa = 0;
+static int      lcd_ssa = 0;
+static int      lcd_arg = 0;                // 16-bit command argument being decoded
+static int      x_start, x_end, y_start, y_end, x_loc, y_loc;
+static int      pixel_bits = 16;            // interface pixel format, 16 or 12 bits per pixel
+static uint32_t pixel_acc = 0;              // pixel data bits received, not yet written
+static int      pixel_acc_bits = 0;
+static long     lcd_bytes = 0;
+static long     lcd_windows = 0;
+
+// GPS replay
+static FILE    *gps_file = NULL;
+static int      gps_fd = -1;                // write end of the GPS pipe
+static int      gps_baud = SIM_GPS_BAUD;
+
+/********************************************************************
+ * hal_init()
+ *
+ *  Start the simulation clock and load the push button script.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if the push button script cannot be read
+ *
+ */
+int hal_init(void)
+{
+    const char *script;
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    script = getenv("SIM_BUTTONS");
+    if ( script && sim_script_load(script) == -1 )
+    {
+        printf("  sim: cannot read button script %s\n", script);
+        return -1;
+    }
+
+    return 0;
+}
+
+/********************************************************************
+ * hal_close()
+ *
+ *  Save the LCD content if requested, print LCD bus statistics
+ *  and release the push button script.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+void hal_close(void)
+{
+    const char *ppm;
+
+    ppm = getenv("SIM_PPM");
+    if ( ppm && sim_save_ppm(ppm) == -1 )
+        printf("  sim: cannot write %s\n", ppm);
+
+    printf("  sim: %ld LCD bytes, %ld address windows\n", lcd_bytes, lcd_windows);
+
+    free(events);
+    events = NULL;
+    event_count = 0;
+    event_next = 0;
+    pressed_pin = -1;
+}
+
+/********************************************************************
+ * hal_delay()
+ *
+ *  Delay by sleeping.
+ *
+ *  param:  delay in milliseconds
+ *  return: none
+ *
+ */
+void hal_delay(unsigned int milisec)
+{
+    usleep(milisec * 1000);
+}
+
+/********************************************************************
+ * hal_lcd_open()
+ *
+ *  Reset the simulated LCD controller.
+ *
+ *  param:  none
+ *  return: 0
+ *
+ */
+int hal_lcd_open(void)
+{
+    pthread_mutex_lock(&lcd_lock);
+    memset(lcd_ram, 0, sizeof(lcd_ram));
+    lcd_dc = HIGH;
+    lcd_cmd = 0;
+    lcd_madctl = 0;
+    lcd_tfa = 0;
+    lcd_vsa = SIM_LCD_GATES;
+    lcd_bfa = 0;
+    lcd_ssa = 0;
+    pixel_bits = 16;
+    pixel_acc = 0;
+    pixel_acc_bits = 0;
+    pthread_mutex_unlock(&lcd_lock);
+
+    return 0;
+}
+
+/********************************************************************
+ * hal_lcd_close()
+ *
+ *  Nothing to close for the simulated LCD.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+void hal_lcd_close(void)
+{
+}
+
+/********************************************************************
+ * hal_lcd_dc()
+ *
+ *  Set the level of the simulated LCD CMD/DATA line.
+ *
+ *  param:  HIGH for data or LOW for command
+ *  return: none
+ *
+ */
+void hal_lcd_dc(int level)
+{
+    pthread_mutex_lock(&lcd_lock);
+    lcd_dc = level;
+    pthread_mutex_unlock(&lcd_lock);
+}
+
+/********************************************************************
+ * hal_lcd_write()
+ *
+ *  Write bytes to the simulated LCD controller.
+ *
+ *  param:  pointer to bytes, byte count
+ *  return: none
+ *
+ */
+void hal_lcd_write(const uint8_t *data, int len)
+{
+    int     i;
+
+    pthread_mutex_lock(&lcd_lock);
+    for ( i = 0; i < len; i++ )
+        sim_lcd_byte(data[i]);
+    lcd_bytes += len;
+    pthread_mutex_unlock(&lcd_lock);
+}
+
+/********************************************************************
+ * hal_gpio_input()
+ *
+ *  Simulated GPIO lines need no setup.
+ *
+ *  param:  GPIO line
+ *  return: 0
+ *
+ */
+int hal_gpio_input(int pin)
+{
+    return 0;
+}
+
+/********************************************************************
+ * hal_gpio_read()
+ *
+ *  Read a simulated push button line.
+ *  A scripted press reads LOW for the push_button_read() de-bounce
+ *  read pair, so every scripted press is read as exactly one press.
+ *
+ *  param:  GPIO line
+ *  return: HIGH or LOW
+ *
+ */
+int hal_gpio_read(int pin)
+{
+    long    now;
+
+    sim_events_run();
+
+    if ( pin != pressed_pin )
+        return HIGH;
+
+    now = sim_time();
+    if ( pressed_reads == 0 )
+        pressed_time = now;
+
+    if ( pressed_reads == SIM_PRESS_READS || (now - pressed_time) > SIM_PRESS_HOLD )
+    {
+        pressed_pin = -1;
+        return HIGH;
+    }
+
+    pressed_reads++;
+
+    return LOW;
+}
+
+/********************************************************************
+ * hal_uart_open()
+ *
+ *  Open the simulated GPS. A text file is replayed through a pipe
+ *  by a feeder thread, any other file is opened as a serial port.
+ *  Without SIM_GPS the returned pipe never has data.
+ *
+ *  param:  none
+ *  return: file descriptor,
+ *         -1 if error opening the GPS source
+ *
+ */
+int hal_uart_open(void)
+{
+    const char *gps;
+    const char *baud;
+    struct stat gps_stat;
+    pthread_t   gps_thread;
+    int         pipe_fd[2];
+
+    gps = getenv("SIM_GPS");
+    if ( gps && stat(gps, &gps_stat) == -1 )
+        return -1;
+
+    if ( gps && !S_ISREG(gps_stat.st_mode) )
+        return uart_open(gps);
+
+    if ( pipe2(pipe_fd, O_CLOEXEC) == -1 )
+        return -1;
+    fcntl(pipe_fd[0], F_SETFL, O_NONBLOCK);
+
+    // no GPS, keep the write end open so the pipe stays empty
+    gps_fd = pipe_fd[1];
+    if ( gps == NULL )
+        return pipe_fd[0];
+
+    gps_file = fopen(gps, "r");
+    if ( gps_file == NULL )
+    {
+        close(pipe_fd[0]);
+        close(pipe_fd[1]);
+        return -1;
+    }
+
+    baud = getenv("SIM_GPS_BAUD");
+    gps_baud = baud ? atoi(baud) : SIM_GPS_BAUD;
+
+    // the feeder stops when the reader closes the pipe
+    signal(SIGPIPE, SIG_IGN);
+    if ( pthread_create(&gps_thread, NULL, sim_gps_feed, NULL) != 0 )
+    {
+        fclose(gps_file);
+        close(pipe_fd[0]);
+        close(pipe_fd[1]);
+        return -1;
+    }
+    pthread_detach(gps_thread);
+
+    return pipe_fd[0];
+}
+
+/********************************************************************
+ * sim_time()
+ *
+ *  Simulation time.
+ *
+ *  param:  none
+ *  return: mSec since hal_init()
+ *
+ */
+static long sim_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((now.tv_sec - start_time.tv_sec) * 1000L) + ((now.tv_nsec - start_time.tv_nsec) / 1000000L);
+}
+
+/********************************************************************
+ * sim_script_load()
+ *
+ *  Load the push button script, '#' starts a comment line.
+ *
+ *  param:  script file name
+ *  return: 0 if no error,
+ *         -1 if the file cannot be read
+ *
+ */
+static int sim_script_load(const char *file_name)
+{
+    static const struct
+    {
+        const char *name;
+        int         pin;
+    } buttons[] = {{"up", PBUTTON_UP}, {"down", PBUTTON_DOWN}, {"left", PBUTTON_LEFT},
+                   {"right", PBUTTON_RIGHT}, {"select", PBUTTON_SELECT}, {"dump", -1}};
+
+    FILE       *script;
+    char        line[SIM_LINE_LEN];
+    char        action[SIM_LINE_LEN];
+    struct sim_event_t  event, *grown;
+    int         i, fields;
+
+    script = fopen(file_name, "r");
+    if ( script == NULL )
+        return -1;
+
+    while ( fgets(line, sizeof(line), script) )
+    {
+        memset(&event, 0, sizeof(event));
+        fields = sscanf(line, "%ld %255s %255s", &event.time, action, event.file);
+        if ( fields < 2 || line[0] == '#' )
+            continue;
+
+        for ( i = 0; i < (int)(sizeof(buttons) / sizeof(buttons[0])); i++ )
+        {
+            if ( strcmp(action, buttons[i].name) == 0 )
+                break;
+        }
+
+        if ( i == (int)(sizeof(buttons) / sizeof(buttons[0])) || (buttons[i].pin == -1 && fields < 3) )
+        {
+            printf("  sim: ignoring script line: %s", line);
+            continue;
+        }
+
+        event.pin = buttons[i].pin;
+
+        grown = realloc(events, (event_count + 1) * sizeof(struct sim_event_t));
+        if ( grown == NULL )
+            break;
+        events = grown;
+        events[event_count++] = event;
+    }
+
+    fclose(script);
+
+    return 0;
+}
+
+/********************************************************************
+ * sim_events_run()
+ *
+ *  Run the script events that are due. Dumps run right away,
+ *  a button press waits for the previous press to be released.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+static void sim_events_run(void)
+{
+    long    now;
+
+    now = sim_time();
+
+    while ( event_next < event_count && events[event_next].time <= now )
+    {
+        if ( events[event_next].pin == -1 )
+        {
+            if ( sim_save_ppm(events[event_next].file) == -1 )
+                printf("  sim: cannot write %s\n", events[event_next].file);
+        }
+        else if ( pressed_pin == -1 )
+        {
+            pressed_pin = events[event_next].pin;
+            pressed_reads = 0;
+        }
+        else
+        {
+            break;
+        }
+
+        event_next++;
+    }
+}
+
+/********************************************************************
+ * sim_save_ppm()
+ *
+ *  Save the LCD content as a binary PPM image.
+ *
+ *  param:  image file name
+ *  return: 0 if no error,
+ *         -1 if the file cannot be written
+ *
+ */
+static int sim_save_ppm(const char *file_name)
+{
+    FILE       *ppm;
+    uint8_t     rgb[3];
+    uint16_t    pixel;
+    int         width, height, x, y, ram;
+
+    ppm = fopen(file_name, "wb");
+    if ( ppm == NULL )
+        return -1;
+
+    pthread_mutex_lock(&lcd_lock);
+
+    width = (lcd_madctl & SIM_MADCTL_MV) ? ST7735_TFTHEIGHT : ST7735_TFTWIDTH;
+    height = (lcd_madctl & SIM_MADCTL_MV) ? ST7735_TFTWIDTH : ST7735_TFTHEIGHT;
+
+    fprintf(ppm, "P6\n%d %d\n255\n", width, height);
+    for ( y = 0; y < height; y++ )
+    {
+        for ( x = 0; x < width; x++ )
+        {
+            // screen pixel of the address, on the RAM row shown by its screen line
+            ram = sim_lcd_ram(x, y);
+            pixel = lcd_ram[(sim_lcd_line(ram / SIM_LCD_COLUMNS) * SIM_LCD_COLUMNS) + (ram % SIM_LCD_COLUMNS)];
+            rgb[0] = (uint8_t) ((((pixel >> 11) & 0x1f) * 255) / 31);
+            rgb[1] = (uint8_t) ((((pixel >> 5) & 0x3f) * 255) / 63);
+            rgb[2] = (uint8_t) (((pixel & 0x1f) * 255) / 31);
+            fwrite(rgb, 1, sizeof(rgb), ppm);
+        }
+    }
+
+    pthread_mutex_unlock(&lcd_lock);
+
+    fclose(ppm);
+
+    return 0;
+}
+
+/********************************************************************
+ * sim_lcd_byte()
+ *
+ *  Decode one byte sent to the LCD controller. Only the address
+ *  window, memory write, pixel format, orientation and scroll
+ *  commands are simulated.
+ *  Must be called with the LCD lock held.
+ *
+ *  param:  byte
+ *  return: none
+ *
+ */
+static void sim_lcd_byte(uint8_t byte)
+{
+    int         ram;
+    uint32_t    pixel;
+
+    if ( lcd_dc == LOW )
+    {
+        lcd_cmd = byte;
+        lcd_argn = 0;
+        lcd_arg = 0;
+        if ( lcd_cmd == SIM_RAMWR )
+        {
+            x_loc = x_start;
+            y_loc = y_start;
+            pixel_acc = 0;
+            pixel_acc_bits = 0;
+            lcd_windows++;
+        }
+        return;
+    }
+
+    switch ( lcd_cmd )
+    {
+        case SIM_CASET:
+            if ( lcd_argn == 1 )
+                x_start = byte;
+            else if ( lcd_argn == 3 )
+                x_end = byte;
+            break;
+
+        case SIM_RASET:
+            if ( lcd_argn == 1 )
+                y_start = byte;
+            else if ( lcd_argn == 3 )
+                y_end = byte;
+            break;
+
+        case SIM_MADCTL:
+            lcd_madctl = byte;
+            break;
+
+        case SIM_VSCRDEF:
+            lcd_arg = (lcd_arg << 8) | byte;
+            if ( lcd_argn == 1 )
+                lcd_tfa = lcd_arg & 0xffff;
+            else if ( lcd_argn == 3 )
+                lcd_vsa = lcd_arg & 0xffff;
+            else if ( lcd_argn == 5 )
+                lcd_bfa = lcd_arg & 0xffff;
+            break;
+
+        case SIM_VSCSAD:
+            lcd_arg = (lcd_arg << 8) | byte;
+            if ( lcd_argn == 1 )
+                lcd_ssa = lcd_arg & 0xffff;
+            break;
+
+        case SIM_COLMOD:
+            if ( (byte & 0x07) == SIM_COLMOD_12BIT )
+                pixel_bits = 12;
+            else if ( (byte & 0x07) == SIM_COLMOD_16BIT )
+                pixel_bits = 16;
+            break;
+
+        case SIM_RAMWR:
+            pixel_acc = (pixel_acc << 8) | byte;
+            pixel_acc_bits += 8;
+            if ( pixel_acc_bits < pixel_bits )
+                break;
+
+            // RAM keeps RGB565, RGB444 is expanded by repeating the high bits
+            pixel_acc_bits -= pixel_bits;
+            pixel = (pixel_acc >> pixel_acc_bits) & ((1 << pixel_bits) - 1);
+            if ( pixel_bits == 12 )
+                pixel = ((pixel & 0xf00) << 4) | (pixel & 0x800) |
+                        ((pixel & 0x0f0) << 3) | ((pixel & 0x0c0) >> 1) |
+                        ((pixel & 0x00f) << 1) | ((pixel & 0x008) >> 3);
+
+            ram = sim_lcd_ram(x_loc, y_loc);
+            if ( ram != -1 )
+                lcd_ram[ram] = (uint16_t) pixel;
+
+            x_loc++;
+            if ( x_loc > x_end )
+            {
+                x_loc = x_start;
+                y_loc++;
+                if ( y_loc > y_end )
+                    y_loc = y_start;
+            }
+            break;
+
+        default:;
+    }
+
+    lcd_argn++;
+}
+
+/********************************************************************
+ * sim_lcd_ram()
+ *
+ *  Map a column and row address to the LCD RAM in panel coordinates
+ *  with the memory access control of the orientation command.
+ *  Row/column exchange is applied first, then the mirroring of the
+ *  panel row and column addresses.
+ *
+ *  param:  column and row address
+ *  return: LCD RAM index,
+ *         -1 if the address is outside of the LCD RAM
+ *
+ */
+static int sim_lcd_ram(int x, int y)
+{
+    int     row, column;
+
+    row = (lcd_madctl & SIM_MADCTL_MV) ? x : y;
+    column = (lcd_madctl & SIM_MADCTL_MV) ? y : x;
+
+    if ( row < 0 || row >= SIM_LCD_ROWS || column < 0 || column >= SIM_LCD_COLUMNS )
+        return -1;
+
+    if ( lcd_madctl & SIM_MADCTL_MY )
+        row = SIM_LCD_ROWS - 1 - row;
+    if ( lcd_madctl & SIM_MADCTL_MX )
+        column = SIM_LCD_COLUMNS - 1 - column;
+
+    return (row * SIM_LCD_COLUMNS) + column;
+}
+
+/********************************************************************
+ * sim_lcd_line()
+ *
+ *  The LCD RAM row shown on a screen line. Lines of the scroll area
+ *  start at the scroll start address and wrap around within the area,
+ *  the fixed top and bottom lines always show their own rows.
+ *  A scroll definition that does not cover all gate lines is undefined
+ *  on the LCD, and the screen is shown as if it did not scroll.
+ *
+ *  param:  screen line
+ *  return: LCD RAM row
+ *
+ */
+static int sim_lcd_line(int line)
+{
+    if ( (lcd_tfa + lcd_vsa + lcd_bfa) != SIM_LCD_GATES )
+        return line;
+
+    if ( line < lcd_tfa || line >= (lcd_tfa + lcd_vsa) || lcd_vsa <= 0 )
+        return line;
+
+    return lcd_tfa + ((((line - lcd_tfa) + (lcd_ssa - lcd_tfa)) % lcd_vsa) + lcd_vsa) % lcd_vsa;
+}
+
+/********************************************************************
+ * sim_gps_feed()
+ *
+ *  GPS feeder thread, writes the NMEA file lines into the GPS
+ *  pipe at the simulated baud rate and restarts at end of file.
+ *
+ *  param:  none
+ *  return: NULL
+ *
+ */
+static void *sim_gps_feed(void *arg)
+{
+    char    line[SIM_LINE_LEN];
+    size_t  len;
+    int     lines = 0;
+
+    while ( 1 )
+    {
+        if ( fgets(line, sizeof(line), gps_file) == NULL )
+        {
+            // restart the replay, unless the file has no lines
+            if ( lines == 0 )
+                break;
+            rewind(gps_file);
+            lines = 0;
+            continue;
+        }
+
+        lines++;
+        len = strlen(line);
+        if ( write(gps_fd, line, len) != (ssize_t) len )
+            break;
+
+        // 10 bits per character
+        if ( gps_baud > 0 )
+            usleep((len * 10 * 1000000L) / gps_baud);
+    }
+
+    fclose(gps_file);
+    close(gps_fd);
+
+    return NULL;
+}
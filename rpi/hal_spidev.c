@@ -0,0 +1,347 @@
+/********************************************************************
+ * hal_spidev.c
+ *
+ *  IO hardware abstraction layer backend using the kernel
+ *  SPI driver and the GPIO character device.
+ *  Large SPI transfers are done with DMA by the driver, and no
+ *  root privileges are needed. SPI must be enabled in raspi-config,
+ *  and the GPIO pull-up bias requires Linux 5.5 or later.
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#include    <stdio.h>
+#include    <string.h>
+#include    <stdint.h>
+#include    <fcntl.h>
+#include    <unistd.h>
+#include    <sys/ioctl.h>
+#include    <linux/spi/spidev.h>
+#include    <linux/gpio.h>
+
+#include    "hal.h"
+#include    "util.h"
+#include    "config.h"
+
+/********************************************************************
+ * Module definitions
+ *
+ */
+#define     SPIDEV_BUFSIZ       "/sys/module/spidev/parameters/bufsiz"
+#define     SPIDEV_BUFSIZ_DFLT  4096    // spidev default for the largest transfer
+#define     GPIO_LINES          54      // BCM GPIO lines on gpiochip0
+
+/********************************************************************
+ * Static functions
+ *
+ */
+static int  gpio_line_open(int, uint32_t, int);
+static void gpio_line_set(int, int);
+
+/********************************************************************
+ * Module globals
+ *
+ */
+static int  chip_fd = -1;                           // GPIO chip
+static int  spi_fd = -1;                            // SPI device
+static int  dc_fd = -1;                             // GPIO line handles for LCD CMD/DATA and RST
+static int  rst_fd = -1;
+static int  spi_max_transfer = SPIDEV_BUFSIZ_DFLT;  // spidev transfer size limit
+static int  line_fd[GPIO_LINES];                    // GPIO input line handles, 0 if not setup
+
+/********************************************************************
+ * hal_init()
+ *
+ *  Open the GPIO chip.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error opening the GPIO chip
+ *
+ */
+int hal_init(void)
+{
+    memset(line_fd, 0, sizeof(line_fd));
+
+    chip_fd = open(LCD_GPIO_CHIP, O_RDWR | O_CLOEXEC);
+    if ( chip_fd == -1 )
+        return -1;
+
+    return 0;
+}
+
+/********************************************************************
+ * hal_close()
+ *
+ *  Release the GPIO input lines and close the GPIO chip.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+void hal_close(void)
+{
+    int     i;
+
+    for ( i = 0; i < GPIO_LINES; i++ )
+    {
+        if ( line_fd[i] > 0 )
+            close(line_fd[i]);
+        line_fd[i] = 0;
+    }
+
+    if ( chip_fd != -1 )
+        close(chip_fd);
+    chip_fd = -1;
+}
+
+/********************************************************************
+ * hal_delay()
+ *
+ *  Delay by sleeping.
+ *
+ *  param:  delay in milliseconds
+ *  return: none
+ *
+ */
+void hal_delay(unsigned int milisec)
+{
+    usleep(milisec * 1000);
+}
+
+/********************************************************************
+ * hal_lcd_open()
+ *
+ *  Open the LCD SPI device and the CMD/DATA and RST lines,
+ *  then reset the LCD.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error opening or setting up the devices
+ *
+ */
+int hal_lcd_open(void)
+{
+    uint8_t     mode = SPI_MODE_0;
+    uint8_t     bits = 8;
+    uint32_t    speed = LCD_SPI_CLOCK;
+    FILE       *bufsiz;
+
+    spi_fd = open(LCD_SPI_DEVICE, O_RDWR | O_CLOEXEC);
+    if ( spi_fd == -1 )
+        return -1;
+
+    if ( ioctl(spi_fd, SPI_IOC_WR_MODE, &mode) == -1 ||
+         ioctl(spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) == -1 ||
+         ioctl(spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) == -1 )
+    {
+        hal_lcd_close();
+        return -1;
+    }
+
+    // spidev rejects transfers larger than its 'bufsiz' module parameter
+    bufsiz = fopen(SPIDEV_BUFSIZ, "r");
+    if ( bufsiz )
+    {
+        if ( fscanf(bufsiz, "%d", &spi_max_transfer) != 1 || spi_max_transfer <= 0 )
+            spi_max_transfer = SPIDEV_BUFSIZ_DFLT;
+        fclose(bufsiz);
+    }
+
+    dc_fd = gpio_line_open(LCD_DATA_CMD, GPIOHANDLE_REQUEST_OUTPUT, HIGH);
+    rst_fd = gpio_line_open(LCD_RST, GPIOHANDLE_REQUEST_OUTPUT, HIGH);
+    if ( dc_fd == -1 || rst_fd == -1 )
+    {
+        hal_lcd_close();
+        return -1;
+    }
+
+    // Reset the devices on the SPI bus
+    gpio_line_set(rst_fd, LOW);
+    hal_delay(250);
+    gpio_line_set(rst_fd, HIGH);
+
+    return 0;
+}
+
+/********************************************************************
+ * hal_lcd_close()
+ *
+ *  Close the LCD SPI device and release the CMD/DATA and RST lines.
+ *
+ *  param:  none
+ *  return: none
+ *
+ */
+void hal_lcd_close(void)
+{
+    if ( spi_fd != -1 )
+        close(spi_fd);
+    if ( dc_fd != -1 )
+        close(dc_fd);
+    if ( rst_fd != -1 )
+        close(rst_fd);
+
+    spi_fd = -1;
+    dc_fd = -1;
+    rst_fd = -1;
+}
+
+/********************************************************************
+ * hal_lcd_dc()
+ *
+ *  Set the level of the LCD CMD/DATA line.
+ *
+ *  param:  HIGH for data or LOW for command
+ *  return: none
+ *
+ */
+void hal_lcd_dc(int level)
+{
+    gpio_line_set(dc_fd, level);
+}
+
+/********************************************************************
+ * hal_lcd_write()
+ *
+ *  Write bytes to the LCD with the kernel SPI driver.
+ *  Writes are split into the largest transfers spidev accepts.
+ *
+ *  param:  pointer to bytes, byte count
+ *  return: none
+ *
+ */
+void hal_lcd_write(const uint8_t *data, int len)
+{
+    struct spi_ioc_transfer xfer;
+    int     chunk;
+
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.speed_hz = LCD_SPI_CLOCK;
+    xfer.bits_per_word = 8;
+
+    while ( len > 0 )
+    {
+        chunk = (len > spi_max_transfer) ? spi_max_transfer : len;
+
+        xfer.tx_buf = (unsigned long) data;
+        xfer.len = chunk;
+        if ( ioctl(spi_fd, SPI_IOC_MESSAGE(1), &xfer) == -1 )
+            return;
+
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/********************************************************************
+ * hal_gpio_input()
+ *
+ *  Setup a GPIO line as an input with pull-up enabled.
+ *
+ *  param:  GPIO line
+ *  return: 0 if no error,
+ *         -1 if the line could not be requested
+ *
+ */
+int hal_gpio_input(int pin)
+{
+    if ( pin < 0 || pin >= GPIO_LINES )
+        return -1;
+
+    if ( line_fd[pin] > 0 )
+        return 0;
+
+    line_fd[pin] = gpio_line_open(pin, GPIOHANDLE_REQUEST_INPUT | GPIOHANDLE_REQUEST_BIAS_PULL_UP, 0);
+    if ( line_fd[pin] == -1 )
+    {
+        line_fd[pin] = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+/********************************************************************
+ * hal_gpio_read()
+ *
+ *  Read the level of a GPIO line.
+ *
+ *  param:  GPIO line
+ *  return: HIGH or LOW, HIGH if the line is not setup
+ *
+ */
+int hal_gpio_read(int pin)
+{
+    struct gpiohandle_data  data;
+
+    if ( pin < 0 || pin >= GPIO_LINES || line_fd[pin] <= 0 )
+        return HIGH;
+
+    memset(&data, 0, sizeof(data));
+    if ( ioctl(line_fd[pin], GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) == -1 )
+        return HIGH;
+
+    return data.values[0] ? HIGH : LOW;
+}
+
+/********************************************************************
+ * hal_uart_open()
+ *
+ *  Open the GPS UART.
+ *
+ *  param:  none
+ *  return: file descriptor,
+ *         -1 if error opening the UART
+ *
+ */
+int hal_uart_open(void)
+{
+    return uart_open(UART0);
+}
+
+/********************************************************************
+ * gpio_line_open()
+ *
+ *  Request a GPIO line from the GPIO chip.
+ *
+ *  param:  line offset on the chip, request flags, initial output level
+ *  return: line handle file descriptor,
+ *         -1 if the request failed
+ *
+ */
+static int gpio_line_open(int line, uint32_t flags, int value)
+{
+    struct gpiohandle_request   req;
+
+    memset(&req, 0, sizeof(req));
+    req.lineoffsets[0] = line;
+    req.lines = 1;
+    req.flags = flags;
+    req.default_values[0] = value;
+    strncpy(req.consumer_label, "navigator", sizeof(req.consumer_label) - 1);
+
+    if ( ioctl(chip_fd, GPIO_GET_LINEHANDLE_IOCTL, &req) == -1 )
+        return -1;
+
+    return req.fd;
+}
+
+/********************************************************************
+ * gpio_line_set()
+ *
+ *  Set the level of an output GPIO line.
+ *
+ *  param:  line handle, level
+ *  return: none
+ *
+ */
+static void gpio_line_set(int fd, int value)
+{
+    struct gpiohandle_data  data;
+
+    memset(&data, 0, sizeof(data));
+    data.values[0] = value;
+    ioctl(fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data);
+}
@@ -29,4 +29,27 @@
 
 #define     UART0           "/dev/ttyAMA0"      // 9600, 8N1
 
+/********************************************************************
+ * LCD SPI bus of the 'spidev' IO backend (make HAL=spidev)
+ * that replaces libbcm2835 with the kernel SPI driver and
+ * the GPIO character device.
+ * The kernel rounds the SPI clock down to a core clock divisor.
+ *
+ */
+#define     LCD_SPI_DEVICE  "/dev/spidev0.0"    // SPI0, CS0
+#define     LCD_SPI_CLOCK   40000000            // SPI clock [Hz]
+#define     LCD_GPIO_CHIP   "/dev/gpiochip0"    // BCM GPIO lines for LCD_DATA_CMD and LCD_RST
+
+/********************************************************************
+ * Display frame rate
+ *
+ */
+#define     FRAME_RATE      15                  // frames per second (10, 15 or 30), frames are only pushed when the screen changed
+
+/********************************************************************
+ * File system locations
+ *
+ */
+#define     USB_DIR         "/home/pi/usb"      // USB thumb drive mount point with maps
+
 #endif  /* __config_h__ */
@@ -0,0 +1,51 @@
+/********************************************************************
+ * gps.h
+ *
+ *  Header file for the GPS ingest thread module gps.c
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#ifndef __gps_h__
+#define __gps_h__
+
+#include    "util.h"
+
+/********************************************************************
+ * Definitions
+ *
+ */
+
+// Fix queue entries, must be a power of 2.
+// Holds about 10sec of NMEA sentences at six sentences per second.
+#define     GPS_FIX_QUEUE       64
+
+// Fix status
+#define     GPS_FIX_INVALID     0               // sentence was not a valid GGA or RMC fix
+#define     GPS_FIX_VALID       1               // sentence updated the position
+#define     GPS_READ_ERROR      2               // error reading or polling the UART
+
+/********************************************************************
+ * Type definitions
+ *
+ */
+struct gps_fix_t                                // Position after one NMEA sentence
+{
+    int     status;                             // GPS_FIX_VALID, GPS_FIX_INVALID or GPS_READ_ERROR
+    int     error;                              // errno of a UART read or poll error
+    struct position_t pos;                      // complete position snapshot
+};
+
+/********************************************************************
+ * Function prototypes
+ *
+ */
+int   gps_open(int);                            // start the ingest thread on a UART, return -1 if failed
+void  gps_close(void);                          // stop the ingest thread
+int   gps_fix_fd(void);                         // file descriptor that poll() reports readable when fixes are queued
+int   gps_read(struct gps_fix_t *);             // read the oldest queued fix without blocking, return 0 if none
+void  gps_flush(void);                          // discard queued fixes
+unsigned int gps_overruns(void);                // fixes dropped because the queue was full
+
+#endif  /* __gps_h__ */
@@ -0,0 +1,45 @@
+/********************************************************************
+ * hal.h
+ *
+ *  Header file for the IO hardware abstraction layer.
+ *  The LCD SPI bus, GPIO lines, delays and the GPS UART are
+ *  accessed through these functions. One backend is linked
+ *  into the application, selected with 'make HAL=<backend>':
+ *
+ *    hal_bcm2835.c   libbcm2835 SPI and GPIO register access
+ *    hal_spidev.c    kernel SPI driver and GPIO character device
+ *    hal_sim.c       simulated LCD, push buttons and GPS
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#ifndef __hal_h__
+#define __hal_h__
+
+#include    <stdint.h>
+
+/********************************************************************
+ * Function prototypes
+ *
+ */
+
+// IO subsystem
+int   hal_init(void);                           // initialize the IO subsystem, return -1 if failed
+void  hal_close(void);                          // release the IO subsystem
+void  hal_delay(unsigned int);                  // delay in milliseconds
+
+// LCD SPI bus
+int   hal_lcd_open(void);                       // open the SPI bus, setup CMD/DATA and RST lines and reset the LCD, return -1 if failed
+void  hal_lcd_close(void);                      // close the SPI bus
+void  hal_lcd_dc(int);                          // set CMD/DATA line level
+void  hal_lcd_write(const uint8_t *, int);      // write bytes to the LCD
+
+// GPIO lines
+int   hal_gpio_input(int);                      // setup a GPIO line as an input with pull-up, return -1 if failed
+int   hal_gpio_read(int);                       // read GPIO line level, HIGH or LOW
+
+// GPS UART
+int   hal_uart_open(void);                      // open the GPS UART for non-blocking reads, return file descriptor or -1
+
+#endif  /* __hal_h__ */
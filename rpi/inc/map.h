@@ -0,0 +1,95 @@
+/********************************************************************
+ * map.h
+ *
+ *  Header file for map image loading and rendering module map.c
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#ifndef __map_h__
+#define __map_h__
+
+#include    <stdint.h>
+#include    <stddef.h>
+
+#include    "util.h"
+
+/********************************************************************
+ * Definitions
+ *
+ */
+
+// Build time selection of the vectorized map patch kernel
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define     MAP_SIMD_NEON       1
+#define     MAP_SIMD_SSE2       0
+#define     MAP_SIMD_NAME       "NEON"
+#elif defined(__SSE2__)
+#define     MAP_SIMD_NEON       0
+#define     MAP_SIMD_SSE2       1
+#define     MAP_SIMD_NAME       "SSE2"
+#else
+#define     MAP_SIMD_NEON       0
+#define     MAP_SIMD_SSE2       0
+#define     MAP_SIMD_NAME       "none"
+#endif
+
+#define     MAP_SIMD            (MAP_SIMD_NEON || MAP_SIMD_SSE2)
+
+// Map image memory layout. With MAP_TILED_IMAGE set to '1' the map image
+// is re-laid at load time into square tiles of (1 << MAP_TILE_BITS) pixels,
+// so a rotated patch touches about the same number of cache lines at any heading.
+// With '0' the map image is kept row-major, as stored in the map file.
+#define     MAP_TILED_IMAGE     1
+#define     MAP_TILE_BITS       4
+
+// Largest map image width or height in pixels, keeps the Q16
+// map coordinates of the patch transform within 32 bits
+#define     MAP_MAX_SIZE        INT16_MAX
+
+// Scroll the LCD with the map layer when the map moves along the LCD scroll
+// axis, so the push sends only the exposed lines. Off until the scroll area
+// definition is checked on a panel, set to '1' to enable.
+#ifndef MAP_LCD_SCROLL
+#define     MAP_LCD_SCROLL      0
+#endif
+
+// Heading resolution of the map patch rotation in steps per degree.
+// The quarter-wave sine table trig_table.h is generated for this resolution.
+#define     MAP_HEADING_RES     10
+#define     MAP_HEADING_QUARTER (90 * MAP_HEADING_RES)
+#define     MAP_HEADING_FULL    (360 * MAP_HEADING_RES)
+
+// Map patch kernels
+#define     MAP_KERNEL_SCALAR   0
+#define     MAP_KERNEL_SIMD     1
+#define     MAP_KERNEL_NO_QUADRANT  0x100   // disable cardinal heading fast path
+#define     MAP_KERNEL_NO_SCROLL    0x200   // disable incremental scroll rendering
+
+/********************************************************************
+ * Type definitions
+ *
+ */
+struct geo_point_t                              // track point
+{
+    double  latitude;
+    double  longitude;
+};
+
+/********************************************************************
+ * Function prototypes
+ *
+ */
+uint16_t *load_map_image(struct map_t *, uint16_t *);
+size_t    map_image_pixels(int, int);
+void      map_image_store_row(uint16_t *, int, int, const uint16_t *);
+int       map_patch_kernel(int);
+int       map_north_up(int);
+void      get_map_patch(struct position_t *, struct map_t *, uint16_t *, uint16_t *, int, int);
+void      map_draw_track(const struct geo_point_t *, int, uint16_t *, int, uint16_t);
+uint16_t *map_hud_clear(void);
+void      map_hud_update(void);
+void      map_hud_draw(uint16_t *);
+
+#endif  /* __map_h__ */
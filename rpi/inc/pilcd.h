@@ -50,6 +50,24 @@ as well as Adafruit raw 1.8" TFT display
 #define     FONT_PIX_WIDE       6
 #define     FONT_PIX_HIGH       8
 
+// Pixel transfer format to the LCD, 16 for RGB565 or 12 for RGB444 that sends
+// two pixels in three bytes. Frame buffers are RGB565 in both formats.
+#ifndef LCD_COLOR_BITS
+#define     LCD_COLOR_BITS      16
+#endif
+
+#define     LCD_SUBPIXEL_BITS   8               // polyline point coordinates in 1/256 pixel
+#define     LCD_SUBPIXEL        (1 << LCD_SUBPIXEL_BITS)
+
+/* -----------------------------------------
+   Type definitions
+----------------------------------------- */
+struct lcd_point_t                              // polyline point, pixel centers are at whole pixels
+{
+    int32_t x;
+    int32_t y;
+};
+
 /* -----------------------------------------
    Function prototypes
 ----------------------------------------- */
@@ -58,31 +76,44 @@ as well as Adafruit raw 1.8" TFT display
  *  General display functions
  *
  */
+int         lcdBusInit(void);                                       // open the LCD SPI bus and reset the LCD, return -1 if failed
+void        lcdBusClose(void);                                      // close the LCD SPI bus
 void        lcdInit(void);                                          // initialize LCD
 void        lcdOn(void);                                            // turn LCD on
 void        lcdOff(void);                                           // turn LCD off
 int         lcdHeight(void);                                        // return display pixel height
 int         lcdWidth(void);                                         // return display pixel width
+const uint8_t* lcdFontChar(char);                                   // return the FONT_PIX_WIDE font columns of a character
 void        lcdSetRotation(uint8_t);                                // screen rotation
 void        lcdInvertDisplay(int);                                  // invert display
 uint16_t    lcdColor565(uint8_t, uint8_t, uint8_t);                 // Pass 8-bit (each) R,G,B, get back 16-bit packed color
+int         lcdSetColorBits(int);                                   // pixel transfer format 16 (RGB565) or 12 (RGB444), return previous or -1
 
 /*------------------------------------------------
- *  Direct access display functions
- *  TODO change these to direct or frame buffer functions
+ *  Frame buffer display functions
+ *  (using a fixed 128x160 pixel frame buffer)
+ *
  */
-void        lcdFillRect(int, int, int, int, uint16_t);              // color filled rectangle
+uint16_t*   lcdFrameBufferInit(uint16_t);                           // allocate and initialize a frame buffer with a color
+void        lcdFrameBufferFree(uint16_t*);                          // release memory reserved for the frame buffer
+int         lcdFrameBufferPush(uint16_t*);                          // transfer dirty parts of frame buffer to LCD, return bytes sent
+void        lcdFrameBufferDirty(int, int, int, int);                // mark a frame buffer rectangle as changed
+void        lcdFrameBufferMask(uint16_t*, uint8_t*);                // keep a mask of the pixels drawn into one frame buffer
+void        lcdFrameBufferColor(uint16_t*, uint16_t);               // initialize an existing (allocated) frame buffer with a color
+void        lcdFrameBufferScroll(uint16_t*, int, int, uint16_t);    // scroll frame buffer by +/- pixels and fill new lines with color
+int         lcdHardwareScroll(int, int);                            // frame moved by +/- pixels, scroll the LCD on next push if possible
+void        lcdFrameBufferBlit(uint16_t*, int, int, const uint16_t*, int, int, int); // copy a clipped pixel rectangle into the frame buffer
+void        lcdPixelSwap(uint16_t*, const uint16_t*, int);          // convert pixels between native and LCD (big-endian) byte order
 
 /*------------------------------------------------
- *  Frame buffer display functions
- *  (using a fixed 128x160 pixel frame buffer)
+ *  Double buffered display functions
+ *  (a display thread pushes the front buffer while drawing goes to the back buffer)
  *
  */
-uint8_t*    lcdFrameBufferInit(uint16_t);                           // allocate and initialize a frame buffer with a color
-void        lcdFrameBufferFree(uint8_t*);                           // release memory reserved for the frame buffer
-void        lcdFrameBufferPush(uint8_t*);                           // transfer frame buffer to LCD
-void        lcdFrameBufferColor(uint8_t*, uint16_t);                // initialize an existing (allocated) frame buffer with a color
-void        lcdFrameBufferScroll(int, uint16_t);                    // scroll frame buffer by +/- pixels and fill new lines with color
+uint16_t*   lcdDisplayInit(uint16_t);                               // allocate two frame buffers with a color and start the display thread
+void        lcdDisplayClose(void);                                  // stop the display thread and release the frame buffers
+uint16_t*   lcdDisplaySwap(void);                                   // queue back buffer for display, return the new back buffer
+int         lcdDisplayFence(void);                                  // wait for the display thread to finish, return bytes sent
 
 /*------------------------------------------------
  *  Graphics functions for direct screen access or
@@ -90,10 +121,15 @@ void        lcdFrameBufferScroll(int, uint16_t);                    // scroll fr
  *  (assuming a fixed 160x128 pixel screen)
  *
  */
-void        lcdFillScreen(uint8_t*, uint16_t);                      // fill screen with a solid color
-void        lcdDrawPixel(uint8_t*, int, int, uint16_t);             // draw a pixel
-void        lcdDrawLine(uint8_t*, int, int, int, int, uint16_t);    // draw a line
-void        lcdDrawChar(uint8_t*, uint16_t, uint16_t, char, uint16_t, uint16_t, int, int); // write character to LCD or buffer
+void        lcdFillScreen(uint16_t*, uint16_t);                     // fill screen with a solid color
+void        lcdDrawPixel(uint16_t*, int, int, uint16_t);            // draw a pixel
+void        lcdDrawHLine(uint16_t*, int, int, int, uint16_t);       // draw a horizontal line
+void        lcdDrawVLine(uint16_t*, int, int, int, uint16_t);       // draw a vertical line
+void        lcdDrawRect(uint16_t*, int, int, int, int, uint16_t);   // draw a rectangle outline
+void        lcdFillRect(uint16_t*, int, int, int, int, uint16_t);   // color filled rectangle
+void        lcdDrawPolyline(uint16_t*, const struct lcd_point_t*, int, int, uint16_t); // anti-aliased line segments into frame buffer
+void        lcdDrawLine(uint16_t*, int, int, int, int, uint16_t);   // draw a line
+void        lcdDrawChar(uint16_t*, uint16_t, uint16_t, char, uint16_t, uint16_t, int, int); // write character to LCD or buffer
 
 #endif  /* end __pilcd_h__ */
 
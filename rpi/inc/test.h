@@ -17,5 +17,23 @@
 int test_t0_lcd(void);
 int test_t1_pbuttons(void);
 int test_t2_gps(void);
+int test_t3_map_patch(void);
+int test_t4_map_heading(void);
+int test_t5_map_scroll(void);
+int test_t6_dirty_push(void);
+int test_t7_display_swap(void);
+int test_t8_frame_timer(void);
+int test_t9_hw_scroll(void);
+int test_t10_draw_primitives(void);
+int test_t11_map_track(void);
+int test_t12_color_bits(void);
+int test_t13_text_cells(void);
+int test_t14_text_fields(void);
+int test_t15_map_hud(void);
+int test_t16_uart_reader(void);
+int test_t17_gps_thread(void);
+int test_t18_nmea_tokenizer(void);
+int test_t19_nmea_decoders(void);
+int test_t20_glyph_cache(void);
 
 #endif  /* __test_h__ */
@@ -11,6 +11,8 @@
 #ifndef __util_h__
 #define __util_h__
 
+#include    <stdint.h>
+
 /********************************************************************
  * Global definitions
  *
@@ -52,6 +54,16 @@
 #define     NMEA_RMC_VARSNS 11
 #define     NMEA_RMC_MODE   12
 
+// Degree digits of NMEA latitude 'ddmm.mmmm' and longitude 'dddmm.mmmm' fields
+#define     NMEA_LAT_DEG    2
+#define     NMEA_LONG_DEG   3
+
+// Fields recorded by the NMEA tokenizer, GGA has 15 fields and RMC 13 or 14
+#define     NMEA_FIELDS     20
+
+// UART line reader buffer, holds several NMEA sentences of up to 82 characters
+#define     UART_READ_BUFF  1024
+
 // Push button codes
 #define     PB_NONE        -1
 #define     PB_SELECT       0
@@ -79,6 +91,28 @@ struct position_t
     float   heading;
 };
 
+struct uart_reader_t                        // Buffered UART line reader
+{
+    int     fd;
+    int     start;                          // first character of the next line
+    int     scan;                           // next character to check for a line end
+    int     end;                            // end of the buffered text
+    char    buff[UART_READ_BUFF];
+};
+
+struct nmea_field_t                         // NMEA field in the sentence text
+{
+    uint16_t    offset;
+    uint16_t    length;
+};
+
+struct nmea_sentence_t                      // Tokenized NMEA sentence
+{
+    const char *text;                       // sentence text after the '$'
+    int     count;                          // recorded fields
+    struct nmea_field_t field[NMEA_FIELDS];
+};
+
 #define     MAX_FILE_NAME_LEN   32
 struct map_t
 {
@@ -98,10 +132,12 @@ struct map_t
  */
 
 // UART functions
+int   uart_open(const char *);
 int   uart_set_interface_attr(int, int, int);
 int   uart_set_blocking(int, int);
-int   uart_read_line(int, char *, int);
-int   uart_flush(int);
+void  uart_reader_init(struct uart_reader_t *, int);
+int   uart_read_line(struct uart_reader_t *, char **, int);
+int   uart_flush(struct uart_reader_t *);
 
 // String functions
 char* lstrip(char *, char *);
@@ -110,11 +146,22 @@ char* rstrip(char *, char *);
 // NMEA sentence parsing
 int   nmea_get_field(const char *, char, int, char *, int);
 int   nmea_checksum(char *);
-int   nmea_update_pos(char *, struct position_t *);
+int   nmea_tokenize(const char *, struct nmea_sentence_t *);
+int   nmea_field_is(const struct nmea_sentence_t *, int, const char *);
+const char *nmea_field_text(const struct nmea_sentence_t *, int);
+int   nmea_field_copy(const struct nmea_sentence_t *, int, char *, int);
+int   nmea_decode_coord(const char *, int, int32_t *);
+int   nmea_decode_time(const char *, int *, int *, int32_t *);
+int   nmea_decode_fixed(const char *, int, int32_t *);
+int   nmea_update_pos(const char *, struct position_t *);
 
 // Push button read
 int   push_button_read(void);
 
+// Display frame timer
+int   frame_timer_open(int);
+int   frame_timer_ack(int);
+
 // Map functions
 int   new_map_list(const char *, struct map_t **);
 void  del_map_list(struct map_t *);
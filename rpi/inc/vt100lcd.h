@@ -65,14 +65,25 @@
 
 #define     VT100_ESC           27
 
+#define     VT100_FIELD_WIDTH       16      // widest numeric field
+#define     VT100_FIELD_LEFT        0x01    // field flags: left aligned numbers, right aligned by default
+#define     VT100_FIELD_ZERO        0x02    //   pad right aligned numbers with leading zeros
+#define     VT100_FIELD_TRANSPARENT 0x04    //   transparent background only when writing to buffer
+
 /* -----------------------------------------
    function prototypes
 ----------------------------------------- */
 void    vt100_lcd_init(int, int, uint16_t, uint16_t);       // initialize the module with display orientation and background/foreground colors
 int     vt100_lcd_columns(void);                            // get LCD text columns
 int     vt100_lcd_rows(void);                               // get LCD text rows
-void    vt100_lcd_putc(uint8_t*, int, char);                // output a character through VT100 driver
-int     vt100_lcd_printf(uint8_t*, int, const char*, ...);  // printf style command for text output to LCD or frame buffer,
+void    vt100_lcd_invalidate(void);                         // frame buffer under the text was drawn over, redraw text cells on next write
+void    vt100_lcd_putc(uint16_t*, int, char);               // output a character through VT100 driver
+int     vt100_lcd_printf(uint16_t*, int, const char*, ...); // printf style command for text output to LCD or frame buffer,
                                                             // with VT100 support
+int     vt100_lcd_field(int, int, int, int, int, uint16_t, uint16_t); // register a numeric field at row and column with width, decimals, flags and
+                                                            // foreground/background colors, return field handle or -1
+void    vt100_lcd_field_int(uint16_t*, int, long);          // update a field with a value scaled by 10 to the power of the field decimals
+void    vt100_lcd_field_float(uint16_t*, int, double);      // update a field with a value rounded to the field decimals
+void    vt100_lcd_field_reset(void);                        // remove all fields
 
 #endif  /* __vt100lcd_h__ */
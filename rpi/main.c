@@ -78,6 +78,78 @@ int main (int argc, char **argv)
                 return_code = test_t2_gps();
                 break;
 
+            case 3:
+                return_code = test_t3_map_patch();
+                break;
+
+            case 4:
+                return_code = test_t4_map_heading();
+                break;
+
+            case 5:
+                return_code = test_t5_map_scroll();
+                break;
+
+            case 6:
+                return_code = test_t6_dirty_push();
+                break;
+
+            case 7:
+                return_code = test_t7_display_swap();
+                break;
+
+            case 8:
+                return_code = test_t8_frame_timer();
+                break;
+
+            case 9:
+                return_code = test_t9_hw_scroll();
+                break;
+
+            case 10:
+                return_code = test_t10_draw_primitives();
+                break;
+
+            case 11:
+                return_code = test_t11_map_track();
+                break;
+
+            case 12:
+                return_code = test_t12_color_bits();
+                break;
+
+            case 13:
+                return_code = test_t13_text_cells();
+                break;
+
+            case 14:
+                return_code = test_t14_text_fields();
+                break;
+
+            case 15:
+                return_code = test_t15_map_hud();
+                break;
+
+            case 16:
+                return_code = test_t16_uart_reader();
+                break;
+
+            case 17:
+                return_code = test_t17_gps_thread();
+                break;
+
+            case 18:
+                return_code = test_t18_nmea_tokenizer();
+                break;
+
+            case 19:
+                return_code = test_t19_nmea_decoders();
+                break;
+
+            case 20:
+                return_code = test_t20_glyph_cache();
+                break;
+
             default:
                 printf("Unrecognized test code %d\n", test_code);
                 return_code = 1;
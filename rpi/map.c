@@ -0,0 +1,1369 @@
+/********************************************************************
+ * map.c
+ *
+ *  Module map.c contains the map image loading and the map patch
+ *  rendering functions used by the navigation module.
+ *  Map patches are rotated around the display center with a
+ *  Q16 fixed-point incremental kernel: the affine transform is
+ *  evaluated once per frame, and the source image is then walked
+ *  with per-row and per-column step deltas.
+ *  A HUD overlay layer of static text is merged over the map
+ *  patch as it is copied to the screen buffer.
+ *
+ *  October 16, 2026
+ *
+ *******************************************************************/
+
+#include    <stdio.h>
+#include    <stdlib.h>
+#include    <unistd.h>
+#include    <string.h>
+#include    <fcntl.h>
+#include    <math.h>
+
+#include    "map.h"
+#include    "pilcd.h"
+#include    "vt100lcd.h"
+#include    "util.h"
+#include    "config.h"
+#include    "trig_table.h"
+
+#if MAP_SIMD_NEON
+#include    <arm_neon.h>
+#elif MAP_SIMD_SSE2
+#include    <emmintrin.h>
+#endif
+
+/********************************************************************
+ * Definitions
+ *
+ */
+#define     Q16_SHIFT           16
+#define     Q16_ONE             (1 << Q16_SHIFT)
+#define     SIMD_LANES          4
+
+#define     MAP_LAYER_PIXELS    (ST7735_TFTWIDTH * ST7735_TFTHEIGHT)
+
+#define     MAP_TILE_SIZE       (1 << MAP_TILE_BITS)
+#define     MAP_TILE_MASK       (MAP_TILE_SIZE - 1)
+
+#define     MAP_TRACK_LIMIT_UV  (1LL << 40)     // track point clamps, map coordinates in Q16
+#define     MAP_TRACK_LIMIT_XY  (1LL << 28)     // and screen coordinates in sub-pixels
+
+#define     MAP_HUD_ROWS        ST7735_TFTHEIGHT            // HUD layer rows, the longer screen side
+#define     MAP_HUD_RUNS        (MAP_LAYER_PIXELS / 2)      //  and most opaque runs, every other pixel
+
+/********************************************************************
+ * Type definitions
+ *
+ */
+struct patch_source_t                           // Map image as seen by the kernels
+{
+    const uint16_t *pixels;
+    int     width;
+    int     height;
+    int     stride;                             // pixels per row, or tiles per row if tiled
+};
+
+struct patch_xform_t                            // Screen to map image transform in Q16
+{
+    int32_t u_row;                              // map coordinates of the top-left screen pixel
+    int32_t v_row;
+    int32_t du_dx;                              // step for one screen column to the right
+    int32_t dv_dx;
+    int32_t du_dy;                              // step for one screen row down
+    int32_t dv_dy;
+};
+
+struct hud_run_t                                // Run of opaque HUD layer pixels on a row
+{
+    int16_t x;
+    int16_t count;
+};
+
+/********************************************************************
+ * Static function prototypes
+ *
+ */
+static int  map_image_stride(int);
+static inline uint32_t map_pixel_index(uint32_t, uint32_t, uint32_t);
+static inline uint32_t map_row_offset(uint32_t, uint32_t);
+static inline uint32_t map_col_offset(uint32_t);
+static int32_t sin_q15(int);
+static void patch_clip_span(int, int, int, int, int *, int *);
+static void patch_copy_run(struct patch_source_t *, int, int, int, uint16_t *, int);
+static void patch_render(struct patch_source_t *, uint16_t *, int, int, int, int, int, int, struct patch_xform_t *);
+static void patch_copy_layer(uint16_t *, int, int);
+static void patch_view_save(struct map_t *, struct patch_xform_t *);
+static void hud_stamp(uint16_t *, int, int);
+static inline int64_t track_clamp(int64_t, int64_t);
+static void patch_kernel_quadrant(struct patch_source_t *, uint16_t *, int, int, int, struct patch_xform_t *);
+static void patch_kernel_scalar(struct patch_source_t *, uint16_t *, int, int, int, struct patch_xform_t *);
+#if MAP_SIMD_NEON || MAP_SIMD_SSE2
+static void patch_kernel_simd(struct patch_source_t *, uint16_t *, int, int, int, struct patch_xform_t *);
+#endif
+
+/********************************************************************
+ * Module globals
+ *
+ */
+static int  patch_kernel = MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR;
+static int  quadrant_path = 1;
+static int  scroll_path = 1;
+static int  north_up = 0;
+
+static uint16_t map_layer[MAP_LAYER_PIXELS];    // last rendered map patch, without overlays
+static struct
+{
+    int     valid;
+    const uint16_t *image_buffer;
+    int     map_width, map_height;
+    int     roi_width, roi_height;
+    int     theta;
+    struct patch_xform_t xform;
+} layer_state = {0};
+static struct
+{
+    int     valid;
+    double  tl_lat, tl_long;
+    double  scale_u, scale_v;                   // map pixels per degree, signed
+    struct patch_xform_t xform;
+} view_state = {0};                             // transform of the last rendered patch, for overlays
+
+static struct lcd_point_t *track_points = NULL; // screen coordinates of the projected track
+static int  track_capacity = 0;
+
+static uint16_t hud_layer[MAP_LAYER_PIXELS];    // HUD overlay pixels
+static uint8_t  hud_mask[MAP_LAYER_PIXELS];     //  and their coverage, '0' pixels are transparent
+static struct hud_run_t hud_runs[MAP_HUD_RUNS]; // opaque pixel runs of the HUD layer, by row,
+static int  hud_row_runs[MAP_HUD_ROWS + 1];     //  row y has runs [hud_row_runs[y], hud_row_runs[y + 1])
+static int  hud_width = 0;                      // HUD layer size, '0' before map_hud_clear()
+static int  hud_height = 0;
+
+/********************************************************************
+ * load_map_image()
+ *
+ *  Load the map image referenced by the map meta date
+ *  structure in loaded_map.
+ *  This function uses 'realloc' to allocate memory for the map image,
+ *  and the calling application should free this buffer.
+ *  Image files hold LCD (big-endian) pixels, they are converted
+ *  to native order for the frame buffer at load time.
+ *  Maps wider or taller than MAP_MAX_SIZE pixels are not loaded.
+ *
+ *  param:  Pointer to current map meta data, pointer to the previously
+ *          loaded image buffer to reuse or NULL
+ *  return: Pointer to allocated buffer containing map image pixels
+ *
+ */
+uint16_t *load_map_image(struct map_t *loaded_map, uint16_t *map_image)
+{
+    uint16_t   *image_buffer;
+    size_t      image_size;
+    char        raw_img_file[128] = {USB_DIR};
+    int         fd;
+#if MAP_TILED_IMAGE
+    uint16_t   *row_buffer;
+    size_t      row_size;
+    int         row;
+#endif
+
+    // A new image may be loaded at the same address, so the map layer can no longer be scrolled
+    layer_state.valid = 0;
+
+    // Reject map sizes that the Q16 patch transform cannot address
+    if ( loaded_map->width <= 0 || loaded_map->width > MAP_MAX_SIZE ||
+         loaded_map->height <= 0 || loaded_map->height > MAP_MAX_SIZE )
+    {
+        free(map_image);
+        return NULL;
+    }
+
+    // Allocate a buffer for the image that is pixel count of uint16_t
+    image_size = sizeof(uint16_t) * map_image_pixels(loaded_map->width, loaded_map->height);
+    image_buffer = realloc(map_image, image_size);
+
+    // If allocation is of, load the image pixel data from file
+    if ( image_buffer )
+    {
+        // Setup directory and file name string,
+        // then open the file
+        strncat(raw_img_file, "/", MAX_FILE_NAME_LEN);
+        strncat(raw_img_file, loaded_map->file_name, MAX_FILE_NAME_LEN);
+        fd = open(raw_img_file, O_RDONLY);
+        if ( fd == -1 )
+        {
+            free(image_buffer); // Error checking of the image buffer pointer
+            return NULL;        //  will be done in get_map_patch()
+        }
+
+#if MAP_TILED_IMAGE
+        // Read the file one row at a time and re-lay the rows into tiles
+        row_size = sizeof(uint16_t) * loaded_map->width;
+        row_buffer = malloc(row_size);
+        if ( row_buffer == NULL )
+        {
+            close(fd);
+            free(image_buffer);
+            return NULL;
+        }
+
+        for ( row = 0; row < loaded_map->height; row++ )
+        {
+            if ( read(fd, (void *)row_buffer, row_size) != (ssize_t)row_size )
+                break;
+            lcdPixelSwap(row_buffer, row_buffer, loaded_map->width);
+            map_image_store_row(image_buffer, loaded_map->width, row, row_buffer);
+        }
+
+        free(row_buffer);
+#else
+        // Read the file content into the buffer
+        read(fd, (void *)image_buffer, image_size);
+        lcdPixelSwap(image_buffer, image_buffer, map_image_pixels(loaded_map->width, loaded_map->height));
+#endif
+        close(fd);
+    }
+
+    return image_buffer;
+}
+
+/********************************************************************
+ * map_image_pixels()
+ *
+ *  Calculate the pixel count of a map image buffer in the build's
+ *  image layout. A tiled image is padded to whole tiles.
+ *
+ *  param:  Map image width and height in pixels
+ *  return: Number of pixels to allocate for the image buffer
+ *
+ */
+size_t map_image_pixels(int width, int height)
+{
+#if MAP_TILED_IMAGE
+    size_t  tile_rows;
+
+    tile_rows = (height + MAP_TILE_MASK) >> MAP_TILE_BITS;
+
+    return (size_t)map_image_stride(width) * tile_rows * MAP_TILE_SIZE * MAP_TILE_SIZE;
+#else
+    return (size_t)width * height;
+#endif
+}
+
+/********************************************************************
+ * map_image_store_row()
+ *
+ *  Store one row of row-major map pixels into a map image buffer
+ *  in the build's image layout.
+ *
+ *  param:  Pointer to map image buffer, map image width in pixels,
+ *          row number, pointer to row pixels
+ *  return: none
+ *
+ */
+void map_image_store_row(uint16_t *image_buffer, int width, int row, const uint16_t *pixels)
+{
+#if MAP_TILED_IMAGE
+    int     u, run;
+    int     stride;
+
+    // Copy the row in runs that end at tile boundaries,
+    // each run is contiguous in the tiled buffer
+    stride = map_image_stride(width);
+    for ( u = 0; u < width; u += run )
+    {
+        run = MAP_TILE_SIZE - (u & MAP_TILE_MASK);
+        if ( run > (width - u) )
+            run = width - u;
+
+        memcpy(&image_buffer[map_pixel_index(u, row, stride)], &pixels[u], sizeof(uint16_t) * run);
+    }
+#else
+    memcpy(&image_buffer[(size_t)row * width], pixels, sizeof(uint16_t) * width);
+#endif
+}
+
+/********************************************************************
+ * map_image_stride()
+ *
+ *  Map image stride used for pixel address calculation.
+ *
+ *  param:  Map image width in pixels
+ *  return: Tiles per row for a tiled image, or pixels per row
+ *
+ */
+static int map_image_stride(int width)
+{
+#if MAP_TILED_IMAGE
+    return (width + MAP_TILE_MASK) >> MAP_TILE_BITS;
+#else
+    return width;
+#endif
+}
+
+/********************************************************************
+ * map_pixel_index()
+ *
+ *  Map image pixel address function. In a tiled image each
+ *  square tile is stored as a contiguous row-major block, and
+ *  the tiles are stored in row-major order.
+ *
+ *  param:  Pixel coordinates (u,v) and image stride from map_image_stride()
+ *  return: Pixel index in the map image buffer
+ *
+ */
+static inline uint32_t map_pixel_index(uint32_t u, uint32_t v, uint32_t stride)
+{
+#if MAP_TILED_IMAGE
+    return ((((v >> MAP_TILE_BITS) * stride) + (u >> MAP_TILE_BITS)) << (2 * MAP_TILE_BITS)) |
+           ((v & MAP_TILE_MASK) << MAP_TILE_BITS) | (u & MAP_TILE_MASK);
+#else
+    return (v * stride) + u;
+#endif
+}
+
+/********************************************************************
+ * map_row_offset()
+ * map_col_offset()
+ *
+ *  The pixel address function is separable:
+ *  map_pixel_index(u, v, stride) == map_row_offset(v, stride) + map_col_offset(u)
+ *  so kernels that walk a single map row or column can hoist one of the terms.
+ *
+ *  param:  Map image row 'v' and image stride, or map image column 'u'
+ *  return: Row or column part of the pixel index
+ *
+ */
+static inline uint32_t map_row_offset(uint32_t v, uint32_t stride)
+{
+#if MAP_TILED_IMAGE
+    return (((v >> MAP_TILE_BITS) * stride) << (2 * MAP_TILE_BITS)) | ((v & MAP_TILE_MASK) << MAP_TILE_BITS);
+#else
+    return v * stride;
+#endif
+}
+
+static inline uint32_t map_col_offset(uint32_t u)
+{
+#if MAP_TILED_IMAGE
+    return ((u >> MAP_TILE_BITS) << (2 * MAP_TILE_BITS)) | (u & MAP_TILE_MASK);
+#else
+    return u;
+#endif
+}
+
+/********************************************************************
+ * map_patch_kernel()
+ *
+ *  Select the map patch rendering kernel. The SIMD kernel is
+ *  available only when the module was built for ARM NEON or x86 SSE2,
+ *  otherwise the scalar kernel is always used. Selecting the kernel is
+ *  only required for benchmarking and golden testing, the default is the
+ *  fastest kernel available. Adding MAP_KERNEL_NO_QUADRANT disables the
+ *  cardinal heading fast path, so the selected kernel renders all headings.
+ *  Adding MAP_KERNEL_NO_SCROLL disables incremental scroll rendering, so
+ *  every patch is fully rendered.
+ *
+ *  param:  MAP_KERNEL_SCALAR or MAP_KERNEL_SIMD, optionally with
+ *          MAP_KERNEL_NO_QUADRANT and MAP_KERNEL_NO_SCROLL
+ *  return: The kernel that will be used
+ *
+ */
+int map_patch_kernel(int kernel)
+{
+    quadrant_path = !(kernel & MAP_KERNEL_NO_QUADRANT);
+    scroll_path = !(kernel & MAP_KERNEL_NO_SCROLL);
+    kernel &= ~(MAP_KERNEL_NO_QUADRANT | MAP_KERNEL_NO_SCROLL);
+
+    if ( kernel == MAP_KERNEL_SIMD && MAP_SIMD )
+        patch_kernel = MAP_KERNEL_SIMD;
+    else
+        patch_kernel = MAP_KERNEL_SCALAR;
+
+    return patch_kernel | (quadrant_path ? 0 : MAP_KERNEL_NO_QUADRANT) | (scroll_path ? 0 : MAP_KERNEL_NO_SCROLL);
+}
+
+/********************************************************************
+ * map_north_up()
+ *
+ *  Select the map display orientation. In north-up mode the map patch
+ *  is not rotated to the heading, and is always rendered with the
+ *  cardinal heading (quadrant) kernel.
+ *
+ *  param:  '1' for north-up, '0' for heading-up
+ *  return: The selected orientation
+ *
+ */
+int map_north_up(int enable)
+{
+    north_up = (enable != 0);
+
+    return north_up;
+}
+
+/********************************************************************
+ * get_map_patch()
+ *
+ *  Load a map patch from the map image buffer into the screen buffer.
+ *  The map patch is rotated according to the current heading,
+ *  rounded to the resolution of MAP_HEADING_RES steps per degree.
+ *  The rotation is done in Q16 fixed-point: the map coordinates of the
+ *  top-left screen pixel and the per-column and per-row step deltas are
+ *  calculated once, and the source image is then walked incrementally.
+ *  The result matches the floating point transform to within one source pixel.
+ *  Headings of 0, 90, 180 and 270 degrees, and north-up mode, are rendered
+ *  with row copies instead of the rotation kernel.
+ *  The rendered patch is kept in a map layer. When the heading did not change
+ *  and the patch only moved, the map layer is scrolled and only the newly
+ *  exposed rows and columns are rendered.
+ *  The opaque pixels of the HUD layer replace the map layer pixels
+ *  as the map layer is copied to the screen buffer.
+ *  Changed screen buffer areas are marked dirty for the next LCD push.
+ *
+ *  param:  Pointer to current pos data, pointer to loaded map meta data, pointer to map image buffer,
+ *          pointer to screen buffer and its width and height in pixels
+ *  return: None. Screen buffer will contain map patch
+ *
+ */
+void get_map_patch(struct position_t *pos, struct map_t *map_attrib, uint16_t *image_buffer,
+                   uint16_t *frame, int roi_img_width, int roi_img_height)
+{
+    int     theta;
+    int     hwidth, hheight;
+    int     roi_center_x, roi_center_y;
+    int     shift_x, shift_y, scroll, row, rows;
+    int32_t sin_q16, cos_q16;
+    int64_t delta_u, delta_v;
+    double  map_res_x, map_res_y;
+    struct patch_source_t source;
+    struct patch_xform_t  xform;
+
+    // Sanity check
+    if ( image_buffer == NULL )
+    {
+        layer_state.valid = 0;
+        view_state.valid = 0;
+        memset(frame, 0, sizeof(uint16_t) * roi_img_width * roi_img_height);
+        lcdFrameBufferDirty(0, 0, roi_img_width, roi_img_height);
+        vt100_lcd_printf(frame, 1, "\e[8;0f\e[31;40m** Map load error\n   image_buffer == NULL **\e[37;40m");
+        return;
+    }
+
+    // Initialize variables for calculation
+    theta = north_up ? 0 : (int)lroundf(pos->heading * MAP_HEADING_RES) % MAP_HEADING_FULL;
+    if ( theta < 0 )
+        theta += MAP_HEADING_FULL;
+    hheight = roi_img_height / 2;
+    hwidth = roi_img_width / 2;
+
+    // Calculate the center of the display in pixels based on current position
+    map_res_x = fabs(map_attrib->br_long - map_attrib->tl_long) / (double)map_attrib->width;
+    roi_center_x = (int)(fabs(pos->longitude - map_attrib->tl_long) / map_res_x);
+
+    map_res_y = fabs(map_attrib->br_lat - map_attrib->tl_lat) / (double)map_attrib->height;
+    roi_center_y = (int)(fabs(pos->latitude - map_attrib->tl_lat) / map_res_y);
+
+    // Convert the rotation to Q16 and calculate the map coordinates
+    // of the top-left screen pixel:
+    //   u = (x - hwidth) * cos - (y - hheight) * sin + roi_center_x
+    //   v = (x - hwidth) * sin + (y - hheight) * cos + roi_center_y
+    // A half pixel is added so that the shift in the kernel rounds to the nearest
+    // source pixel, which keeps the result within one pixel of the truncating
+    // floating point transform.
+    // Moving one column right adds (cos, sin) to the map coordinates,
+    // moving one row down adds (-sin, cos).
+    sin_q16 = sin_q15(theta) * 2;
+    cos_q16 = sin_q15((theta + MAP_HEADING_QUARTER) % MAP_HEADING_FULL) * 2;
+
+    xform.u_row = (roi_center_x << Q16_SHIFT) + (Q16_ONE / 2) - hwidth * cos_q16 + hheight * sin_q16;
+    xform.v_row = (roi_center_y << Q16_SHIFT) + (Q16_ONE / 2) - hwidth * sin_q16 - hheight * cos_q16;
+    xform.du_dx = cos_q16;
+    xform.dv_dx = sin_q16;
+    xform.du_dy = -sin_q16;
+    xform.dv_dy = cos_q16;
+
+    source.pixels = image_buffer;
+    source.width = map_attrib->width;
+    source.height = map_attrib->height;
+    source.stride = map_image_stride(map_attrib->width);
+
+    // Without a map layer of the screen size, or when it cannot be scrolled,
+    // render the whole patch directly into the screen buffer.
+    // The map layer is not changed, so its state remains valid.
+    if ( !scroll_path ||
+         roi_img_width != lcdWidth() || roi_img_height != lcdHeight() ||
+         (roi_img_width * roi_img_height) > MAP_LAYER_PIXELS )
+    {
+        patch_render(&source, frame, roi_img_width, 0, 0, roi_img_width, roi_img_height, theta, &xform);
+        lcdFrameBufferDirty(0, 0, roi_img_width, roi_img_height);
+        hud_stamp(frame, roi_img_width, roi_img_height);
+        patch_view_save(map_attrib, &xform);
+        return;
+    }
+
+    shift_x = 0;
+    shift_y = 0;
+    scroll = 0;
+
+    // With the same map and heading the patch only moved, so find the move in
+    // whole screen pixels by projecting the change of the top-left map coordinates
+    // on the screen axes. The new origin is then snapped to the old origin plus
+    // the whole screen pixel move, which is within half a pixel of the exact origin.
+    if ( layer_state.valid &&
+         layer_state.image_buffer == image_buffer &&
+         layer_state.map_width == map_attrib->width && layer_state.map_height == map_attrib->height &&
+         layer_state.roi_width == roi_img_width && layer_state.roi_height == roi_img_height &&
+         layer_state.theta == theta )
+    {
+        delta_u = (int64_t)xform.u_row - layer_state.xform.u_row;
+        delta_v = (int64_t)xform.v_row - layer_state.xform.v_row;
+        shift_x = (int)(((delta_u * xform.du_dx) + (delta_v * xform.dv_dx) + (1LL << 31)) >> 32);
+        shift_y = (int)(((delta_u * xform.du_dy) + (delta_v * xform.dv_dy) + (1LL << 31)) >> 32);
+
+        if ( abs(shift_x) < roi_img_width && abs(shift_y) < roi_img_height )
+        {
+            scroll = 1;
+            xform.u_row = layer_state.xform.u_row + (shift_x * xform.du_dx) + (shift_y * xform.du_dy);
+            xform.v_row = layer_state.xform.v_row + (shift_x * xform.dv_dx) + (shift_y * xform.dv_dy);
+        }
+    }
+
+    if ( scroll )
+    {
+        // Scroll the map layer opposite to the move,
+        // then render the exposed rows and columns
+        lcdFrameBufferScroll(map_layer, -shift_x, -shift_y, ST7735_BLACK);
+
+#if MAP_LCD_SCROLL
+        // The screen moves with the layer, a move along the LCD scroll axis
+        // is done by the LCD and the push sends only the exposed lines
+        lcdHardwareScroll(-shift_x, -shift_y);
+#endif
+
+        if ( shift_y > 0 )
+            patch_render(&source, map_layer, roi_img_width, 0, roi_img_height - shift_y, roi_img_width, shift_y, theta, &xform);
+        else if ( shift_y < 0 )
+            patch_render(&source, map_layer, roi_img_width, 0, 0, roi_img_width, -shift_y, theta, &xform);
+
+        rows = roi_img_height - abs(shift_y);
+        row = (shift_y > 0) ? 0 : -shift_y;
+
+        if ( shift_x > 0 )
+            patch_render(&source, map_layer, roi_img_width, roi_img_width - shift_x, row, shift_x, rows, theta, &xform);
+        else if ( shift_x < 0 )
+            patch_render(&source, map_layer, roi_img_width, 0, row, -shift_x, rows, theta, &xform);
+    }
+    else
+    {
+        patch_render(&source, map_layer, roi_img_width, 0, 0, roi_img_width, roi_img_height, theta, &xform);
+    }
+
+    layer_state.valid = 1;
+    layer_state.image_buffer = image_buffer;
+    layer_state.map_width = map_attrib->width;
+    layer_state.map_height = map_attrib->height;
+    layer_state.roi_width = roi_img_width;
+    layer_state.roi_height = roi_img_height;
+    layer_state.theta = theta;
+    layer_state.xform = xform;
+    patch_view_save(map_attrib, &xform);
+
+    patch_copy_layer(frame, roi_img_width, roi_img_height);
+}
+
+/********************************************************************
+ * map_draw_track()
+ *
+ *  Draw a track of geographic points over the map patch rendered by
+ *  the last call to get_map_patch(), such as a breadcrumb trail or a route.
+ *  The points are projected with the same transform that rendered the patch,
+ *  including the snapped origin of a scrolled patch, so the track stays
+ *  in place over the map. Points are projected in Q16 fixed-point and
+ *  drawn as an anti-aliased polyline clipped to the screen.
+ *  The track should be drawn after get_map_patch() and before the LCD push;
+ *  the map layer is not changed, so the next patch restores the map under it.
+ *  The HUD layer is copied over the track again to keep the HUD on top.
+ *
+ *  param:  Pointer to track points and their count, pointer to screen buffer,
+ *          line width in pixels, line color
+ *  return: None
+ *
+ */
+void map_draw_track(const struct geo_point_t *points, int count, uint16_t *frame, int width, uint16_t color)
+{
+    int     i;
+    int64_t du, dv, x, y;
+    double  u, v;
+    struct lcd_point_t *resized;
+
+    if ( !view_state.valid || count <= 0 )
+        return;
+
+    if ( count > track_capacity )
+    {
+        resized = realloc(track_points, sizeof(struct lcd_point_t) * count);
+        if ( resized == NULL )
+            return;
+        track_points = resized;
+        track_capacity = count;
+    }
+
+    // The continuous map coordinates of a point, with map pixel k covering [k, k+1),
+    // relative to the top-left screen pixel center, are rotated back onto the screen axes:
+    //   x = du * cos + dv * sin
+    //   y = -du * sin + dv * cos
+    // Points that project far outside the screen are clamped to keep the products
+    // in 64 bits, and the polyline clips them anyway.
+    for ( i = 0; i < count; i++ )
+    {
+        u = (points[i].longitude - view_state.tl_long) * view_state.scale_u * Q16_ONE - view_state.xform.u_row;
+        v = (points[i].latitude - view_state.tl_lat) * view_state.scale_v * Q16_ONE - view_state.xform.v_row;
+        du = llround(fmax(fmin(u, MAP_TRACK_LIMIT_UV), -MAP_TRACK_LIMIT_UV));
+        dv = llround(fmax(fmin(v, MAP_TRACK_LIMIT_UV), -MAP_TRACK_LIMIT_UV));
+
+        x = ((du * view_state.xform.du_dx) + (dv * view_state.xform.dv_dx)) >> (2 * Q16_SHIFT - LCD_SUBPIXEL_BITS);
+        y = ((du * view_state.xform.du_dy) + (dv * view_state.xform.dv_dy)) >> (2 * Q16_SHIFT - LCD_SUBPIXEL_BITS);
+
+        track_points[i].x = (int32_t)track_clamp(x, MAP_TRACK_LIMIT_XY);
+        track_points[i].y = (int32_t)track_clamp(y, MAP_TRACK_LIMIT_XY);
+    }
+
+    lcdDrawPolyline(frame, track_points, count, width, color);
+    hud_stamp(frame, lcdWidth(), lcdHeight());
+}
+
+/********************************************************************
+ * map_hud_clear()
+ *
+ *  Clear the HUD overlay layer to transparent, and size it to the screen.
+ *  The HUD layer is a screen sized buffer that is drawn into with the
+ *  screen buffer functions, such as vt100_lcd_printf() and lcdDrawChar(),
+ *  which keep a mask of the pixels they draw (see lcdFrameBufferMask()).
+ *  Text pixels of any color are opaque and the text background is transparent,
+ *  so text drawn without the 'transparent' option lets changed text erase itself.
+ *  Call map_hud_update() after drawing into the HUD layer.
+ *
+ *  param:  None
+ *  return: Pointer to the HUD layer pixels
+ *
+ */
+uint16_t *map_hud_clear(void)
+{
+    hud_width = lcdWidth();
+    hud_height = lcdHeight();
+    memset(hud_layer, 0, sizeof(hud_layer));
+    memset(hud_mask, 0, sizeof(hud_mask));
+    memset(hud_row_runs, 0, sizeof(hud_row_runs));
+    lcdFrameBufferMask(hud_layer, hud_mask);
+
+    return hud_layer;
+}
+
+/********************************************************************
+ * map_hud_update()
+ *
+ *  Find the runs of opaque pixels on each row of the HUD layer mask,
+ *  so the HUD is merged by copying only its opaque pixels.
+ *  Call after drawing into the HUD layer.
+ *
+ *  param:  None
+ *  return: None
+ *
+ */
+void map_hud_update(void)
+{
+    int     x, y, run;
+    const uint8_t *mask_row;
+
+    run = 0;
+    for ( y = 0; y < hud_height; y++ )
+    {
+        hud_row_runs[y] = run;
+        mask_row = &hud_mask[y * hud_width];
+
+        for ( x = 0; x < hud_width; x++ )
+        {
+            if ( mask_row[x] == 0 )
+                continue;
+
+            hud_runs[run].x = x;
+            for ( ; x < hud_width && mask_row[x] != 0; x++ );
+            hud_runs[run].count = x - hud_runs[run].x;
+            run++;
+        }
+    }
+
+    hud_row_runs[y] = run;
+}
+
+/********************************************************************
+ * map_hud_draw()
+ *
+ *  Copy the opaque pixels of the HUD layer into a screen buffer,
+ *  for screens that are not rendered with get_map_patch().
+ *
+ *  param:  Pointer to screen buffer
+ *  return: None
+ *
+ */
+void map_hud_draw(uint16_t *frame)
+{
+    hud_stamp(frame, lcdWidth(), lcdHeight());
+}
+
+/********************************************************************
+ * hud_stamp()
+ *
+ *  Copy the opaque pixels of the HUD layer into a screen buffer
+ *  of the HUD layer size, and mark them dirty.
+ *
+ *  param:  Pointer to screen buffer, its width and height in pixels
+ *  return: None
+ *
+ */
+static void hud_stamp(uint16_t *frame, int roi_img_width, int roi_img_height)
+{
+    int     y, r, offset;
+
+    if ( roi_img_width != hud_width || roi_img_height != hud_height )
+        return;
+
+    for ( y = 0; y < hud_height; y++ )
+    {
+        for ( r = hud_row_runs[y]; r < hud_row_runs[y + 1]; r++ )
+        {
+            offset = (y * hud_width) + hud_runs[r].x;
+            memcpy(&frame[offset], &hud_layer[offset], sizeof(uint16_t) * hud_runs[r].count);
+            lcdFrameBufferDirty(hud_runs[r].x, y, hud_runs[r].count, 1);
+        }
+    }
+}
+
+/********************************************************************
+ * track_clamp()
+ *
+ *  Clamp a value to a symmetric limit.
+ *
+ *  param:  Value, limit
+ *  return: Clamped value
+ *
+ */
+static inline int64_t track_clamp(int64_t value, int64_t limit)
+{
+    if ( value > limit )
+        return limit;
+    if ( value < -limit )
+        return -limit;
+    return value;
+}
+
+/********************************************************************
+ * patch_view_save()
+ *
+ *  Save the transform of the rendered map patch for map_draw_track().
+ *
+ *  param:  Pointer to map meta data, pointer to the transform used for the patch
+ *  return: None
+ *
+ */
+static void patch_view_save(struct map_t *map_attrib, struct patch_xform_t *xform)
+{
+    view_state.valid = (map_attrib->br_long != map_attrib->tl_long) && (map_attrib->br_lat != map_attrib->tl_lat);
+    view_state.tl_lat = map_attrib->tl_lat;
+    view_state.tl_long = map_attrib->tl_long;
+    view_state.scale_u = (double)map_attrib->width / (map_attrib->br_long - map_attrib->tl_long);
+    view_state.scale_v = (double)map_attrib->height / (map_attrib->br_lat - map_attrib->tl_lat);
+    view_state.xform = *xform;
+}
+
+/********************************************************************
+ * patch_copy_layer()
+ *
+ *  Copy the map layer into the screen buffer merged with the HUD layer,
+ *  and mark only the changed part of each row as dirty for the next LCD push.
+ *  On rows with HUD pixels the map layer is copied between the opaque HUD runs
+ *  and the runs are copied from the HUD layer, so every pixel is written once.
+ *  When the patch did not move, only the areas of the previous overlays change.
+ *
+ *  param:  Pointer to screen buffer, its width and height in pixels
+ *  return: None
+ *
+ */
+static void patch_copy_layer(uint16_t *frame, int roi_img_width, int roi_img_height)
+{
+    int     y, x, r, first, last;
+    int     hud;
+    uint16_t        merged_row[MAP_HUD_ROWS];
+    uint16_t       *frame_row;
+    const uint16_t *layer_row;
+    const uint16_t *hud_row;
+
+    hud = (roi_img_width == hud_width && roi_img_height == hud_height && roi_img_width <= MAP_HUD_ROWS);
+
+    for ( y = 0; y < roi_img_height; y++ )
+    {
+        frame_row = &frame[y * roi_img_width];
+        layer_row = &map_layer[y * roi_img_width];
+
+        if ( hud && hud_row_runs[y] != hud_row_runs[y + 1] )
+        {
+            hud_row = &hud_layer[y * roi_img_width];
+            x = 0;
+
+            for ( r = hud_row_runs[y]; r < hud_row_runs[y + 1]; r++ )
+            {
+                memcpy(&merged_row[x], &layer_row[x], sizeof(uint16_t) * (hud_runs[r].x - x));
+                x = hud_runs[r].x + hud_runs[r].count;
+                memcpy(&merged_row[hud_runs[r].x], &hud_row[hud_runs[r].x], sizeof(uint16_t) * hud_runs[r].count);
+            }
+
+            memcpy(&merged_row[x], &layer_row[x], sizeof(uint16_t) * (roi_img_width - x));
+            layer_row = merged_row;
+        }
+
+        for ( first = 0; first < roi_img_width && frame_row[first] == layer_row[first]; first++ );
+        if ( first == roi_img_width )
+            continue;
+
+        for ( last = roi_img_width - 1; frame_row[last] == layer_row[last]; last-- );
+
+        memcpy(&frame_row[first], &layer_row[first], sizeof(uint16_t) * (last - first + 1));
+        lcdFrameBufferDirty(first, y, last - first + 1, 1);
+    }
+}
+
+/********************************************************************
+ * patch_render()
+ *
+ *  Render a rectangle of the map patch into a screen buffer
+ *  with the fastest kernel for the heading.
+ *
+ *  param:  Pointer to map image source, pointer to screen buffer and its
+ *          width (pitch) in pixels, rectangle top-left corner, width and height,
+ *          heading in heading steps, pointer to screen to map transform of
+ *          the whole screen buffer
+ *  return: None
+ *
+ */
+static void patch_render(struct patch_source_t *source, uint16_t *frame, int frame_pitch,
+                         int x0, int y0, int width, int height, int theta, struct patch_xform_t *xform)
+{
+    struct patch_xform_t rect_xform;
+
+    // Move the transform origin to the rectangle's top-left corner
+    rect_xform = *xform;
+    rect_xform.u_row += (x0 * xform->du_dx) + (y0 * xform->du_dy);
+    rect_xform.v_row += (x0 * xform->dv_dx) + (y0 * xform->dv_dy);
+    frame += (y0 * frame_pitch) + x0;
+
+    // At cardinal headings the patch is a clipped copy of map rows or columns
+    if ( quadrant_path && (theta % MAP_HEADING_QUARTER) == 0 )
+    {
+        patch_kernel_quadrant(source, frame, frame_pitch, width, height, &rect_xform);
+        return;
+    }
+
+    // Copy rotated map patch from map image to display buffer
+#if MAP_SIMD_NEON || MAP_SIMD_SSE2
+    if ( patch_kernel == MAP_KERNEL_SIMD )
+    {
+        patch_kernel_simd(source, frame, frame_pitch, width, height, &rect_xform);
+        return;
+    }
+#endif
+
+    patch_kernel_scalar(source, frame, frame_pitch, width, height, &rect_xform);
+}
+
+/********************************************************************
+ * sin_q15()
+ *
+ *  Sine from the quarter-wave table, folded to the full circle.
+ *
+ *  param:  Angle in heading steps, 0 to (MAP_HEADING_FULL - 1)
+ *  return: sin() of the angle in Q15
+ *
+ */
+static int32_t sin_q15(int theta)
+{
+    int     step;
+
+    step = theta % MAP_HEADING_QUARTER;
+
+    switch ( theta / MAP_HEADING_QUARTER )
+    {
+        case 0:
+            return SIN_Q15[step];
+
+        case 1:
+            return SIN_Q15[MAP_HEADING_QUARTER - step];
+
+        case 2:
+            return -SIN_Q15[step];
+
+        default:
+            return -SIN_Q15[MAP_HEADING_QUARTER - step];
+    }
+}
+
+/********************************************************************
+ * patch_kernel_quadrant()
+ *
+ *  Map patch kernel for headings of 0, 90, 180 and 270 degrees.
+ *  The step deltas are then whole pixels along a single map axis, so
+ *  the patch is a clipped copy: forward map row copies at 0 degrees,
+ *  reversed map row copies at 180 degrees, and a transpose of map columns
+ *  in tile sized blocks at 90 and 270 degrees.
+ *  Produces the same output as patch_kernel_scalar().
+ *
+ *  param:  Pointer to map image source,
+ *          pointer to screen buffer, its pitch, and width and height to render,
+ *          pointer to screen to map transform
+ *  return: None
+ *
+ */
+static void patch_kernel_quadrant(struct patch_source_t *source, uint16_t *frame, int frame_pitch,
+                                  int roi_img_width, int roi_img_height, struct patch_xform_t *xform)
+{
+    int     u0, v0, du_dx, dv_dx, du_dy, dv_dy;
+    int     x, y, u, v, bx, by, x_end, y_end;
+    int     x_lo, x_hi, y_lo, y_hi;
+    uint32_t        row_offset[MAP_TILE_SIZE];
+    uint16_t       *frame_row;
+    const uint16_t *map_col;
+
+    // The steps are whole pixels, so the map coordinates of every
+    // screen pixel are whole steps away from the top-left pixel
+    u0 = xform->u_row >> Q16_SHIFT;
+    v0 = xform->v_row >> Q16_SHIFT;
+    du_dx = xform->du_dx >> Q16_SHIFT;
+    dv_dx = xform->dv_dx >> Q16_SHIFT;
+    du_dy = xform->du_dy >> Q16_SHIFT;
+    dv_dy = xform->dv_dy >> Q16_SHIFT;
+
+    // 0 and 180 degrees: screen rows are forward or reversed map row runs
+    if ( dv_dx == 0 )
+    {
+        patch_clip_span(u0, du_dx, source->width, roi_img_width, &x_lo, &x_hi);
+
+        for ( y = 0; y < roi_img_height; y++ )
+        {
+            frame_row = &frame[y * frame_pitch];
+            v = v0 + (y * dv_dy);
+
+            if ( v < 0 || v >= source->height || x_lo == x_hi )
+            {
+                memset(frame_row, 0, sizeof(uint16_t) * roi_img_width);
+                continue;
+            }
+
+            memset(frame_row, 0, sizeof(uint16_t) * x_lo);
+            patch_copy_run(source, u0 + (x_lo * du_dx), v, du_dx, &frame_row[x_lo], x_hi - x_lo);
+            memset(&frame_row[x_hi], 0, sizeof(uint16_t) * (roi_img_width - x_hi));
+        }
+
+        return;
+    }
+
+    // 90 and 270 degrees: screen rows are map columns, screen columns are map rows.
+    // Clear the screen area outside the map, then transpose in blocks
+    patch_clip_span(v0, dv_dx, source->height, roi_img_width, &x_lo, &x_hi);
+    patch_clip_span(u0, du_dy, source->width, roi_img_height, &y_lo, &y_hi);
+
+    for ( y = 0; y < roi_img_height; y++ )
+    {
+        frame_row = &frame[y * frame_pitch];
+        if ( y < y_lo || y >= y_hi || x_lo == x_hi )
+        {
+            memset(frame_row, 0, sizeof(uint16_t) * roi_img_width);
+        }
+        else
+        {
+            memset(frame_row, 0, sizeof(uint16_t) * x_lo);
+            memset(&frame_row[x_hi], 0, sizeof(uint16_t) * (roi_img_width - x_hi));
+        }
+    }
+
+    if ( x_lo == x_hi )
+        return;
+
+    for ( by = y_lo; by < y_hi; by += MAP_TILE_SIZE )
+    {
+        y_end = (by + MAP_TILE_SIZE < y_hi) ? by + MAP_TILE_SIZE : y_hi;
+
+        for ( bx = x_lo; bx < x_hi; bx += MAP_TILE_SIZE )
+        {
+            x_end = (bx + MAP_TILE_SIZE < x_hi) ? bx + MAP_TILE_SIZE : x_hi;
+
+            for ( x = bx; x < x_end; x++ )
+                row_offset[x - bx] = map_row_offset(v0 + (x * dv_dx), source->stride);
+
+            for ( y = by; y < y_end; y++ )
+            {
+                u = u0 + (y * du_dy);
+                map_col = &source->pixels[map_col_offset(u)];
+                frame_row = &frame[(y * frame_pitch) + bx];
+
+                for ( x = 0; x < (x_end - bx); x++ )
+                    frame_row[x] = map_col[row_offset[x]];
+            }
+        }
+    }
+}
+
+/********************************************************************
+ * patch_clip_span()
+ *
+ *  Find the range of screen positions 'i' in [0, count) for which
+ *  the map coordinate (a0 + i * da) is inside [0, limit).
+ *
+ *  param:  Map coordinate at screen position '0', step of +1 or -1,
+ *          map size along the axis, screen size along the axis,
+ *          pointers to output range [lo, hi)
+ *  return: None, 'lo' equals 'hi' if the range is empty
+ *
+ */
+static void patch_clip_span(int a0, int da, int limit, int count, int *lo, int *hi)
+{
+    if ( da > 0 )
+    {
+        *lo = -a0;
+        *hi = limit - a0;
+    }
+    else
+    {
+        *lo = a0 - limit + 1;
+        *hi = a0 + 1;
+    }
+
+    if ( *lo < 0 )
+        *lo = 0;
+    if ( *hi > count )
+        *hi = count;
+    if ( *hi < *lo )
+        *hi = *lo;
+}
+
+/********************************************************************
+ * patch_copy_run()
+ *
+ *  Copy a run of pixels along a map row into the screen buffer,
+ *  forward or reversed. In a tiled image the run is split at tile
+ *  boundaries, where each piece is contiguous.
+ *
+ *  param:  Pointer to map image source, map coordinates of first pixel,
+ *          step of +1 or -1, pointer to screen buffer, pixel count
+ *  return: None
+ *
+ */
+static void patch_copy_run(struct patch_source_t *source, int u, int v, int du, uint16_t *frame, int count)
+{
+    int     i, run;
+    const uint16_t *map_pixels;
+
+    while ( count > 0 )
+    {
+        map_pixels = &source->pixels[map_pixel_index(u, v, source->stride)];
+
+#if MAP_TILED_IMAGE
+        run = (du > 0) ? MAP_TILE_SIZE - (u & MAP_TILE_MASK) : (u & MAP_TILE_MASK) + 1;
+        if ( run > count )
+            run = count;
+#else
+        run = count;
+#endif
+
+        if ( du > 0 )
+        {
+            memcpy(frame, map_pixels, sizeof(uint16_t) * run);
+        }
+        else
+        {
+            for ( i = 0; i < run; i++ )
+                frame[i] = map_pixels[-i];
+        }
+
+        frame += run;
+        u += du * run;
+        count -= run;
+    }
+}
+
+/********************************************************************
+ * patch_kernel_scalar()
+ *
+ *  Portable map patch kernel. Walks the map image with the Q16
+ *  step deltas and copies one pixel at a time.
+ *
+ *  param:  Pointer to map image source,
+ *          pointer to screen buffer, its pitch, and width and height to render,
+ *          pointer to screen to map transform
+ *  return: None
+ *
+ */
+static void patch_kernel_scalar(struct patch_source_t *source, uint16_t *frame, int frame_pitch,
+                                int roi_img_width, int roi_img_height, struct patch_xform_t *xform)
+{
+    int     y, x, u, v;
+    int32_t u_row, v_row, u_q16, v_q16;
+    unsigned int    map_width, map_height, stride;
+    const uint16_t *image_buffer;
+
+    image_buffer = source->pixels;
+    map_width = (unsigned int)source->width;
+    map_height = (unsigned int)source->height;
+    stride = (unsigned int)source->stride;
+
+    u_row = xform->u_row;
+    v_row = xform->v_row;
+
+    for ( y = 0; y < roi_img_height; y++ )
+    {
+        u_q16 = u_row;
+        v_q16 = v_row;
+
+        for ( x = 0; x < roi_img_width; x++ )
+        {
+            u = u_q16 >> Q16_SHIFT;
+            v = v_q16 >> Q16_SHIFT;
+
+            // One unsigned compare also rejects negative coordinates
+            if ( (unsigned int)u < map_width && (unsigned int)v < map_height )
+                *frame++ = image_buffer[map_pixel_index(u, v, stride)];
+            else
+                *frame++ = ST7735_BLACK;
+
+            u_q16 += xform->du_dx;
+            v_q16 += xform->dv_dx;
+        }
+
+        frame += frame_pitch - roi_img_width;
+        u_row += xform->du_dy;
+        v_row += xform->dv_dy;
+    }
+}
+
+#if MAP_SIMD_NEON
+/********************************************************************
+ * patch_kernel_simd()
+ *
+ *  ARM NEON map patch kernel. Calculates four (u,v) map coordinates
+ *  per iteration, masks the ones that fall outside the map image, and
+ *  gathers the rest from the image buffer. Masked pixels are ST7735_BLACK.
+ *  Produces the same output as patch_kernel_scalar().
+ *
+ *  param:  Pointer to map image source,
+ *          pointer to screen buffer, its pitch, and width and height to render,
+ *          pointer to screen to map transform
+ *  return: None
+ *
+ */
+static void patch_kernel_simd(struct patch_source_t *source, uint16_t *frame, int frame_pitch,
+                              int roi_img_width, int roi_img_height, struct patch_xform_t *xform)
+{
+    static const int32_t lane_index[SIMD_LANES] = {0, 1, 2, 3};
+
+    int         y, x;
+    int32_t     u_row, v_row, u_pix, v_pix;
+    int32x4_t   u_q16, v_q16, du_step, dv_step, lanes;
+    uint32x4_t  u, v, in_map, img_index;
+    uint32x4_t  width_vec, height_vec, stride_vec;
+#if MAP_TILED_IMAGE
+    uint32x4_t  tile_mask;
+#endif
+    uint16x4_t  pixels;
+    const uint16_t *image_buffer;
+    int         map_width, map_height;
+
+    image_buffer = source->pixels;
+    map_width = source->width;
+    map_height = source->height;
+
+    lanes = vld1q_s32(lane_index);
+    du_step = vdupq_n_s32(xform->du_dx * SIMD_LANES);
+    dv_step = vdupq_n_s32(xform->dv_dx * SIMD_LANES);
+    width_vec = vdupq_n_u32((uint32_t)map_width);
+    height_vec = vdupq_n_u32((uint32_t)map_height);
+    stride_vec = vdupq_n_u32((uint32_t)source->stride);
+#if MAP_TILED_IMAGE
+    tile_mask = vdupq_n_u32(MAP_TILE_MASK);
+#endif
+
+    u_row = xform->u_row;
+    v_row = xform->v_row;
+
+    for ( y = 0; y < roi_img_height; y++ )
+    {
+        // Coordinates of the first four pixels in the row
+        u_q16 = vmlaq_n_s32(vdupq_n_s32(u_row), lanes, xform->du_dx);
+        v_q16 = vmlaq_n_s32(vdupq_n_s32(v_row), lanes, xform->dv_dx);
+
+        for ( x = 0; x <= (roi_img_width - SIMD_LANES); x += SIMD_LANES )
+        {
+            // Unsigned compare also rejects negative coordinates
+            u = vreinterpretq_u32_s32(vshrq_n_s32(u_q16, Q16_SHIFT));
+            v = vreinterpretq_u32_s32(vshrq_n_s32(v_q16, Q16_SHIFT));
+            in_map = vandq_u32(vcltq_u32(u, width_vec), vcltq_u32(v, height_vec));
+
+            // Out of map lanes are forced to index 0 so the gather stays in bounds
+#if MAP_TILED_IMAGE
+            img_index = vmlaq_u32(vshrq_n_u32(u, MAP_TILE_BITS), vshrq_n_u32(v, MAP_TILE_BITS), stride_vec);
+            img_index = vorrq_u32(vshlq_n_u32(img_index, 2 * MAP_TILE_BITS),
+                                  vorrq_u32(vshlq_n_u32(vandq_u32(v, tile_mask), MAP_TILE_BITS), vandq_u32(u, tile_mask)));
+            img_index = vandq_u32(img_index, in_map);
+#else
+            img_index = vandq_u32(vmlaq_u32(u, v, stride_vec), in_map);
+#endif
+
+            pixels = vdup_n_u16(0);
+            pixels = vset_lane_u16(image_buffer[vgetq_lane_u32(img_index, 0)], pixels, 0);
+            pixels = vset_lane_u16(image_buffer[vgetq_lane_u32(img_index, 1)], pixels, 1);
+            pixels = vset_lane_u16(image_buffer[vgetq_lane_u32(img_index, 2)], pixels, 2);
+            pixels = vset_lane_u16(image_buffer[vgetq_lane_u32(img_index, 3)], pixels, 3);
+
+            pixels = vand_u16(pixels, vmovn_u32(in_map));
+            vst1_u16(frame, pixels);
+            frame += SIMD_LANES;
+
+            u_q16 = vaddq_s32(u_q16, du_step);
+            v_q16 = vaddq_s32(v_q16, dv_step);
+        }
+
+        // Remaining pixels when the width is not a multiple of the lane count
+        for ( ; x < roi_img_width; x++ )
+        {
+            u_pix = (u_row + x * xform->du_dx) >> Q16_SHIFT;
+            v_pix = (v_row + x * xform->dv_dx) >> Q16_SHIFT;
+
+            if ( (uint32_t)u_pix < (uint32_t)map_width && (uint32_t)v_pix < (uint32_t)map_height )
+                *frame++ = image_buffer[map_pixel_index(u_pix, v_pix, source->stride)];
+            else
+                *frame++ = ST7735_BLACK;
+        }
+
+        frame += frame_pitch - roi_img_width;
+        u_row += xform->du_dy;
+        v_row += xform->dv_dy;
+    }
+}
+
+#elif MAP_SIMD_SSE2
+/********************************************************************
+ * patch_kernel_simd()
+ *
+ *  x86 SSE2 map patch kernel, used to benchmark and golden-test the
+ *  vectorized kernel on a development machine. Calculates four (u,v)
+ *  map coordinates per iteration, masks the ones that fall outside the
+ *  map image, and gathers the rest from the image buffer.
+ *  SSE2 has no 32-bit multiply, so the image (or tile) index is
+ *  calculated with a 16-bit multiply-add on signed (u,v) pairs. This limits
+ *  the image stride and height to 32767 pixels (or tiles), larger images
+ *  are rendered by the scalar kernel.
+ *  Produces the same output as patch_kernel_scalar().
+ *
+ *  param:  Pointer to map image source,
+ *          pointer to screen buffer, its pitch, and width and height to render,
+ *          pointer to screen to map transform
+ *  return: None
+ *
+ */
+static void patch_kernel_simd(struct patch_source_t *source, uint16_t *frame, int frame_pitch,
+                              int roi_img_width, int roi_img_height, struct patch_xform_t *xform)
+{
+    int         y, x;
+    int32_t     u_row, v_row, u_pix, v_pix;
+    int32_t     img_index[SIMD_LANES] __attribute__ ((aligned (16)));
+    int32_t     pixel_mask[SIMD_LANES] __attribute__ ((aligned (16)));
+    __m128i     u_q16, v_q16, du_step, dv_step;
+    __m128i     u, v, in_map, uv_pairs, index_mul, index_vec;
+    __m128i     width_vec, height_vec, minus_one;
+#if MAP_TILED_IMAGE
+    __m128i     tile_mask;
+#endif
+    const uint16_t *image_buffer;
+    int         map_width, map_height;
+
+    if ( source->stride > INT16_MAX || source->height > INT16_MAX )
+    {
+        patch_kernel_scalar(source, frame, frame_pitch, roi_img_width, roi_img_height, xform);
+        return;
+    }
+
+    image_buffer = source->pixels;
+    map_width = source->width;
+    map_height = source->height;
+
+    du_step = _mm_set1_epi32(xform->du_dx * SIMD_LANES);
+    dv_step = _mm_set1_epi32(xform->dv_dx * SIMD_LANES);
+    width_vec = _mm_set1_epi32(map_width);
+    height_vec = _mm_set1_epi32(map_height);
+    minus_one = _mm_set1_epi32(-1);
+    index_mul = _mm_set1_epi32(1 | (source->stride << 16));    // (u * 1) + (v * stride)
+#if MAP_TILED_IMAGE
+    tile_mask = _mm_set1_epi32(MAP_TILE_MASK);
+#endif
+
+    u_row = xform->u_row;
+    v_row = xform->v_row;
+
+    for ( y = 0; y < roi_img_height; y++ )
+    {
+        // Coordinates of the first four pixels in the row
+        u_q16 = _mm_add_epi32(_mm_set1_epi32(u_row), _mm_set_epi32(3 * xform->du_dx, 2 * xform->du_dx, xform->du_dx, 0));
+        v_q16 = _mm_add_epi32(_mm_set1_epi32(v_row), _mm_set_epi32(3 * xform->dv_dx, 2 * xform->dv_dx, xform->dv_dx, 0));
+
+        for ( x = 0; x <= (roi_img_width - SIMD_LANES); x += SIMD_LANES )
+        {
+            u = _mm_srai_epi32(u_q16, Q16_SHIFT);
+            v = _mm_srai_epi32(v_q16, Q16_SHIFT);
+
+            // Signed compares against -1 and the image size
+            in_map = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(u, minus_one), _mm_cmplt_epi32(u, width_vec)),
+                                   _mm_and_si128(_mm_cmpgt_epi32(v, minus_one), _mm_cmplt_epi32(v, height_vec)));
+
+            // Out of map lanes are forced to index 0 so the gather stays in bounds
+            u = _mm_and_si128(u, in_map);
+            v = _mm_and_si128(v, in_map);
+#if MAP_TILED_IMAGE
+            uv_pairs = _mm_or_si128(_mm_srli_epi32(u, MAP_TILE_BITS), _mm_slli_epi32(_mm_srli_epi32(v, MAP_TILE_BITS), 16));
+            index_vec = _mm_slli_epi32(_mm_madd_epi16(uv_pairs, index_mul), 2 * MAP_TILE_BITS);
+            index_vec = _mm_or_si128(index_vec, _mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, tile_mask), MAP_TILE_BITS),
+                                                             _mm_and_si128(u, tile_mask)));
+#else
+            uv_pairs = _mm_or_si128(u, _mm_slli_epi32(v, 16));
+            index_vec = _mm_madd_epi16(uv_pairs, index_mul);
+#endif
+            _mm_store_si128((__m128i *)img_index, index_vec);
+            _mm_store_si128((__m128i *)pixel_mask, in_map);
+
+            // SSE2 has no gather, so the loads and masking are done per lane
+            frame[0] = image_buffer[img_index[0]] & pixel_mask[0];
+            frame[1] = image_buffer[img_index[1]] & pixel_mask[1];
+            frame[2] = image_buffer[img_index[2]] & pixel_mask[2];
+            frame[3] = image_buffer[img_index[3]] & pixel_mask[3];
+            frame += SIMD_LANES;
+
+            u_q16 = _mm_add_epi32(u_q16, du_step);
+            v_q16 = _mm_add_epi32(v_q16, dv_step);
+        }
+
+        // Remaining pixels when the width is not a multiple of the lane count
+        for ( ; x < roi_img_width; x++ )
+        {
+            u_pix = (u_row + x * xform->du_dx) >> Q16_SHIFT;
+            v_pix = (v_row + x * xform->dv_dx) >> Q16_SHIFT;
+
+            if ( (uint32_t)u_pix < (uint32_t)map_width && (uint32_t)v_pix < (uint32_t)map_height )
+                *frame++ = image_buffer[map_pixel_index(u_pix, v_pix, source->stride)];
+            else
+                *frame++ = ST7735_BLACK;
+        }
+
+        frame += frame_pitch - roi_img_width;
+        u_row += xform->du_dy;
+        v_row += xform->dv_dy;
+
+    }
+}
+#endif
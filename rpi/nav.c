@@ -15,13 +15,16 @@
 #include    <string.h>
 #include    <fcntl.h>
 #include    <errno.h>
-#include    <termios.h>
+#include    <poll.h>
 #include    <math.h>
 
 #include    "nav.h"
+#include    "map.h"
 #include    "pilcd.h"
 #include    "vt100lcd.h"
 #include    "util.h"
+#include    "gps.h"
+#include    "hal.h"
 #include    "config.h"
 
 /********************************************************************
@@ -45,7 +48,6 @@
                                 "Revision 1.0, Mar. 24 2018\r\n"    \
                                 "Eyal Abraham (c)"
 #define     NOT_IMPLEMENTED     "\e[8;2f\e[31;40mNOT IMPLEMENTED"
-#define     FRAME_BUFF_SIZE     (ST7735_TFTWIDTH*ST7735_TFTHEIGHT)
 
 // Navigator state
 #define     STATE_INIT          0
@@ -64,12 +66,17 @@
 #define     MAIN_MENU_BOTTOM    3
 
 // GO and Logger
-#define     USB_DIR             "/home/pi/usb"
 #define     GO_FILE             "/home/pi/usb/go"
 #define     LOGGER_FILE         "/home/pi/usb/logger.csv"
 #define     MAP_XML_FILE        "/home/pi/usb/maps.xml"
 //#define     MAP_XML_FILE        "/home/pi/usb/sample.xml"
 
+// Breadcrumb trail drawn over the map
+#define     TRAIL_POINTS        4096            // trail length, the older half is dropped when full
+#define     TRAIL_MIN_MOVE      0.00002         // degrees of move between trail points, about 2m
+#define     TRAIL_WIDTH         2               // line width in pixels
+#define     TRAIL_COLOR         ST7735_MAGENTA
+
 /********************************************************************
  * Static function prototypes
  *
@@ -80,738 +87,7 @@ static void menu_print(int);
 static void msg_not_implemented(void);
 static void gps_data(int);
 static void gps_map_nav(void);
-static uint16_t *load_map_image(struct map_t *);
-static void get_map_patch(struct position_t *, struct map_t *, uint16_t *);
-
-/********************************************************************
- * Static SIN() and COS() tables for integer angles in *degrees*
- *
- */
-static double SIN[] = {
-        0.0,
-        0.0174524064373,
-        0.0348994967025,
-        0.0523359562429,
-        0.0697564737441,
-        0.0871557427477,
-        0.104528463268,
-        0.121869343405,
-        0.13917310096,
-        0.15643446504,
-        0.173648177667,
-        0.190808995377,
-        0.207911690818,
-        0.224951054344,
-        0.2419218956,
-        0.258819045103,
-        0.275637355817,
-        0.292371704723,
-        0.309016994375,
-        0.325568154457,
-        0.342020143326,
-        0.358367949545,
-        0.374606593416,
-        0.390731128489,
-        0.406736643076,
-        0.422618261741,
-        0.438371146789,
-        0.45399049974,
-        0.469471562786,
-        0.484809620246,
-        0.5,
-        0.51503807491,
-        0.529919264233,
-        0.544639035015,
-        0.559192903471,
-        0.573576436351,
-        0.587785252292,
-        0.601815023152,
-        0.615661475326,
-        0.62932039105,
-        0.642787609687,
-        0.656059028991,
-        0.669130606359,
-        0.681998360062,
-        0.694658370459,
-        0.707106781187,
-        0.719339800339,
-        0.731353701619,
-        0.743144825477,
-        0.754709580223,
-        0.766044443119,
-        0.777145961457,
-        0.788010753607,
-        0.798635510047,
-        0.809016994375,
-        0.819152044289,
-        0.829037572555,
-        0.838670567945,
-        0.848048096156,
-        0.857167300702,
-        0.866025403784,
-        0.874619707139,
-        0.882947592859,
-        0.891006524188,
-        0.898794046299,
-        0.906307787037,
-        0.913545457643,
-        0.920504853452,
-        0.927183854567,
-        0.933580426497,
-        0.939692620786,
-        0.945518575599,
-        0.951056516295,
-        0.956304755963,
-        0.961261695938,
-        0.965925826289,
-        0.970295726276,
-        0.974370064785,
-        0.978147600734,
-        0.981627183448,
-        0.984807753012,
-        0.987688340595,
-        0.990268068742,
-        0.992546151641,
-        0.994521895368,
-        0.996194698092,
-        0.99756405026,
-        0.998629534755,
-        0.999390827019,
-        0.999847695156,
-        1.0,
-        0.999847695156,
-        0.999390827019,
-        0.998629534755,
-        0.99756405026,
-        0.996194698092,
-        0.994521895368,
-        0.992546151641,
-        0.990268068742,
-        0.987688340595,
-        0.984807753012,
-        0.981627183448,
-        0.978147600734,
-        0.974370064785,
-        0.970295726276,
-        0.965925826289,
-        0.961261695938,
-        0.956304755963,
-        0.951056516295,
-        0.945518575599,
-        0.939692620786,
-        0.933580426497,
-        0.927183854567,
-        0.920504853452,
-        0.913545457643,
-        0.906307787037,
-        0.898794046299,
-        0.891006524188,
-        0.882947592859,
-        0.874619707139,
-        0.866025403784,
-        0.857167300702,
-        0.848048096156,
-        0.838670567945,
-        0.829037572555,
-        0.819152044289,
-        0.809016994375,
-        0.798635510047,
-        0.788010753607,
-        0.777145961457,
-        0.766044443119,
-        0.754709580223,
-        0.743144825477,
-        0.731353701619,
-        0.719339800339,
-        0.707106781187,
-        0.694658370459,
-        0.681998360062,
-        0.669130606359,
-        0.656059028991,
-        0.642787609687,
-        0.62932039105,
-        0.615661475326,
-        0.601815023152,
-        0.587785252292,
-        0.573576436351,
-        0.559192903471,
-        0.544639035015,
-        0.529919264233,
-        0.51503807491,
-        0.5,
-        0.484809620246,
-        0.469471562786,
-        0.45399049974,
-        0.438371146789,
-        0.422618261741,
-        0.406736643076,
-        0.390731128489,
-        0.374606593416,
-        0.358367949545,
-        0.342020143326,
-        0.325568154457,
-        0.309016994375,
-        0.292371704723,
-        0.275637355817,
-        0.258819045103,
-        0.2419218956,
-        0.224951054344,
-        0.207911690818,
-        0.190808995377,
-        0.173648177667,
-        0.15643446504,
-        0.13917310096,
-        0.121869343405,
-        0.104528463268,
-        0.0871557427477,
-        0.0697564737441,
-        0.0523359562429,
-        0.0348994967025,
-        0.0174524064373,
-        1.22464679915e-16,
-        -0.0174524064373,
-        -0.0348994967025,
-        -0.0523359562429,
-        -0.0697564737441,
-        -0.0871557427477,
-        -0.104528463268,
-        -0.121869343405,
-        -0.13917310096,
-        -0.15643446504,
-        -0.173648177667,
-        -0.190808995377,
-        -0.207911690818,
-        -0.224951054344,
-        -0.2419218956,
-        -0.258819045103,
-        -0.275637355817,
-        -0.292371704723,
-        -0.309016994375,
-        -0.325568154457,
-        -0.342020143326,
-        -0.358367949545,
-        -0.374606593416,
-        -0.390731128489,
-        -0.406736643076,
-        -0.422618261741,
-        -0.438371146789,
-        -0.45399049974,
-        -0.469471562786,
-        -0.484809620246,
-        -0.5,
-        -0.51503807491,
-        -0.529919264233,
-        -0.544639035015,
-        -0.559192903471,
-        -0.573576436351,
-        -0.587785252292,
-        -0.601815023152,
-        -0.615661475326,
-        -0.62932039105,
-        -0.642787609687,
-        -0.656059028991,
-        -0.669130606359,
-        -0.681998360062,
-        -0.694658370459,
-        -0.707106781187,
-        -0.719339800339,
-        -0.731353701619,
-        -0.743144825477,
-        -0.754709580223,
-        -0.766044443119,
-        -0.777145961457,
-        -0.788010753607,
-        -0.798635510047,
-        -0.809016994375,
-        -0.819152044289,
-        -0.829037572555,
-        -0.838670567945,
-        -0.848048096156,
-        -0.857167300702,
-        -0.866025403784,
-        -0.874619707139,
-        -0.882947592859,
-        -0.891006524188,
-        -0.898794046299,
-        -0.906307787037,
-        -0.913545457643,
-        -0.920504853452,
-        -0.927183854567,
-        -0.933580426497,
-        -0.939692620786,
-        -0.945518575599,
-        -0.951056516295,
-        -0.956304755963,
-        -0.961261695938,
-        -0.965925826289,
-        -0.970295726276,
-        -0.974370064785,
-        -0.978147600734,
-        -0.981627183448,
-        -0.984807753012,
-        -0.987688340595,
-        -0.990268068742,
-        -0.992546151641,
-        -0.994521895368,
-        -0.996194698092,
-        -0.99756405026,
-        -0.998629534755,
-        -0.999390827019,
-        -0.999847695156,
-        -1.0,
-        -0.999847695156,
-        -0.999390827019,
-        -0.998629534755,
-        -0.99756405026,
-        -0.996194698092,
-        -0.994521895368,
-        -0.992546151641,
-        -0.990268068742,
-        -0.987688340595,
-        -0.984807753012,
-        -0.981627183448,
-        -0.978147600734,
-        -0.974370064785,
-        -0.970295726276,
-        -0.965925826289,
-        -0.961261695938,
-        -0.956304755963,
-        -0.951056516295,
-        -0.945518575599,
-        -0.939692620786,
-        -0.933580426497,
-        -0.927183854567,
-        -0.920504853452,
-        -0.913545457643,
-        -0.906307787037,
-        -0.898794046299,
-        -0.891006524188,
-        -0.882947592859,
-        -0.874619707139,
-        -0.866025403784,
-        -0.857167300702,
-        -0.848048096156,
-        -0.838670567945,
-        -0.829037572555,
-        -0.819152044289,
-        -0.809016994375,
-        -0.798635510047,
-        -0.788010753607,
-        -0.777145961457,
-        -0.766044443119,
-        -0.754709580223,
-        -0.743144825477,
-        -0.731353701619,
-        -0.719339800339,
-        -0.707106781187,
-        -0.694658370459,
-        -0.681998360062,
-        -0.669130606359,
-        -0.656059028991,
-        -0.642787609687,
-        -0.62932039105,
-        -0.615661475326,
-        -0.601815023152,
-        -0.587785252292,
-        -0.573576436351,
-        -0.559192903471,
-        -0.544639035015,
-        -0.529919264233,
-        -0.51503807491,
-        -0.5,
-        -0.484809620246,
-        -0.469471562786,
-        -0.45399049974,
-        -0.438371146789,
-        -0.422618261741,
-        -0.406736643076,
-        -0.390731128489,
-        -0.374606593416,
-        -0.358367949545,
-        -0.342020143326,
-        -0.325568154457,
-        -0.309016994375,
-        -0.292371704723,
-        -0.275637355817,
-        -0.258819045103,
-        -0.2419218956,
-        -0.224951054344,
-        -0.207911690818,
-        -0.190808995377,
-        -0.173648177667,
-        -0.15643446504,
-        -0.13917310096,
-        -0.121869343405,
-        -0.104528463268,
-        -0.0871557427477,
-        -0.0697564737441,
-        -0.0523359562429,
-        -0.0348994967025,
-        -0.0174524064373
-};
-
-static double COS[] = {
-        1.0,
-        0.999847695156,
-        0.999390827019,
-        0.998629534755,
-        0.99756405026,
-        0.996194698092,
-        0.994521895368,
-        0.992546151641,
-        0.990268068742,
-        0.987688340595,
-        0.984807753012,
-        0.981627183448,
-        0.978147600734,
-        0.974370064785,
-        0.970295726276,
-        0.965925826289,
-        0.961261695938,
-        0.956304755963,
-        0.951056516295,
-        0.945518575599,
-        0.939692620786,
-        0.933580426497,
-        0.927183854567,
-        0.920504853452,
-        0.913545457643,
-        0.906307787037,
-        0.898794046299,
-        0.891006524188,
-        0.882947592859,
-        0.874619707139,
-        0.866025403784,
-        0.857167300702,
-        0.848048096156,
-        0.838670567945,
-        0.829037572555,
-        0.819152044289,
-        0.809016994375,
-        0.798635510047,
-        0.788010753607,
-        0.777145961457,
-        0.766044443119,
-        0.754709580223,
-        0.743144825477,
-        0.731353701619,
-        0.719339800339,
-        0.707106781187,
-        0.694658370459,
-        0.681998360062,
-        0.669130606359,
-        0.656059028991,
-        0.642787609687,
-        0.62932039105,
-        0.615661475326,
-        0.601815023152,
-        0.587785252292,
-        0.573576436351,
-        0.559192903471,
-        0.544639035015,
-        0.529919264233,
-        0.51503807491,
-        0.5,
-        0.484809620246,
-        0.469471562786,
-        0.45399049974,
-        0.438371146789,
-        0.422618261741,
-        0.406736643076,
-        0.390731128489,
-        0.374606593416,
-        0.358367949545,
-        0.342020143326,
-        0.325568154457,
-        0.309016994375,
-        0.292371704723,
-        0.275637355817,
-        0.258819045103,
-        0.2419218956,
-        0.224951054344,
-        0.207911690818,
-        0.190808995377,
-        0.173648177667,
-        0.15643446504,
-        0.13917310096,
-        0.121869343405,
-        0.104528463268,
-        0.0871557427477,
-        0.0697564737441,
-        0.0523359562429,
-        0.0348994967025,
-        0.0174524064373,
-        6.12323399574e-17,
-        -0.0174524064373,
-        -0.0348994967025,
-        -0.0523359562429,
-        -0.0697564737441,
-        -0.0871557427477,
-        -0.104528463268,
-        -0.121869343405,
-        -0.13917310096,
-        -0.15643446504,
-        -0.173648177667,
-        -0.190808995377,
-        -0.207911690818,
-        -0.224951054344,
-        -0.2419218956,
-        -0.258819045103,
-        -0.275637355817,
-        -0.292371704723,
-        -0.309016994375,
-        -0.325568154457,
-        -0.342020143326,
-        -0.358367949545,
-        -0.374606593416,
-        -0.390731128489,
-        -0.406736643076,
-        -0.422618261741,
-        -0.438371146789,
-        -0.45399049974,
-        -0.469471562786,
-        -0.484809620246,
-        -0.5,
-        -0.51503807491,
-        -0.529919264233,
-        -0.544639035015,
-        -0.559192903471,
-        -0.573576436351,
-        -0.587785252292,
-        -0.601815023152,
-        -0.615661475326,
-        -0.62932039105,
-        -0.642787609687,
-        -0.656059028991,
-        -0.669130606359,
-        -0.681998360062,
-        -0.694658370459,
-        -0.707106781187,
-        -0.719339800339,
-        -0.731353701619,
-        -0.743144825477,
-        -0.754709580223,
-        -0.766044443119,
-        -0.777145961457,
-        -0.788010753607,
-        -0.798635510047,
-        -0.809016994375,
-        -0.819152044289,
-        -0.829037572555,
-        -0.838670567945,
-        -0.848048096156,
-        -0.857167300702,
-        -0.866025403784,
-        -0.874619707139,
-        -0.882947592859,
-        -0.891006524188,
-        -0.898794046299,
-        -0.906307787037,
-        -0.913545457643,
-        -0.920504853452,
-        -0.927183854567,
-        -0.933580426497,
-        -0.939692620786,
-        -0.945518575599,
-        -0.951056516295,
-        -0.956304755963,
-        -0.961261695938,
-        -0.965925826289,
-        -0.970295726276,
-        -0.974370064785,
-        -0.978147600734,
-        -0.981627183448,
-        -0.984807753012,
-        -0.987688340595,
-        -0.990268068742,
-        -0.992546151641,
-        -0.994521895368,
-        -0.996194698092,
-        -0.99756405026,
-        -0.998629534755,
-        -0.999390827019,
-        -0.999847695156,
-        -1.0,
-        -0.999847695156,
-        -0.999390827019,
-        -0.998629534755,
-        -0.99756405026,
-        -0.996194698092,
-        -0.994521895368,
-        -0.992546151641,
-        -0.990268068742,
-        -0.987688340595,
-        -0.984807753012,
-        -0.981627183448,
-        -0.978147600734,
-        -0.974370064785,
-        -0.970295726276,
-        -0.965925826289,
-        -0.961261695938,
-        -0.956304755963,
-        -0.951056516295,
-        -0.945518575599,
-        -0.939692620786,
-        -0.933580426497,
-        -0.927183854567,
-        -0.920504853452,
-        -0.913545457643,
-        -0.906307787037,
-        -0.898794046299,
-        -0.891006524188,
-        -0.882947592859,
-        -0.874619707139,
-        -0.866025403784,
-        -0.857167300702,
-        -0.848048096156,
-        -0.838670567945,
-        -0.829037572555,
-        -0.819152044289,
-        -0.809016994375,
-        -0.798635510047,
-        -0.788010753607,
-        -0.777145961457,
-        -0.766044443119,
-        -0.754709580223,
-        -0.743144825477,
-        -0.731353701619,
-        -0.719339800339,
-        -0.707106781187,
-        -0.694658370459,
-        -0.681998360062,
-        -0.669130606359,
-        -0.656059028991,
-        -0.642787609687,
-        -0.62932039105,
-        -0.615661475326,
-        -0.601815023152,
-        -0.587785252292,
-        -0.573576436351,
-        -0.559192903471,
-        -0.544639035015,
-        -0.529919264233,
-        -0.51503807491,
-        -0.5,
-        -0.484809620246,
-        -0.469471562786,
-        -0.45399049974,
-        -0.438371146789,
-        -0.422618261741,
-        -0.406736643076,
-        -0.390731128489,
-        -0.374606593416,
-        -0.358367949545,
-        -0.342020143326,
-        -0.325568154457,
-        -0.309016994375,
-        -0.292371704723,
-        -0.275637355817,
-        -0.258819045103,
-        -0.2419218956,
-        -0.224951054344,
-        -0.207911690818,
-        -0.190808995377,
-        -0.173648177667,
-        -0.15643446504,
-        -0.13917310096,
-        -0.121869343405,
-        -0.104528463268,
-        -0.0871557427477,
-        -0.0697564737441,
-        -0.0523359562429,
-        -0.0348994967025,
-        -0.0174524064373,
-        -1.83697019872e-16,
-        0.0174524064373,
-        0.0348994967025,
-        0.0523359562429,
-        0.0697564737441,
-        0.0871557427477,
-        0.104528463268,
-        0.121869343405,
-        0.13917310096,
-        0.15643446504,
-        0.173648177667,
-        0.190808995377,
-        0.207911690818,
-        0.224951054344,
-        0.2419218956,
-        0.258819045103,
-        0.275637355817,
-        0.292371704723,
-        0.309016994375,
-        0.325568154457,
-        0.342020143326,
-        0.358367949545,
-        0.374606593416,
-        0.390731128489,
-        0.406736643076,
-        0.422618261741,
-        0.438371146789,
-        0.45399049974,
-        0.469471562786,
-        0.484809620246,
-        0.5,
-        0.51503807491,
-        0.529919264233,
-        0.544639035015,
-        0.559192903471,
-        0.573576436351,
-        0.587785252292,
-        0.601815023152,
-        0.615661475326,
-        0.62932039105,
-        0.642787609687,
-        0.656059028991,
-        0.669130606359,
-        0.681998360062,
-        0.694658370459,
-        0.707106781187,
-        0.719339800339,
-        0.731353701619,
-        0.743144825477,
-        0.754709580223,
-        0.766044443119,
-        0.777145961457,
-        0.788010753607,
-        0.798635510047,
-        0.809016994375,
-        0.819152044289,
-        0.829037572555,
-        0.838670567945,
-        0.848048096156,
-        0.857167300702,
-        0.866025403784,
-        0.874619707139,
-        0.882947592859,
-        0.891006524188,
-        0.898794046299,
-        0.906307787037,
-        0.913545457643,
-        0.920504853452,
-        0.927183854567,
-        0.933580426497,
-        0.939692620786,
-        0.945518575599,
-        0.951056516295,
-        0.956304755963,
-        0.961261695938,
-        0.965925826289,
-        0.970295726276,
-        0.974370064785,
-        0.978147600734,
-        0.981627183448,
-        0.984807753012,
-        0.987688340595,
-        0.990268068742,
-        0.992546151641,
-        0.994521895368,
-        0.996194698092,
-        0.99756405026,
-        0.998629534755,
-        0.999390827019,
-        0.999847695156
-};
+static void trail_append(struct position_t *);
 
 /********************************************************************
  * Module globals
@@ -825,14 +101,12 @@ static char *menu_item[] = {" Map        ", " GPS Data   ", " GPS Logger ", " Sh
 static int   state = STATE_INIT;
 static int   usb_mounted = 0;
 static int   uart_fd;
-static union frame_buffer_t
-{
-    uint16_t pixel_words[FRAME_BUFF_SIZE];
-    uint8_t  pixel_bytes[2*FRAME_BUFF_SIZE];
-} frame_buffer;
+static uint16_t *frame_buffer = NULL;               // back buffer of the double buffered display
 static struct position_t  pos;
 static struct map_t *map_list = NULL;
 static uint16_t *map_image = NULL;
+static struct geo_point_t trail[TRAIL_POINTS];      // breadcrumb trail of valid fixes
+static int   trail_count = 0;
 
 /********************************************************************
  * navigator()
@@ -888,10 +162,11 @@ int navigator(void)
             case STATE_MAIN_MENU:
                 // Initialize main screen and menu
                 menu_selection = MAIN_MENU_MAP;
-                lcdFrameBufferColor(frame_buffer.pixel_bytes, SYS_BG_COLOR);
-                vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "%s", GREETING);
+                lcdFrameBufferColor(frame_buffer, SYS_BG_COLOR);
+                vt100_lcd_invalidate();
+                vt100_lcd_printf(frame_buffer, 0, "%s", GREETING);
                 menu_print(menu_selection);
-                lcdFrameBufferPush(frame_buffer.pixel_bytes);
+                frame_buffer = lcdDisplaySwap();
 
                 // Loop to read push buttons and activate menu
                 while ( state == STATE_MAIN_MENU )
@@ -940,7 +215,7 @@ int navigator(void)
 
                     // Update the menu
                     menu_print(menu_selection);
-                    lcdFrameBufferPush(frame_buffer.pixel_bytes);
+                    frame_buffer = lcdDisplaySwap();
                 }
                 break;
 
@@ -961,8 +236,9 @@ int navigator(void)
 
             case STATE_EXIT:
                 // Clear screen and exit state machine
-                lcdFrameBufferColor(frame_buffer.pixel_bytes, SYS_BG_COLOR);
-                lcdFrameBufferPush(frame_buffer.pixel_bytes);
+                lcdFrameBufferColor(frame_buffer, SYS_BG_COLOR);
+                vt100_lcd_invalidate();
+                frame_buffer = lcdDisplaySwap();
                 close_navigator = 1;
                 break;
 
@@ -993,92 +269,104 @@ int navigator(void)
 static int gpio_init(void)
 {
     // try to initialize GPIO subsystem
-    if ( !bcm2835_init() )
+    if ( hal_init() == -1 )
     {
-        printf("         %s bcm2835_init failed. Are you running as root?\n", STATUS_FAIL);
+        printf("         %s hal_init failed. Are you running as root?\n", STATUS_FAIL);
         return -1;
     }
 
     printf("         %s Initialized GPIO\n", STATUS_OK);
 
-    // Initialize RST GPIO pin
-    bcm2835_gpio_fsel(LCD_RST, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_write(LCD_RST, HIGH);
-
-    // Initialize SPI
-    if (!bcm2835_spi_begin())
+    // Initialize the LCD SPI bus and reset the LCD
+    if ( lcdBusInit() == -1 )
     {
-        printf("         %s bcm2835_spi_begin failed. Are you running as root?\n", STATUS_FAIL);
+        printf("         %s lcdBusInit failed. Is the SPI bus accessible?\n", STATUS_FAIL);
         // Close GPIO
-        bcm2835_close();
+        hal_close();
 
         return -1;
     }
 
-    // Initialize SPI for the LCD according to wiring
-    bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
-    bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
-    bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_8);
-    bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
-    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
-
     printf("         %s Initialized SPI\n", STATUS_OK);
 
-    // Reset the devices on the SPI bus
-    bcm2835_gpio_write(LCD_RST, LOW);
-    bcm2835_delay(250);
-    bcm2835_gpio_write(LCD_RST, HIGH);
-
     // LCD initialization and test
     lcdInit();
     lcdSetRotation(LCD_ROTATION);
-    lcdFrameBufferColor(frame_buffer.pixel_bytes, SYS_BG_COLOR);
-    lcdFrameBufferPush(frame_buffer.pixel_bytes);
+
+    frame_buffer = lcdDisplayInit(SYS_BG_COLOR);
+    if ( frame_buffer == NULL )
+    {
+        printf("         %s lcdDisplayInit failed.\n", STATUS_FAIL);
+        // Close SPI
+        lcdBusClose();
+        // Close GPIO
+        hal_close();
+
+        return -1;
+    }
+    frame_buffer = lcdDisplaySwap();
 
     vt100_lcd_init(LCD_ROTATION, 1, SYS_BG_COLOR, SYS_FG_COLOR);
 
     printf("         %s Initialized LCD\n", STATUS_OK);
 
     // Initialize GPIO pins for input with pull-up enabled
-    bcm2835_gpio_fsel(PBUTTON_UP, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_UP, BCM2835_GPIO_PUD_UP);
-
-    bcm2835_gpio_fsel(PBUTTON_DOWN, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_DOWN, BCM2835_GPIO_PUD_UP);
-
-    bcm2835_gpio_fsel(PBUTTON_LEFT, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_LEFT, BCM2835_GPIO_PUD_UP);
-
-    bcm2835_gpio_fsel(PBUTTON_RIGHT, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_RIGHT, BCM2835_GPIO_PUD_UP);
+    if ( hal_gpio_input(PBUTTON_UP) == -1 ||
+         hal_gpio_input(PBUTTON_DOWN) == -1 ||
+         hal_gpio_input(PBUTTON_LEFT) == -1 ||
+         hal_gpio_input(PBUTTON_RIGHT) == -1 ||
+         hal_gpio_input(PBUTTON_SELECT) == -1 )
+    {
+        printf("         %s Error setting up pushbutton IO pins\n", STATUS_FAIL);
+        // Stop display thread
+        lcdDisplayClose();
+        // Close SPI
+        lcdBusClose();
+        // Close GPIO
+        hal_close();
 
-    bcm2835_gpio_fsel(PBUTTON_SELECT, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_SELECT, BCM2835_GPIO_PUD_UP);
+        return -1;
+    }
 
     printf("         %s Initialized pushbutton IO pins\n", STATUS_OK);
 
     // Open UART0 port
-    uart_fd = open(UART0, O_RDWR | O_NOCTTY | O_NDELAY);
+    uart_fd = hal_uart_open();
     if ( uart_fd == -1 )
     {
         printf("         %s Error %d opening %s\n", STATUS_FAIL, errno, UART0);
+        // Stop display thread
+        lcdDisplayClose();
         // Close SPI
-        bcm2835_spi_end();
+        lcdBusClose();
         // Close GPIO
-        bcm2835_close();
+        hal_close();
 
         return -1;
     }
     else
     {
-        // Setup UART options
-        uart_set_interface_attr(uart_fd, B9600, 0);
-        uart_set_blocking(uart_fd, 0);
-        fcntl(uart_fd, F_SETFL, FNDELAY);
-
         printf("         %s Initialized UART0 %s\n", STATUS_OK, UART0);
     }
 
+    // Start GPS ingest thread, NMEA sentences are read and parsed
+    // by the thread and the screens read the queued fixes
+    if ( gps_open(uart_fd) == -1 )
+    {
+        printf("         %s Error starting GPS thread\n", STATUS_FAIL);
+        close(uart_fd);
+        // Stop display thread
+        lcdDisplayClose();
+        // Close SPI
+        lcdBusClose();
+        // Close GPIO
+        hal_close();
+
+        return -1;
+    }
+
+    printf("         %s Started GPS thread\n", STATUS_OK);
+
     return 0;
 }
 
@@ -1093,10 +381,14 @@ static int gpio_init(void)
  */
 static void gpio_shutdown(void)
 {
+    // Stop GPS thread
+    gps_close();
+    // Stop display thread after its last push
+    lcdDisplayClose();
     // Close SPI
-    bcm2835_spi_end();
+    lcdBusClose();
     // Close GPIO
-    bcm2835_close();
+    hal_close();
     // Close the port and exit
     close(uart_fd);
 
@@ -1121,11 +413,11 @@ static void menu_print(int highlight_item)
     {
         if ( i == highlight_item )
         {
-            vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[%1d;2f%s%s%s", row, SYS_FONT_INV, menu_item[i], SYS_FONT_NORM);
+            vt100_lcd_printf(frame_buffer, 0, "\e[%1d;2f%s%s%s", row, SYS_FONT_INV, menu_item[i], SYS_FONT_NORM);
         }
         else
         {
-            vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[%1d;2f%s", row, menu_item[i]);
+            vt100_lcd_printf(frame_buffer, 0, "\e[%1d;2f%s", row, menu_item[i]);
         }
     }
 }
@@ -1141,16 +433,19 @@ static void menu_print(int highlight_item)
  */
 static void msg_not_implemented(void)
 {
-    lcdFrameBufferColor(frame_buffer.pixel_bytes, SYS_BG_COLOR);
-    vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "%s%s", NOT_IMPLEMENTED, SYS_FONT_NORM);
-    lcdFrameBufferPush(frame_buffer.pixel_bytes);
-    bcm2835_delay(2000);
+    lcdFrameBufferColor(frame_buffer, SYS_BG_COLOR);
+    vt100_lcd_invalidate();
+    vt100_lcd_printf(frame_buffer, 0, "%s%s", NOT_IMPLEMENTED, SYS_FONT_NORM);
+    frame_buffer = lcdDisplaySwap();
+    hal_delay(2000);
 }
 
 /********************************************************************
  * gps_data()
  *
  *  Read GPS NMEA data, parse, and print on screen.
+ *  The screen is redrawn on frame timer ticks (FRAME_RATE), and only
+ *  if the position or a message on screen changed.
  *  Exit back to main menu if "LEFT" button is pressed.
  *  This function serves a dual purpose, it can also log
  *  GPS location to a logger file for off-line plotting.
@@ -1165,16 +460,43 @@ static void gps_data(int logger_on)
 {
     int     time_invalid_fix = 0;
     char    heart_beat = '*';
-    char    nmea_text[128] = {0};
+    char    log_text[128] = {0};
     int     logger_fd = -1;
     int     logged_points = 0;
 
-    int     read_result;
     int     valid_fix;
-
-    // Format screen
-    lcdFrameBufferColor(frame_buffer.pixel_bytes, SYS_BG_COLOR);
-    vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[HPress 'LEFT' to exit.");
+    int     pos_changed = 0;
+    int     redraw = 1;
+    int     frame_timer_fd;
+    int     field_hour, field_min, field_sec;
+    int     field_lat, field_long, field_sats;
+    int     field_speed, field_heading, field_logged;
+    struct position_t   last_pos;
+    struct gps_fix_t    fix;
+    struct pollfd       poll_fds[2];
+
+    // Format screen, the labels are printed once and the
+    // data is updated through numeric fields
+    lcdFrameBufferColor(frame_buffer, SYS_BG_COLOR);
+    vt100_lcd_invalidate();
+    vt100_lcd_printf(frame_buffer, 0, "\e[HPress 'LEFT' to exit.");
+    vt100_lcd_printf(frame_buffer, 0, "\e[3;0fUTC Time   :  :");
+    vt100_lcd_printf(frame_buffer, 0, "\e[4;0fLatitude");
+    vt100_lcd_printf(frame_buffer, 0, "\e[5;0fLongitude");
+    vt100_lcd_printf(frame_buffer, 0, "\e[6;0fSatellites");
+    vt100_lcd_printf(frame_buffer, 0, "\e[7;0fGround speed        [mph]");
+    vt100_lcd_printf(frame_buffer, 0, "\e[8;0fHeading       [deg]");
+
+    vt100_lcd_field_reset();
+    field_hour = vt100_lcd_field(3, 9, 2, 0, VT100_FIELD_ZERO, SYS_FG_COLOR, SYS_BG_COLOR);
+    field_min = vt100_lcd_field(3, 12, 2, 0, VT100_FIELD_ZERO, SYS_FG_COLOR, SYS_BG_COLOR);
+    field_sec = vt100_lcd_field(3, 15, 6, 3, VT100_FIELD_ZERO, SYS_FG_COLOR, SYS_BG_COLOR);
+    field_lat = vt100_lcd_field(4, 9, 10, 6, VT100_FIELD_LEFT, SYS_FG_COLOR, SYS_BG_COLOR);
+    field_long = vt100_lcd_field(5, 10, 11, 6, VT100_FIELD_LEFT, SYS_FG_COLOR, SYS_BG_COLOR);
+    field_sats = vt100_lcd_field(6, 11, 2, 0, VT100_FIELD_LEFT, SYS_FG_COLOR, SYS_BG_COLOR);
+    field_speed = vt100_lcd_field(7, 13, 6, 2, VT100_FIELD_LEFT, SYS_FG_COLOR, SYS_BG_COLOR);
+    field_heading = vt100_lcd_field(8, 8, 5, 1, VT100_FIELD_LEFT, SYS_FG_COLOR, SYS_BG_COLOR);
+    field_logged = -1;
 
     // Initialize logger
     if ( logger_on && usb_mounted )
@@ -1185,92 +507,143 @@ static void gps_data(int logger_on)
         // Print once heading per logging session
         if ( logger_fd != -1 )
         {
-            sprintf(nmea_text, "#\n# GPS logger\n#\n");
-            write(logger_fd, nmea_text, strlen(nmea_text));
-            sprintf(nmea_text, "#logged_points,gga_time,latitude,longitude,ground_spd,heading\n");
-            write(logger_fd, nmea_text, strlen(nmea_text));
+            sprintf(log_text, "#\n# GPS logger\n#\n");
+            write(logger_fd, log_text, strlen(log_text));
+            sprintf(log_text, "#logged_points,gga_time,latitude,longitude,ground_spd,heading\n");
+            write(logger_fd, log_text, strlen(log_text));
+
+            vt100_lcd_printf(frame_buffer, 0, "\e[14;0fLogged points:");
+            field_logged = vt100_lcd_field(14, 15, 6, 0, VT100_FIELD_LEFT, SYS_FG_COLOR, SYS_BG_COLOR);
+            vt100_lcd_field_int(frame_buffer, field_logged, 0);
         }
     }
 
     // Error if cannot open logger
     if ( logger_on && (logger_fd == -1 || usb_mounted == 0) )
     {
-        vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[11;0f\e[31;40m** Cannot open logger **%s", SYS_FONT_NORM);
+        vt100_lcd_printf(frame_buffer, 0, "\e[11;0f\e[31;40m** Cannot open logger **%s", SYS_FONT_NORM);
     }
 
-    // Flush stale NMEA data
-    uart_flush(uart_fd);
+    // Frames are paced by the frame timer, not by NMEA text arrival
+    frame_timer_fd = frame_timer_open(FRAME_RATE);
+    if ( frame_timer_fd == -1 )
+    {
+        vt100_lcd_printf(frame_buffer, 0, "\e[10;0f\e[31;40mError %d on frame timer%s", errno, SYS_FONT_NORM);
+        frame_buffer = lcdDisplaySwap();
+        if ( logger_fd != -1 )
+            close(logger_fd);
+        return;
+    }
+
+    poll_fds[0].fd = gps_fix_fd();
+    poll_fds[0].events = POLLIN;
+    poll_fds[1].fd = frame_timer_fd;
+    poll_fds[1].events = POLLIN;
+
+    // Flush fixes queued before the screen was opened
+    gps_flush();
 
     while ( push_button_read() != PB_LEFT)
     {
-        // Try to read NMEA GPS text UART
-        read_result = uart_read_line(uart_fd, nmea_text, 512);
-
-        // If no new data don't proceed to update screen
-        if ( read_result == 0 )
-        {
+        // Wait for GPS fixes or a frame tick, the frame ticks
+        // also keep the push buttons polled when no fix arrives
+        if ( poll(poll_fds, 2, -1) == -1 )
             continue;
-        }
 
-        // If an error occurred, then abort
-        else if ( read_result < 0 )
+        // Read the fixes queued by the GPS thread, one for every NMEA
+        // sentence, the last one read is the newest position
+        if ( poll_fds[0].revents & POLLIN )
         {
-            vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[10;0f\e[31;40mError %d on %s%s", errno, UART0, SYS_FONT_NORM);
-        }
+            while ( gps_read(&fix) )
+            {
+                // If an error occurred, then abort
+                if ( fix.status == GPS_READ_ERROR )
+                {
+                    vt100_lcd_printf(frame_buffer, 0, "\e[10;0f\e[31;40mError %d on %s%s", fix.error, UART0, SYS_FONT_NORM);
+                    redraw = 1;
+                }
 
-        // Only a valid NMEA text line can be present at this point
-        else
-        {
-            vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[2;1f%c", heart_beat);
-            heart_beat = (heart_beat == '*') ? ' ' : '*';
-            valid_fix = nmea_update_pos(nmea_text, &pos);
+                else
+                {
+                    memcpy(&last_pos, &pos, sizeof(struct position_t));
+                    memcpy(&pos, &fix.pos, sizeof(struct position_t));
+                    valid_fix = (fix.status == GPS_FIX_VALID);
 
-            // *** Un-comment to fake a valid fix ***
-            //valid_fix = 1;
+                    // *** Un-comment to fake a valid fix ***
+                    //valid_fix = 1;
 
-            if ( valid_fix )
-            {
-                time_invalid_fix = 0;
+                    if ( valid_fix )
+                    {
+                        time_invalid_fix = 0;
 
-                // Print position information
-                // Move cursor, erase line, and reprint information
-                vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[3;0f\e[2KUTC Time %02d:%02d:%#-6.3f", pos.hour, pos.min, pos.sec);
-                vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[4;0f\e[2KLatitude %#-10.6f", pos.latitude);
-                vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[5;0f\e[2KLongitude %#-10.6f", pos.longitude);
-                vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[6;0f\e[2KSatellites %d", pos.sat_count);
-                vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[7;0f\e[2KGround speed %-5.2f [mph]", pos.ground_spd);
-                vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[8;0f\e[2KHeading %-5.1f [deg]", pos.heading);
+                        // Only sentences that change the position need a new frame
+                        if ( memcmp(&last_pos, &pos, sizeof(struct position_t)) )
+                            pos_changed = 1;
+
+                        // log position point only if GGA and RMC data
+                        // are from the same NMEA message batch
+                        if ( logger_on && pos.gga_rmc_sync && logger_fd != -1)
+                        {
+                            sprintf(log_text, "%d,%s,%#-10.6f,%#-10.6f,%-5.2f,%-5.1f\n", logged_points, pos.gga_time, pos.latitude, pos.longitude, pos.ground_spd, pos.heading);
+                            write(logger_fd, log_text, strlen(log_text));
+                            logged_points++;
+                            vt100_lcd_field_int(frame_buffer, field_logged, logged_points);
+                            redraw = 1;
+                        }
+                    }
+                    else
+                    {
+                        // There are six NMEA messages every second.
+                        // So if we count 60 invalid messages, we have an invalid fix for at least 10sec
+                        // then print the 'invalid fix' warning
+                        time_invalid_fix++;
+                        if ( time_invalid_fix == 61 )
+                        {
+                            vt100_lcd_printf(frame_buffer, 0, "\e[10;0f\e[31;40m** Fix not valid **%s", SYS_FONT_NORM);
+                            redraw = 1;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Render and push a frame on a frame tick, if anything changed
+        if ( (poll_fds[1].revents & POLLIN) && frame_timer_ack(frame_timer_fd) )
+        {
+            if ( pos_changed )
+            {
+                // The heart beat toggles with every position update
+                vt100_lcd_printf(frame_buffer, 0, "\e[2;1f%c", heart_beat);
+                heart_beat = (heart_beat == '*') ? ' ' : '*';
+
+                // Update position information, only changed characters are drawn
+                vt100_lcd_field_int(frame_buffer, field_hour, pos.hour);
+                vt100_lcd_field_int(frame_buffer, field_min, pos.min);
+                vt100_lcd_field_float(frame_buffer, field_sec, pos.sec);
+                vt100_lcd_field_float(frame_buffer, field_lat, pos.latitude);
+                vt100_lcd_field_float(frame_buffer, field_long, pos.longitude);
+                vt100_lcd_field_int(frame_buffer, field_sats, pos.sat_count);
+                vt100_lcd_field_float(frame_buffer, field_speed, pos.ground_spd);
+                vt100_lcd_field_float(frame_buffer, field_heading, pos.heading);
 
                 // Clear the error line just in case there was an alert
-                vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[10;0f\e[2K");
+                vt100_lcd_printf(frame_buffer, 0, "\e[10;0f\e[2K");
 
-                // log position point only if GGA and RMC data
-                // are from the same NMEA message batch
-                if ( logger_on && pos.gga_rmc_sync && logger_fd != -1)
-                {
-                    sprintf(nmea_text, "%d,%s,%#-10.6f,%#-10.6f,%-5.2f,%-5.1f\n", logged_points, pos.gga_time, pos.latitude, pos.longitude, pos.ground_spd, pos.heading);
-                    write(logger_fd, nmea_text, strlen(nmea_text));
-                    logged_points++;
-                    vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[14;0f\e[2KLogged points: %-5d", logged_points);
-                }
+                pos_changed = 0;
+                redraw = 1;
             }
-            else
+
+            // Print the screen
+            if ( redraw )
             {
-                // There are six NMEA messages every second.
-                // So if we count 60 invalid messages, we have an invalid fix for at least 10sec
-                // then print the 'invalid fix' warning
-                time_invalid_fix++;
-                if ( time_invalid_fix > 60 )
-                {
-                    vt100_lcd_printf(frame_buffer.pixel_bytes, 0, "\e[10;0f\e[31;40m** Fix not valid **%s", SYS_FONT_NORM);
-                }
+                frame_buffer = lcdDisplaySwap();
+                redraw = 0;
             }
         }
-
-        // Print the screen
-        lcdFrameBufferPush(frame_buffer.pixel_bytes);
     }
 
+    close(frame_timer_fd);
+
     // Close logger file
     if ( logger_on && logger_fd != -1 )
     {
@@ -1283,7 +656,11 @@ static void gps_data(int logger_on)
  * gps_map_nav()
  *
  *  Read GPS NMEA data, parse, and print on screen.
+ *  The screen is redrawn on frame timer ticks (FRAME_RATE), and only
+ *  if the position or a message on screen changed. Messages are drawn
+ *  once into the map HUD layer, which is merged over each map patch.
  *  Exit back to main menu if "LEFT" button is pressed.
+ *  "RIGHT" button toggles north-up map display.
  *  This function serves a dual purpose, it can also log
  *  GPS location to a logger file for off-line plotting.
  *  If passed '0' argument it function as display only,
@@ -1297,237 +674,252 @@ static void gps_map_nav(void)
 {
     static struct map_t *loaded_map = NULL;
 
-    char    nmea_text[128] = {0};
     char    heart_beat = '*';
     int     time_invalid_fix = 0;
-    int     read_result;
     int     valid_fix;
+    int     button_code;
+    int     north_up = 0;
+    int     pos_changed = 0;
+    int     hud_changed = 1;
+    int     redraw = 1;
+    int     frame_timer_fd;
+    uint16_t   *hud;
+    struct position_t   last_pos;
+    struct gps_fix_t    fix;
+    struct pollfd       poll_fds[2];
 
     // Format screen
-    lcdFrameBufferColor(frame_buffer.pixel_bytes, SYS_BG_COLOR);
+    lcdFrameBufferColor(frame_buffer, SYS_BG_COLOR);
+    vt100_lcd_invalidate();
+
+    // Text and the position cursor are drawn once into the HUD layer,
+    // which is merged over every map patch. Black is transparent in the HUD
+    // layer, so text is drawn on a black background.
+    hud = map_hud_clear();
+    vt100_lcd_printf(hud, 0, "\e[15;0f\e[34;40mPress 'LEFT' to exit.%s", SYS_FONT_NORM);
+    vt100_lcd_printf(hud, 0, "\e[0;0f\e[34;40m%c%s", heart_beat, SYS_FONT_NORM);
+    lcdDrawChar(hud, 78, 60, 0, ST7735_BLUE, ST7735_BLACK, 1, 0);
 
     if ( map_list == NULL )
     {
-        vt100_lcd_printf(frame_buffer.pixel_bytes, 1, "\e[11;0f\e[31;40m** No maps **%s", SYS_FONT_NORM);
+        vt100_lcd_printf(hud, 0, "\e[11;0f\e[31;40m** No maps **%s", SYS_FONT_NORM);
     }
 
-    // Flush stale NMEA data
-    uart_flush(uart_fd);
-
-    while ( push_button_read() != PB_LEFT)
+    // Frames are paced by the frame timer, not by NMEA text arrival
+    frame_timer_fd = frame_timer_open(FRAME_RATE);
+    if ( frame_timer_fd == -1 )
     {
-        // Try to read NMEA GPS text UART
-        read_result = uart_read_line(uart_fd, nmea_text, 512);
+        vt100_lcd_printf(hud, 0, "\e[10;0f\e[31;40mError %d on frame timer%s", errno, SYS_FONT_NORM);
+        map_hud_update();
+        map_hud_draw(frame_buffer);
+        frame_buffer = lcdDisplaySwap();
+        map_hud_clear();
+        return;
+    }
 
-        // If no new data don't proceed to update screen
-        if ( read_result == 0 )
-        {
-            continue;
-        }
+    poll_fds[0].fd = gps_fix_fd();
+    poll_fds[0].events = POLLIN;
+    poll_fds[1].fd = frame_timer_fd;
+    poll_fds[1].events = POLLIN;
 
-        // If an error occurred, then abort
-        else if ( read_result < 0 )
-        {
-            vt100_lcd_printf(frame_buffer.pixel_bytes, 1, "\e[10;0f\e[31;40mError %d on %s%s", errno, UART0, SYS_FONT_NORM);
-        }
+    // Flush fixes queued before the screen was opened
+    gps_flush();
 
-        // Only a valid NMEA text line can be present at this point
-        else
+    while ( (button_code = push_button_read()) != PB_LEFT)
+    {
+        // "RIGHT" button toggles between heading-up and north-up map display
+        if ( button_code == PB_RIGHT )
         {
-            valid_fix = nmea_update_pos(nmea_text, &pos);
+            north_up = map_north_up(!north_up);
+            vt100_lcd_printf(hud, 0, "\e[0;22f\e[34;40m%s%s", north_up ? "N-up" : "    ", SYS_FONT_NORM);
+            pos_changed = (loaded_map != NULL);
+            hud_changed = 1;
+        }
 
-#if  __FAKE_VALID_FIX__
-            valid_fix = 1;
-            pos.heading = 0.0;
-            pos.latitude = 42.27216935370383;
-            pos.longitude = -71.21417738855098;
-#endif
+        // Wait for GPS fixes or a frame tick, the frame ticks
+        // also keep the push buttons polled when no fix arrives
+        if ( poll(poll_fds, 2, -1) == -1 )
+            continue;
 
-            if ( valid_fix )
+        // Read the fixes queued by the GPS thread, one for every NMEA
+        // sentence, the last one read is the newest position
+        if ( poll_fds[0].revents & POLLIN )
+        {
+            while ( gps_read(&fix) )
             {
-                time_invalid_fix = 0;
-
-                // If a map is already loaded, verify that it is still valid
-                if ( loaded_map &&
-                     pos.latitude <= loaded_map->tl_lat && pos.latitude >= loaded_map->br_lat &&
-                     pos.longitude >= loaded_map->tl_long && pos.longitude <= loaded_map->br_long )
+                // If an error occurred, then abort
+                if ( fix.status == GPS_READ_ERROR )
                 {
-                    // Current map is still valid, so load patch into screen buffer
-/*
-                    if ( map_image == NULL )
-                        map_image = load_map_image(loaded_map);
-*/
-                    get_map_patch(&pos, loaded_map, map_image);
+                    vt100_lcd_printf(hud, 0, "\e[10;0f\e[31;40mError %d on %s%s", fix.error, UART0, SYS_FONT_NORM);
+                    hud_changed = 1;
                 }
 
-                // Otherwise find a map to load
                 else
                 {
-                    // Scan the linked list for an appropriate map
-                    // that contains the current location
-                    for ( loaded_map = map_list; loaded_map; loaded_map = loaded_map->next )
+                    memcpy(&last_pos, &pos, sizeof(struct position_t));
+                    memcpy(&pos, &fix.pos, sizeof(struct position_t));
+                    valid_fix = (fix.status == GPS_FIX_VALID);
+
+    #if  __FAKE_VALID_FIX__
+                    valid_fix = 1;
+                    pos.heading = 0.0;
+                    pos.latitude = 42.27216935370383;
+                    pos.longitude = -71.21417738855098;
+    #endif
+
+                    if ( valid_fix )
                     {
-                        if ( pos.latitude <= loaded_map->tl_lat && pos.latitude >= loaded_map->br_lat &&
-                             pos.longitude >= loaded_map->tl_long && pos.longitude <= loaded_map->br_long )
+                        time_invalid_fix = 0;
+
+                        // Only sentences that change the position need a new frame
+                        if ( memcmp(&last_pos, &pos, sizeof(struct position_t)) || loaded_map == NULL )
                         {
-                            break;
+                            trail_append(&pos);
+                            pos_changed = 1;
                         }
                     }
-
-                    // Reload the new map and render a patch or output an error notification
-                    if ( loaded_map )
-                    {
-                        map_image = load_map_image(loaded_map);
-                        get_map_patch(&pos, loaded_map, map_image);
-                    }
                     else
                     {
-                        lcdFrameBufferColor(frame_buffer.pixel_bytes, SYS_BG_COLOR);
-                        vt100_lcd_printf(frame_buffer.pixel_bytes, 1, "\e[12;0f\e[31;40m** No map for location **%s", SYS_FONT_NORM);
+                        // There are six NMEA messages every second.
+                        // So if we count 60 invalid messages, we have an invalid fix for at least 10sec
+                        // then print the 'invalid fix' warning
+                        time_invalid_fix++;
+                        if ( time_invalid_fix == 61 )
+                        {
+                            vt100_lcd_printf(hud, 0, "\e[13;0f\e[31;40m** Fix not valid **%s", SYS_FONT_NORM);
+                            hud_changed = 1;
+                        }
                     }
                 }
+            }
+        }
+
+        // Render and push a frame on a frame tick, if anything changed
+        if ( !(poll_fds[1].revents & POLLIN) || !frame_timer_ack(frame_timer_fd) )
+            continue;
+
+        if ( pos_changed )
+        {
+            // The heart beat toggles with every position update,
+            // and alerts are cleared
+            heart_beat = (heart_beat == '*') ? ' ' : '*';
+            vt100_lcd_printf(hud, 0, "\e[0;0f\e[34;40m%c%s", heart_beat, SYS_FONT_NORM);
+            vt100_lcd_printf(hud, 0, "\e[10;0f\e[2K\e[13;0f\e[2K");
+            hud_changed = 1;
+        }
 
-                lcdDrawChar(frame_buffer.pixel_bytes, 78, 60, 0, ST7735_BLUE, ST7735_BLACK, 1, 1);
+        // Only a changed HUD needs a new frame without a position update,
+        // the map layer is then merged with the HUD again
+        if ( hud_changed && loaded_map )
+            pos_changed = 1;
+
+        if ( pos_changed )
+        {
+            // If a map is already loaded, verify that it is still valid
+            if ( loaded_map &&
+                 pos.latitude <= loaded_map->tl_lat && pos.latitude >= loaded_map->br_lat &&
+                 pos.longitude >= loaded_map->tl_long && pos.longitude <= loaded_map->br_long )
+            {
+                // Current map is still valid, so load patch into screen buffer,
+                // the HUD runs are only rebuilt when the HUD was redrawn
+                if ( hud_changed )
+                    map_hud_update();
+                get_map_patch(&pos, loaded_map, map_image, frame_buffer, lcdWidth(), lcdHeight());
             }
+
+            // Otherwise find a map to load
             else
             {
-                // There are six NMEA messages every second.
-                // So if we count 60 invalid messages, we have an invalid fix for at least 10sec
-                // then print the 'invalid fix' warning
-                time_invalid_fix++;
-                if ( time_invalid_fix > 60 )
+                // Scan the linked list for an appropriate map
+                // that contains the current location
+                for ( loaded_map = map_list; loaded_map; loaded_map = loaded_map->next )
                 {
-                    vt100_lcd_printf(frame_buffer.pixel_bytes, 1, "\e[13;0f\e[31;40m** Fix not valid **%s", SYS_FONT_NORM);
+                    if ( pos.latitude <= loaded_map->tl_lat && pos.latitude >= loaded_map->br_lat &&
+                         pos.longitude >= loaded_map->tl_long && pos.longitude <= loaded_map->br_long )
+                    {
+                        break;
+                    }
                 }
-            }
-        }
-
-        // Print the screen
-        vt100_lcd_printf(frame_buffer.pixel_bytes, 1, "\e[15;0f\e[34;40mPress 'LEFT' to exit.%s", SYS_FONT_NORM);
-
-        heart_beat = (heart_beat == '*') ? ' ' : '*';
-        vt100_lcd_printf(frame_buffer.pixel_bytes, 1, "\e[0;0f\e[34;40m%c%s", heart_beat, SYS_FONT_NORM);
 
-        lcdFrameBufferPush(frame_buffer.pixel_bytes);
-    }
-
-    // Invalidate the map image buffer and exit
-    free(map_image);
-    map_image = NULL;
-}
+                // Reload the new map and render a patch or output an error notification
+                if ( loaded_map )
+                {
+                    vt100_lcd_printf(hud, 0, "\e[12;0f\e[2K");
+                    map_hud_update();
+                    map_image = load_map_image(loaded_map, map_image);
+                    get_map_patch(&pos, loaded_map, map_image, frame_buffer, lcdWidth(), lcdHeight());
+                }
+                else
+                {
+                    vt100_lcd_printf(hud, 0, "\e[12;0f\e[31;40m** No map for location **%s", SYS_FONT_NORM);
+                    map_hud_update();
+                    lcdFrameBufferColor(frame_buffer, SYS_BG_COLOR);
+                    map_hud_draw(frame_buffer);
+                }
+            }
 
-/********************************************************************
- * load_map_image()
- *
- *  Load the map image referenced by the map meta date
- *  structure in loaded_map.
- *  This function uses 'realloc' to allocate memory for the map image,
- *  and the calling application should free this buffer.
- *
- *  param:  Pointer to current map meta data
- *  return: Pointer to allocated buffer containing map image pixels
- *
- */
-uint16_t *load_map_image(struct map_t *loaded_map)
-{
-    uint16_t   *image_buffer;
-    size_t      image_size;
-    char        raw_img_file[128] = {USB_DIR};
-    int         fd;
+            // Draw the trail over the map patch, the HUD stays on top
+            if ( loaded_map )
+                map_draw_track(trail, trail_count, frame_buffer, TRAIL_WIDTH, TRAIL_COLOR);
 
-    // Allocate a buffer for the image that is pixel count of uint16_t
-    image_size = sizeof(uint16_t) * loaded_map->height * loaded_map->width;
-    image_buffer = realloc(map_image, image_size);
+            pos_changed = 0;
+            hud_changed = 0;
+            redraw = 1;
+        }
 
-    // If allocation is of, load the image pixel data from file
-    if ( image_buffer )
-    {
-        // Setup directory and file name string,
-        // then open the file
-        strncat(raw_img_file, "/", MAX_FILE_NAME_LEN);
-        strncat(raw_img_file, loaded_map->file_name, MAX_FILE_NAME_LEN);
-        fd = open(raw_img_file, O_RDONLY);
-        if ( fd == -1 )
+        // Without a map the HUD is drawn on a blank screen
+        else if ( hud_changed )
         {
-            free(image_buffer); // Error checking of the image buffer pointer
-            return NULL;        //  will be done in get_map_patch()
+            map_hud_update();
+            lcdFrameBufferColor(frame_buffer, SYS_BG_COLOR);
+            map_hud_draw(frame_buffer);
+            hud_changed = 0;
+            redraw = 1;
         }
 
-        // Read the file content into the buffer
-        read(fd, (void *)image_buffer, image_size);
+        // Print the screen
+        if ( redraw )
+        {
+            frame_buffer = lcdDisplaySwap();
+            redraw = 0;
+        }
     }
 
-    return image_buffer;
+    close(frame_timer_fd);
+
+    // Invalidate the map image buffer, restore heading-up display and exit
+    map_north_up(0);
+    map_hud_clear();
+    free(map_image);
+    map_image = NULL;
+    loaded_map = NULL;
 }
 
 /********************************************************************
- * get_map_patch()
+ * trail_append()
  *
- *  Load a map patch from the map image buffer into the screen buffer.
- *  The map patch is rotated according to the current heading.
+ *  Append a position to the breadcrumb trail if it moved far enough
+ *  from the last trail point. When the trail is full the older half
+ *  of the points is dropped.
  *
- *  param:  Pointer to current pos data, pointer to loaded map meta data, pointer to map image buffer
- *  return: None. Screen buffer will contain map patch
+ *  param:  Pointer to position
+ *  return: none
  *
  */
-static void get_map_patch(struct position_t *pos, struct map_t *map_attrib, uint16_t *image_buffer)
+static void trail_append(struct position_t *position)
 {
-    int     theta, y, x, yt, xt, u, v;
-    int     roi_img_height, roi_img_width;
-    int     hwidth, hheight;
-    int     roi_center_x, roi_center_y;
-    int     roi_index, img_index;
-    double  map_res_x, map_res_y;
-
-    // Sanity check
-    if ( image_buffer == NULL )
-    {
-        lcdFrameBufferColor(frame_buffer.pixel_bytes, ST7735_BLACK);
-        vt100_lcd_printf(frame_buffer.pixel_bytes, 1, "\e[8;0f\e[31;40m** Map load error\n   image_buffer == NULL **%s", SYS_FONT_NORM);
-    }
+    if ( trail_count > 0 &&
+         fabs(position->latitude - trail[trail_count - 1].latitude) < TRAIL_MIN_MOVE &&
+         fabs(position->longitude - trail[trail_count - 1].longitude) < TRAIL_MIN_MOVE )
+        return;
 
-    // Initialize variables for calculation
-    theta = (int)pos->heading;
-    roi_img_height = lcdHeight();
-    roi_img_width = lcdWidth();
-    hheight = roi_img_height / 2;
-    hwidth = roi_img_width / 2;
-
-    // Calculate the center of the display in pixels based on current position
-    map_res_x = fabs(map_attrib->br_long - map_attrib->tl_long) / (double)map_attrib->width;
-    roi_center_x = (int)(fabs(pos->longitude - map_attrib->tl_long) / map_res_x);
-
-    map_res_y = fabs(map_attrib->br_lat - map_attrib->tl_lat) / (double)map_attrib->height;
-    roi_center_y = (int)(fabs(pos->latitude - map_attrib->tl_lat) / map_res_y);
-
-/*
-    printf("lat %lf, long %lf\n", map_attrib->tl_lat, map_attrib->tl_long);
-    printf("lat %lf, long %lf\n", map_attrib->br_lat, map_attrib->br_long);
-    printf("lat %lf, long %lf\n", pos->latitude, pos->longitude);
-    printf("res_x %lf, res_y %lf\n", map_res_x*1000, map_res_y*1000);
-    printf("roi_x %d, roi_y %d\n\n", roi_center_x, roi_center_y);
-*/
-
-    // Copy rotated map patch from map image to display buffer
-    for ( y = 0; y < roi_img_height; y++ )
+    if ( trail_count == TRAIL_POINTS )
     {
-        for ( x = 0; x < roi_img_width; x++ )
-        {
-            xt = x - hwidth;
-            yt = y - hheight;
-
-            u = (int)(xt * COS[theta] - yt * SIN[theta]) + roi_center_x;
-            v = (int)(xt * SIN[theta] + yt * COS[theta]) + roi_center_y;
-
-            roi_index = (y * roi_img_width) + x;
-
-            if ( u >= 0 && u < map_attrib->width && v >= 0 && v < map_attrib->height )
-            {
-                img_index = (v * map_attrib->width) + u;
-                frame_buffer.pixel_words[roi_index] = image_buffer[img_index];
-            }
-            else
-                frame_buffer.pixel_words[roi_index] = ST7735_BLACK;
-        }
+        memmove(trail, &trail[TRAIL_POINTS / 2], sizeof(struct geo_point_t) * (TRAIL_POINTS - TRAIL_POINTS / 2));
+        trail_count = TRAIL_POINTS - TRAIL_POINTS / 2;
     }
+
+    trail[trail_count].latitude = position->latitude;
+    trail[trail_count].longitude = position->longitude;
+    trail_count++;
 }
@@ -34,10 +34,17 @@ as well as Adafruit raw 1.8" TFT display
 #include    <stdio.h>
 #include    <stdlib.h>
 #include    <string.h>
+#include    <math.h>
+#include    <pthread.h>
 
-#include    <bcm2835.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include    <arm_neon.h>
+#elif defined(__SSE2__)
+#include    <emmintrin.h>
+#endif
 
 #include    "pilcd.h"
+#include    "hal.h"
 #include    "config.h"
 
 /* -----------------------------------------
@@ -63,6 +70,8 @@ as well as Adafruit raw 1.8" TFT display
 #define     ST7735_RAMRD        0x2E
 
 #define     ST7735_PTLAR        0x30
+#define     ST7735_VSCRDEF      0x33
+#define     ST7735_VSCSAD       0x37
 #define     ST7735_COLMOD       0x3A
 #define     ST7735_MADCTL       0x36
 
@@ -102,19 +111,67 @@ as well as Adafruit raw 1.8" TFT display
 #define     MADCTL_BGR          0x08
 #define     MADCTL_MH           0x04
 
+#define     COLMOD_12BIT        0x03            // COLMOD interface pixel formats
+#define     COLMOD_16BIT        0x05
+#define     LCD_COLMOD          ((LCD_COLOR_BITS == 12) ? COLMOD_12BIT : COLMOD_16BIT)
+
 #define     DELAY               0x80
 #define     ONE_MILI_SEC        260             // loop count for 1mSec (was 210)
 
+#define     GLYPH_CACHE_ENTRIES 4               // glyph cache (text color, background, scale) combinations
+#define     GLYPH_CACHE_SCALE   4               //  and largest cached scale, larger text is drawn from the font
+
+#define     BAND_MERGE_SLACK    64                  // unchanged pixels worth sending to save an address window
+#define     SCROLL_GATE_LINES   162                 // LCD RAM gate lines, VSCRDEF areas must add up to this
+#define     SCROLL_TOP          0                   // fixed top lines (TFA), the panel's first line in LCD RAM
+#define     SCROLL_LINES        ST7735_TFTHEIGHT    // hardware scroll area (VSA), the 160 panel lines
+#define     SCROLL_BOTTOM       (SCROLL_GATE_LINES - SCROLL_TOP - SCROLL_LINES) // fixed bottom lines (BFA) off the panel
+
+#define     DISPLAY_IDLE        0               // display thread states
+#define     DISPLAY_BUSY        1
+#define     DISPLAY_EXIT        2
+
+#define     AA_ALPHA_BITS       5               // anti-aliasing coverage levels, 0 to 32
+#define     AA_ALPHA_FULL       (1 << AA_ALPHA_BITS)
+#define     AA_Q16              16              // segment rasterizer fixed point
+#define     AA_RGB565_SPREAD    0x07e0f81f      // RGB565 color fields spread over a word, green in the high half
+
+// two pixels stored with one word, may alias the frame buffer pixels
+typedef uint32_t __attribute__((__may_alias__)) pixel_pair_t;
+
 /* -----------------------------------------
    Static functions
 ----------------------------------------- */
 static void wait(uint16_t);
 static void lcd_write_command(uint8_t);
 static void lcd_write_data(uint8_t);
+static void lcd_write_data_block(const uint8_t*, int);
+static void lcd_bus_dc(int);
 static void lcd_command_list(const uint8_t*);
 static void update_row_column_addr(void);
-static void lcd_push_color(uint8_t*, uint16_t);
+static void fb_draw_char(uint16_t*, int, int, char, uint16_t, uint16_t, int, int);
+static void fb_fill(uint16_t*, int, uint16_t);
+static void fb_fill_rect(uint16_t*, int, int, int, int, uint16_t);
+static uint8_t* fb_mask(uint16_t*);
+static void fb_mask_rect(uint16_t*, int, int, int, int, uint8_t);
+static int  fb_clip(int*, int*, int*, int*);
+static uint16_t fb_blend(uint16_t, uint16_t, uint32_t);
+static int  fb_clip_segment(int64_t*, int64_t*, int64_t*, int64_t*, int64_t);
+static void fb_draw_segment(uint16_t*, int64_t, int64_t, int64_t, int64_t, int, int, uint16_t);
+static struct glyph_cache_t *glyph_cache_get(uint16_t, uint16_t, int, int);
+static void glyph_render(struct glyph_cache_t*, uint8_t);
+static void lcd_push_color(uint16_t);
+static int  lcd_write_pixels(uint16_t*, int);
+static int  lcd_pack_444(uint8_t*, const uint16_t*, int);
 static void lcd_set_addr_window(uint8_t, uint8_t, uint8_t, uint8_t);
+static void lcd_write_addr_window(uint8_t, uint8_t, uint8_t, uint8_t);
+static void lcd_dirty_clear(void);
+static int  lcd_push_spans(uint16_t*, int*, int*, int);
+static int  lcd_push_band(uint16_t*, int, int, int, int);
+static int  lcd_write_band(uint16_t*, int, int, int, int, int, int);
+static void lcd_scroll_start(int);
+static void lcd_scroll_shadow(int);
+static void *lcd_display_thread(void*);
 
 /* -----------------------------------------
    globals
@@ -123,6 +180,73 @@ static int      x_start, x_end, y_start, y_end, x_loc, y_loc;
 static int      _width, _height;
 static int      rotation;
 
+// frame buffer dirty spans, one column range [first, last] per row,
+// an empty row has first > last
+static int      dirty_first[ST7735_TFTHEIGHT];
+static int      dirty_last[ST7735_TFTHEIGHT];
+
+// copy of the LCD content as last pushed from a frame buffer, used to trim dirty
+// spans to the pixels that really changed. not valid after direct LCD writes
+static uint16_t lcd_shadow[ST7735_TFTWIDTH * ST7735_TFTHEIGHT];
+
+// frame buffers are in native byte order, pixels are converted
+// to the LCD's big-endian order here on the way to the SPI bus
+static uint16_t lcd_tx[ST7735_TFTWIDTH * ST7735_TFTHEIGHT];
+static int      lcd_shadow_valid = 0;
+
+// coverage mask of one frame buffer, one byte per pixel, see lcdFrameBufferMask()
+static uint16_t*    mask_frame = NULL;
+static uint8_t*     mask_pixels = NULL;
+
+// pixel transfer format, 16-bit RGB565 or 12-bit RGB444 packed two pixels in three bytes
+static int      color_bits = LCD_COLOR_BITS;
+
+// LCD bus, the level of the CMD/DATA line is tracked
+// so that it is only written when it changes
+static int      dc_level = -1;
+
+// hardware scroll. the scroll axis is the LCD's 160 panel lines, x in landscape
+// and y in portrait rotation. frame buffer line n along the axis is written to LCD
+// address (n + scroll_shift) mod 160 of the scroll area, and the scroll start address
+// keeps it on screen line n, so moving the whole frame along the axis only changes the shift
+static uint8_t  madctl = ROTATE_0;
+static int      scroll_shift = 0;
+static int      scroll_pending = 0;         // frame move along the scroll axis since the last push
+
+// double buffered display, the display thread pushes the front buffer
+// while the application draws into the back buffer. the display thread
+// owns the SPI bus while busy, direct LCD writes wait for it with lcdDisplayFence()
+static pthread_t        display_thread;
+static pthread_mutex_t  display_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   display_cond = PTHREAD_COND_INITIALIZER;
+static int              display_running = 0;            // only changed by the drawing thread
+static int              display_state = DISPLAY_IDLE;
+static int              display_sent = 0;
+static int              display_back = 0;
+static uint16_t        *display_buffer[2] = {NULL, NULL};
+static int              push_first[ST7735_TFTHEIGHT];       // dirty spans of the front buffer
+static int              push_last[ST7735_TFTHEIGHT];
+static int              push_scroll = 0;                    // frame move of the front buffer
+
+// pre-rendered glyphs for one (text color, background, scale) combination,
+// glyphs are rendered on first use, with a row mask of text pixels per
+// font row for transparent drawing
+struct glyph_cache_t
+{
+    uint16_t    text_color;
+    uint16_t    bg_color;
+    int         scale;
+    int         row_pixels;                 // pixels per glyph row
+    int         glyph_pixels;               // pixels per glyph
+    unsigned    last_used;
+    uint16_t   *pixels;                     // 256 glyphs, NULL if entry is unused
+    uint32_t    mask[256][FONT_PIX_HIGH];
+    uint8_t     rendered[256];
+};
+
+static struct glyph_cache_t glyph_cache[GLYPH_CACHE_ENTRIES];
+static unsigned             glyph_cache_clock = 0;
+
 /* standard ascii 5x7 font
  * originally from glcdfont.c from Adafruit project
  */
@@ -391,7 +515,7 @@ static const uint8_t Font[] = {
 static const uint8_t
 initSeq[] =
     {                                       // consolidated initialization sequence
-        21,                                 // 21 commands in list:
+        22,                                 // 22 commands in list:
         ST7735_SWRESET,   DELAY,            //  1: Software reset, 0 args, w/delay
           150,                              //     150 ms delay
         ST7735_SLPOUT ,   DELAY,            //  2: Out of sleep mode, 0 args, w/delay
@@ -425,26 +549,30 @@ initSeq[] =
         ST7735_MADCTL , 1      ,            // 14: Memory access control (directions), 1 arg:
           ROTATE_0,                         //     Normal rotation, RGB color order
         ST7735_COLMOD , 1      ,            // 15: set color mode, 1 arg, no delay:
-          0x05,                             //     16-bit color
+          LCD_COLMOD,                       //     16-bit or 12-bit color, see LCD_COLOR_BITS
         ST7735_CASET  , 4      ,            // 16: Column addr set, 4 args, no delay:
           0x00, 0x00,                       //     XSTART = 0
           0x00, 0x7F,                       //     XEND   = 127
         ST7735_RASET  , 4      ,            // 17: Row addr set, 4 args, no delay:
           0x00, 0x00,                       //     YSTART = 0
           0x00, 0x9F,                       //     YEND   = 159
-        ST7735_GMCTRP1, 16      ,           // 18: Gamma (‘+’polarity) Correction Characteristics Setting, 16 args, no delay:
+        ST7735_VSCRDEF, 6      ,            // 18: Vertical scroll definition, 6 args, no delay:
+          0x00, SCROLL_TOP,                 //     TFA = 0, no fixed top lines
+          0x00, SCROLL_LINES,               //     VSA = 160, all panel lines scroll
+          0x00, SCROLL_BOTTOM,              //     BFA = 2, gate lines past the panel, TFA + VSA + BFA = 162
+        ST7735_GMCTRP1, 16      ,           // 19: Gamma (‘+’polarity) Correction Characteristics Setting, 16 args, no delay:
           0x02, 0x1c, 0x07, 0x12,
           0x37, 0x32, 0x29, 0x2d,
           0x29, 0x25, 0x2B, 0x39,
           0x00, 0x01, 0x03, 0x10,
-        ST7735_GMCTRN1, 16      ,           // 19: Gamma ‘-’polarity Correction Characteristics Setting, 16 args, no delay:
+        ST7735_GMCTRN1, 16      ,           // 20: Gamma ‘-’polarity Correction Characteristics Setting, 16 args, no delay:
           0x03, 0x1d, 0x07, 0x06,
           0x2E, 0x2C, 0x29, 0x2D,
           0x2E, 0x2E, 0x37, 0x3F,
           0x00, 0x00, 0x02, 0x10,
-        ST7735_NORON  ,    DELAY,           // 20: Normal display on, no args, w/delay
+        ST7735_NORON  ,    DELAY,           // 21: Normal display on, no args, w/delay
           10,                               //     10 ms delay
-        ST7735_DISPON ,    DELAY,           // 21: Main screen turn on, no args w/delay
+        ST7735_DISPON ,    DELAY,           // 22: Main screen turn on, no args w/delay
           100
     };
 
@@ -455,7 +583,7 @@ initSeq[] =
 /*------------------------------------------------
  * wait()
  *
- *  Delay based on BCM2835 timer
+ *  Delay through the IO abstraction layer
  *
  */
 static void wait(uint16_t miliSec)
@@ -463,7 +591,7 @@ static void wait(uint16_t miliSec)
     if ( miliSec < 1 )
         miliSec = 1;
     
-    bcm2835_delay(miliSec);
+    hal_delay(miliSec);
 }
 
 /*------------------------------------------------
@@ -475,9 +603,8 @@ static void wait(uint16_t miliSec)
 static void lcd_write_command(uint8_t byte)
 {
     // select CMD mode and write byte
-    bcm2835_gpio_write(LCD_DATA_CMD, LOW);
-    //bcm2835_spi_write(byte);
-    bcm2835_spi_transfer(byte);
+    lcd_bus_dc(LOW);
+    hal_lcd_write(&byte, 1);
 }
 
 /*------------------------------------------------
@@ -489,9 +616,36 @@ static void lcd_write_command(uint8_t byte)
 static void lcd_write_data(uint8_t byte)
 {
     // select DATA mode and write byte
-    bcm2835_gpio_write(LCD_DATA_CMD, HIGH);
-    //bcm2835_spi_write(byte);
-    bcm2835_spi_transfer(byte);
+    lcd_bus_dc(HIGH);
+    hal_lcd_write(&byte, 1);
+}
+
+/*------------------------------------------------
+ * lcd_write_data_block()
+ *
+ *  write a block of data bytes to the ST7735 LCD
+ *
+ */
+static void lcd_write_data_block(const uint8_t *data, int len)
+{
+    // select DATA mode and write the block in one transfer
+    lcd_bus_dc(HIGH);
+    hal_lcd_write(data, len);
+}
+
+/*------------------------------------------------
+ * lcd_bus_dc()
+ *
+ *  set the level of the CMD/DATA line
+ *
+ */
+static void lcd_bus_dc(int level)
+{
+    if ( level == dc_level )
+        return;
+
+    hal_lcd_dc(level);
+    dc_level = level;
 }
 
 /*------------------------------------------------
@@ -513,9 +667,10 @@ static void lcd_command_list(const uint8_t *addr)
         numArgs  = *(addr++);                   // Number of args to follow
         ms       = numArgs & DELAY;             // If hibit set, delay follows args
         numArgs &= ~DELAY;                      // Mask out delay bit
-        while ( numArgs-- )                     // For each argument...
+        if ( numArgs )                          // Issue arguments in one block
         {
-            lcd_write_data(*(addr++));          // Read, issue argument
+            lcd_write_data_block(addr, numArgs);
+            addr += numArgs;
         }
 
         if ( ms )
@@ -549,35 +704,92 @@ static void update_row_column_addr(void)
 /*------------------------------------------------
  * lcd_push_color()
  *
- *  send color pixel to LCD or an allocated frame buffer
+ *  send color pixel to LCD
  *  must run after lcd_set_addr_window()
  *
- * param:  frameBuff  pointer to allocated frame buffer, if NULL the function writes direct to screen
- *         color      16-bit color
+ * param:  color      16-bit color
  * return: none
  *
  */
-static void lcd_push_color(uint8_t* frameBuff, uint16_t color)
+static void lcd_push_color(uint16_t color)
 {
-    int     buff_indx;
+    uint16_t    pixel;
 
-    // if a valid buffer address is passed, then write to the buffer
-    if ( frameBuff )
+    pixel = color;
+    lcd_write_pixels(&pixel, 1);
+    lcd_shadow_valid = 0;
+
+    // update row and column address variable
+    update_row_column_addr();
+}
+
+/*------------------------------------------------
+ * lcd_write_pixels()
+ *
+ *  send native order pixels to the LCD in the transfer format,
+ *  the pixels are converted in place
+ *  must run after lcd_set_addr_window()
+ *
+ * param:  pixels     pixels to send, overwritten
+ *         count      number of pixels
+ * return: number of pixel data bytes sent
+ *
+ */
+static int lcd_write_pixels(uint16_t* pixels, int count)
+{
+    int     len;
+
+    if ( color_bits == 12 )
     {
-        buff_indx = 2*(x_loc + y_loc*_width);
-        frameBuff[buff_indx] = (uint8_t) (color >> 8);
-        frameBuff[buff_indx+1] = (uint8_t) color;
+        len = lcd_pack_444((uint8_t*) pixels, pixels, count);
     }
-
-    // otherwise write pixel direct to LCD screen
     else
     {
-        lcd_write_data((uint8_t) (color >> 8));
-        lcd_write_data((uint8_t) color);
+        lcdPixelSwap(pixels, pixels, count);
+        len = count * sizeof(uint16_t);
     }
 
-    // update row and column address variable
-    update_row_column_addr();
+    lcd_write_data_block((uint8_t*) pixels, len);
+
+    return len;
+}
+
+/*------------------------------------------------
+ * lcd_pack_444()
+ *
+ *  convert RGB565 pixels to RGB444 and pack two pixels in three bytes,
+ *  in the order R1G1 B1R2 G2B2. an odd last pixel is sent in two bytes,
+ *  and the LCD ignores the unused low bits of the last byte.
+ *  the output is never ahead of the input, so dst can be the same as src
+ *
+ * param:  dst     packed bytes
+ *         src     RGB565 pixels in native order
+ *         count   number of pixels
+ * return: number of packed bytes
+ *
+ */
+static int lcd_pack_444(uint8_t* dst, const uint16_t* src, int count)
+{
+    int         i;
+    uint32_t    p0, p1;
+
+    for ( i = 0; i + 1 < count; i += 2 )
+    {
+        p0 = ((src[i] >> 4) & 0xf00) | ((src[i] >> 3) & 0x0f0) | ((src[i] >> 1) & 0x00f);
+        p1 = ((src[i + 1] >> 4) & 0xf00) | ((src[i + 1] >> 3) & 0x0f0) | ((src[i + 1] >> 1) & 0x00f);
+        *(dst++) = (uint8_t) (p0 >> 4);
+        *(dst++) = (uint8_t) ((p0 << 4) | (p1 >> 8));
+        *(dst++) = (uint8_t) p1;
+    }
+
+    if ( i < count )
+    {
+        p0 = ((src[i] >> 4) & 0xf00) | ((src[i] >> 3) & 0x0f0) | ((src[i] >> 1) & 0x00f);
+        *(dst++) = (uint8_t) (p0 >> 4);
+        *(dst++) = (uint8_t) (p0 << 4);
+    }
+
+    return ((count * 3) + 1) / 2;
 }
 
 /*------------------------------------------------
@@ -590,6 +802,14 @@ static void lcd_push_color(uint8_t* frameBuff, uint16_t color)
  */
 static void lcd_set_addr_window(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
 {
+    // direct LCD writes are not mapped along the scroll axis,
+    // so scroll the LCD back to its home position first
+    if ( scroll_shift )
+    {
+        lcd_scroll_start(0);
+        lcd_shadow_valid = 0;
+    }
+
     x_start = x0;
     x_end   = x1;
     y_start = y0;
@@ -597,284 +817,1574 @@ static void lcd_set_addr_window(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
     x_loc   = x_start;
     y_loc   = y_start;
 
-    lcd_write_command(ST7735_CASET);  // Column addr set
-    lcd_write_data(0x00);
-    lcd_write_data(x0);               // XSTART
-    lcd_write_data(0x00);
-    lcd_write_data(x1);               // XEND
-
-    lcd_write_command(ST7735_RASET);  // Row addr set
-    lcd_write_data(0x00);
-    lcd_write_data(y0);               // YSTART
-    lcd_write_data(0x00);
-    lcd_write_data(y1);               // YEND
-
-    lcd_write_command(ST7735_RAMWR);  // write to RAM
+    lcd_write_addr_window(x0, y0, x1, y1);
 }
 
 /*------------------------------------------------
- * lcdInit()
+ * lcd_write_addr_window()
  *
- *  initialization of LCD screen
+ *  send the LCD window commands without changing the drawing position
  *
  */
-void lcdInit(void)
+static void lcd_write_addr_window(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
 {
-    x_start  = 0;
-    x_end    = 0;
-    y_start  = 0;
-    y_end    = 0;
-    x_loc    = 0;
-    y_loc    = 0;
-    _width   = 0;
-    _height  = 0;
-    rotation = 0;
+    uint8_t     column[4] = {0x00, x0, 0x00, x1};   // XSTART, XEND
+    uint8_t     row[4] = {0x00, y0, 0x00, y1};      // YSTART, YEND
 
-    bcm2835_gpio_fsel(LCD_DATA_CMD, HIGH);      // setup CMD/DATA GPIO line
-    bcm2835_gpio_write(LCD_DATA_CMD, HIGH);
-    
-    lcd_command_list(initSeq);                  // initialization commands to the display
-    lcdSetRotation(ROTATE_0);                   // set display rotation and size defaults
+    lcd_write_command(ST7735_CASET);  // Column addr set
+    lcd_write_data_block(column, sizeof(column));
+
+    lcd_write_command(ST7735_RASET);  // Row addr set
+    lcd_write_data_block(row, sizeof(row));
+
+    lcd_write_command(ST7735_RAMWR);  // write to RAM
 }
 
 /*------------------------------------------------
- * lcdOn()
+ * lcd_dirty_clear()
  *
- *  turn LCD on
+ *  mark all frame buffer rows as clean
  *
  */
-void lcdOn(void)
+static void lcd_dirty_clear(void)
 {
-    lcd_write_command(ST7735_DISPON);
-    wait(100);
+    int     row;
+
+    for ( row = 0; row < ST7735_TFTHEIGHT; row++ )
+    {
+        dirty_first[row] = ST7735_TFTHEIGHT;
+        dirty_last[row] = -1;
+    }
 }
 
 /*------------------------------------------------
- * lcdOff()
+ * lcd_push_spans()
  *
- *  turn LCD off
+ *  tranfer dirty row spans of a frame buffer to LCD
+ *  dirty row spans are first trimmed to pixels that differ from the LCD content,
+ *  then consecutive dirty rows with overlapping column ranges are sent
+ *  as one address window, the union of their column ranges, while the
+ *  union adds only a few unchanged pixels.
+ *  the band is converted to LCD byte order and sent with one SPI write.
+ *  a frame that moved along the scroll axis is scrolled by the LCD first,
+ *  then every row is trimmed against the scrolled LCD content
  *
+ * param:  pixels              frame buffer to send
+ *         first, last         dirty column range per row, modified by the trimming
+ *         scroll              frame move along the scroll axis since the last push
+ * return: number of pixel data bytes sent
  */
-void lcdOff(void)
+static int lcd_push_spans(uint16_t* pixels, int* first, int* last, int scroll)
 {
-    lcd_write_command(ST7735_DISPOFF);
-    wait(100);
+    int     row, band_first, band_last, x0, x1, nx0, nx1, y;
+    int     changed;
+    int     row_pixels;
+    int     sent = 0;
+    uint16_t   *shadow;
+
+    if ( scroll && lcd_shadow_valid )
+    {
+        lcd_scroll_shadow(scroll);
+        lcd_scroll_start(scroll_shift - scroll);
+    }
+
+    // without a valid shadow the LCD content is unknown, so send the whole frame,
+    // otherwise trim the dirty spans to pixels that differ from the LCD content
+    for ( row = 0; row < _height; row++ )
+    {
+        if ( !lcd_shadow_valid || scroll )
+        {
+            first[row] = 0;
+            last[row] = _width - 1;
+        }
+
+        if ( !lcd_shadow_valid )
+            continue;
+
+        shadow = &lcd_shadow[row * _width];
+        while ( first[row] <= last[row] &&
+                pixels[(row * _width) + first[row]] == shadow[first[row]] )
+            first[row]++;
+        while ( first[row] <= last[row] &&
+                pixels[(row * _width) + last[row]] == shadow[last[row]] )
+            last[row]--;
+    }
+
+    row = 0;
+    while ( row < _height )
+    {
+        // skip clean rows
+        if ( first[row] > last[row] )
+        {
+            row++;
+            continue;
+        }
+
+        // grow a band of rows while their column ranges overlap, and the
+        // union does not send more unchanged pixels than a new address window costs
+        band_first = row;
+        x0 = first[row];
+        x1 = last[row];
+        changed = x1 - x0 + 1;
+        for ( row++; row < _height; row++ )
+        {
+            if ( first[row] > last[row] || first[row] > x1 || last[row] < x0 )
+                break;
+
+            nx0 = (first[row] < x0) ? first[row] : x0;
+            nx1 = (last[row] > x1) ? last[row] : x1;
+            changed += last[row] - first[row] + 1;
+            if ( ((nx1 - nx0 + 1) * (row - band_first + 1)) - changed > BAND_MERGE_SLACK )
+                break;
+
+            x0 = nx0;
+            x1 = nx1;
+        }
+        band_last = row - 1;
+
+        sent += lcd_push_band(pixels, x0, band_first, x1, band_last);
+
+        row_pixels = x1 - x0 + 1;
+        for ( y = band_first; y <= band_last; y++ )
+            memcpy(&lcd_shadow[(y * _width) + x0], &pixels[(y * _width) + x0], row_pixels * sizeof(uint16_t));
+    }
+
+    lcd_shadow_valid = 1;
+
+    return sent;
 }
 
 /*------------------------------------------------
- * lcdHeight()
+ * lcd_push_band()
  *
- *  LCD height in pixels
+ *  send a band of the frame buffer to its LCD address along the scroll axis.
+ *  a band that wraps around the end of the LCD RAM is sent as two windows
  *
+ * param:  pixels              frame buffer to send
+ *         x0, y0, x1, y1      band corners in the frame buffer
+ * return: number of pixel data bytes sent
  */
-int lcdHeight(void)
+static int lcd_push_band(uint16_t* pixels, int x0, int y0, int x1, int y1)
 {
-    return _height;
+    int     split;
+
+    if ( scroll_shift == 0 )
+        return lcd_write_band(pixels, x0, y0, x1, y1, x0, y0);
+
+    // first frame buffer line that wraps to the first line of the scroll area.
+    // window addresses count from the first panel line, which is SCROLL_TOP
+    // in LCD RAM, so the band wraps at the scroll area size
+    split = SCROLL_LINES - scroll_shift;
+
+    if ( madctl & MADCTL_MV )
+    {
+        if ( x1 < split )
+            return lcd_write_band(pixels, x0, y0, x1, y1, x0 + scroll_shift, y0);
+        if ( x0 >= split )
+            return lcd_write_band(pixels, x0, y0, x1, y1, x0 - split, y0);
+
+        return lcd_write_band(pixels, x0, y0, split - 1, y1, x0 + scroll_shift, y0) +
+               lcd_write_band(pixels, split, y0, x1, y1, 0, y0);
+    }
+
+    if ( y1 < split )
+        return lcd_write_band(pixels, x0, y0, x1, y1, x0, y0 + scroll_shift);
+    if ( y0 >= split )
+        return lcd_write_band(pixels, x0, y0, x1, y1, x0, y0 - split);
+
+    return lcd_write_band(pixels, x0, y0, x1, split - 1, x0, y0 + scroll_shift) +
+           lcd_write_band(pixels, x0, split, x1, y1, x0, 0);
 }
 
 /*------------------------------------------------
- * lcdWidth()
+ * lcd_write_band()
  *
- *  return LCD width in pixels
+ *  send a band of the frame buffer to an LCD window of the same size,
+ *  the band is converted to the transfer format and sent with one SPI write
  *
+ * param:  pixels              frame buffer to send
+ *         x0, y0, x1, y1      band corners in the frame buffer
+ *         lcd_x, lcd_y        top left corner of the LCD window
+ * return: number of pixel data bytes sent
  */
-int lcdWidth(void)
+static int lcd_write_band(uint16_t* pixels, int x0, int y0, int x1, int y1, int lcd_x, int lcd_y)
 {
-    return _width;
+    int     row_pixels, band_pixels, len, y;
+
+    lcd_write_addr_window(lcd_x, lcd_y, lcd_x + x1 - x0, lcd_y + y1 - y0);   // prepare display area
+
+    // convert the band to the transfer format, full width bands are contiguous in the buffer.
+    // RGB444 pixel pairs run across band rows, so a partial width band is gathered first
+    row_pixels = x1 - x0 + 1;
+    band_pixels = row_pixels * (y1 - y0 + 1);
+    if ( color_bits == 12 )
+    {
+        if ( row_pixels == _width )
+        {
+            len = lcd_pack_444((uint8_t*) lcd_tx, &pixels[y0 * _width], band_pixels);
+        }
+        else
+        {
+            for ( y = y0; y <= y1; y++ )
+                memcpy(&lcd_tx[(y - y0) * row_pixels], &pixels[(y * _width) + x0], row_pixels * sizeof(uint16_t));
+            len = lcd_pack_444((uint8_t*) lcd_tx, lcd_tx, band_pixels);
+        }
+    }
+    else
+    {
+        if ( row_pixels == _width )
+        {
+            lcdPixelSwap(lcd_tx, &pixels[y0 * _width], band_pixels);
+        }
+        else
+        {
+            for ( y = y0; y <= y1; y++ )
+                lcdPixelSwap(&lcd_tx[(y - y0) * row_pixels], &pixels[(y * _width) + x0], row_pixels);
+        }
+        len = band_pixels * sizeof(uint16_t);
+    }
+
+    // select DATA mode and write the band
+    lcd_write_data_block((uint8_t*) lcd_tx, len);
+
+    return len;
 }
 
 /*------------------------------------------------
- * lcdSetRotation()
+ * lcd_scroll_start()
  *
- *  screen rotation
+ *  set the LCD address of frame buffer line 0 along the scroll axis,
+ *  and the scroll start address that shows it on the first screen line.
+ *  with the row address order mirrored (MY) the LCD RAM lines run
+ *  opposite to the screen lines
  *
  */
-void lcdSetRotation(uint8_t mode)
+static void lcd_scroll_start(int shift)
 {
-    uint8_t     ctrlByte = 0x00;
-
-    if ( mode > 3 )
-        return;
-
-    switch ( mode )
-    {
-        case 0:
-            ctrlByte = ROTATE_0;
-            _width  = ST7735_TFTWIDTH;
-            _height = ST7735_TFTHEIGHT;
-            break;
-
-        case 1:
-            ctrlByte = ROTATE_90;
-            _width = ST7735_TFTHEIGHT;
-            _height = ST7735_TFTWIDTH;
-             break;
+    int         start;
+    uint8_t     vscsad[2];
 
-        case 2:
-            ctrlByte = ROTATE_180;
-            _width  = ST7735_TFTWIDTH;
-            _height = ST7735_TFTHEIGHT;
-            break;
+    shift %= SCROLL_LINES;
+    if ( shift < 0 )
+        shift += SCROLL_LINES;
 
-        case 3:
-            ctrlByte = ROTATE_270;
-            _width = ST7735_TFTHEIGHT;
-            _height = ST7735_TFTWIDTH;
-            break;
-    }
+    // the scroll start address is an LCD RAM line within the scroll area
+    start = SCROLL_TOP + ((madctl & MADCTL_MY) ? (SCROLL_LINES - shift) % SCROLL_LINES : shift);
+    vscsad[0] = (uint8_t) (start >> 8);
+    vscsad[1] = (uint8_t) start;
 
-    x_start  = 0;
-    x_end    = _width - 1;
-    y_start  = 0;
-    y_end    = _height - 1;
-    x_loc    = x_start;
-    y_loc    = y_start;
+    lcd_write_command(ST7735_VSCSAD);
+    lcd_write_data_block(vscsad, sizeof(vscsad));
 
-    lcd_write_command(ST7735_MADCTL);
-    lcd_write_data(ctrlByte);
+    scroll_shift = shift;
 }
 
 /*------------------------------------------------
- * lcdInvertDisplay()
+ * lcd_scroll_shadow()
  *
- *  inverse screen colors
+ *  move the LCD shadow copy along the scroll axis the way the LCD scrolls,
+ *  lines moved out at one edge come back at the other edge
  *
  */
-void lcdInvertDisplay(int i)
+static void lcd_scroll_shadow(int scroll)
 {
-    lcd_write_command(i ? ST7735_INVON : ST7735_INVOFF);
+    int         row, keep;
+    uint16_t   *shadow;
+
+    scroll %= SCROLL_LINES;
+    if ( scroll < 0 )
+        scroll += SCROLL_LINES;
+    if ( scroll == 0 )
+        return;
+
+    keep = SCROLL_LINES - scroll;
+
+    // the transmit buffer is free outside of a push band
+    if ( madctl & MADCTL_MV )
+    {
+        for ( row = 0; row < _height; row++ )
+        {
+            shadow = &lcd_shadow[row * _width];
+            memcpy(lcd_tx, &shadow[keep], scroll * sizeof(uint16_t));
+            memmove(&shadow[scroll], shadow, keep * sizeof(uint16_t));
+            memcpy(shadow, lcd_tx, scroll * sizeof(uint16_t));
+        }
+    }
+    else
+    {
+        memcpy(lcd_tx, &lcd_shadow[keep * _width], scroll * _width * sizeof(uint16_t));
+        memmove(&lcd_shadow[scroll * _width], lcd_shadow, keep * _width * sizeof(uint16_t));
+        memcpy(lcd_shadow, lcd_tx, scroll * _width * sizeof(uint16_t));
+    }
 }
 
 /*------------------------------------------------
- * lcdColor565()
+ * lcd_display_thread()
  *
- *  Pass 8-bit (each) R,G,B, get back 16-bit packed color
+ *  display thread, waits for a front buffer from lcdDisplaySwap()
+ *  and pushes its dirty spans to the LCD
  *
  */
-uint16_t lcdColor565(uint8_t r, uint8_t g, uint8_t b)
+static void *lcd_display_thread(void *arg)
 {
-    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    uint16_t   *front;
+    int         sent;
+
+    pthread_mutex_lock(&display_lock);
+
+    while ( 1 )
+    {
+        while ( display_state == DISPLAY_IDLE )
+            pthread_cond_wait(&display_cond, &display_lock);
+
+        if ( display_state == DISPLAY_EXIT )
+            break;
+
+        front = display_buffer[!display_back];
+        pthread_mutex_unlock(&display_lock);
+
+        sent = lcd_push_spans(front, push_first, push_last, push_scroll);
+
+        pthread_mutex_lock(&display_lock);
+        display_sent = sent;
+        display_state = DISPLAY_IDLE;
+        pthread_cond_broadcast(&display_cond);
+    }
+
+    pthread_mutex_unlock(&display_lock);
+
+    return NULL;
 }
 
 /*------------------------------------------------
- * lcdFillRect()
+ * fb_fill()
  *
- *  draw a filled rectangle with solid color
+ *  fill frame buffer pixels with a color,
+ *  colors with equal high and low bytes are a memset()
  *
  */
-void lcdFillRect(int x, int y, int w, int h, uint16_t color)
+static void fb_fill(uint16_t* pixels, int count, uint16_t color)
 {
-    uint8_t     hi, lo;
+    int             i, pairs;
+    uint32_t        pair;
+    pixel_pair_t   *words;
 
-    // rudimentary clipping (drawChar w/big text requires this)
-    if ((x >= _width) || (y >= _height))
+    if ( count <= 0 )
         return;
 
-    if ((x + w - 1) >= _width)
-        w = _width  - x;
-
-    if ((y + h - 1) >= _height)
-        h = _height - y;
-
-    lcd_set_addr_window(x, y, x+w-1, y+h-1);
+    if ( (color >> 8) == (color & 0xff) )
+    {
+        memset(pixels, color & 0xff, count * sizeof(uint16_t));
+        return;
+    }
 
-    hi = (uint8_t) (color >> 8);
-    lo = (uint8_t) color;
-    
-    for (y=h; y>0; y--)
+    // align to a word, then store two pixels per word
+    if ( (uintptr_t) pixels & 2 )
     {
-        for (x=w; x>0; x--)
-        {
-            lcd_write_data(hi);
-            lcd_write_data(lo);
-        }
+        *pixels++ = color;
+        count--;
     }
+
+    pair = ((uint32_t) color << 16) | color;
+    words = (pixel_pair_t*) pixels;
+    pairs = count / 2;
+    for ( i = 0; i < pairs; i++ )
+        words[i] = pair;
+
+    if ( count & 1 )
+        pixels[count - 1] = color;
 }
 
 /*------------------------------------------------
- * lcdFrameBufferInit()
+ * fb_fill_rect()
  *
- *  initialize a frame buffer with a color
+ *  fill a clipped rectangle of the frame buffer with a color,
+ *  the first row is filled and copied to the other rows
  *
  */
-uint8_t* lcdFrameBufferInit(uint16_t color)
+static void fb_fill_rect(uint16_t* frameBuff, int x, int y, int w, int h, uint16_t color)
 {
-    uint8_t*  buffer;
-    uint16_t  size;
-    uint16_t  i;
-
-    size = _width * _height * sizeof(uint16_t);         // calculate buffer size
+    int         row;
+    uint16_t   *first;
 
-    if ( (buffer = (uint8_t*) malloc(size)) == NULL )   // allocate memory and abort if cannot
-        return NULL;
+    first = &frameBuff[(y * _width) + x];
 
-    for ( i = 0; i < size; i += 2)                      // initialize buffer with color
+    // full width rows are contiguous in the buffer
+    if ( w == _width )
+    {
+        fb_fill(first, w * h, color);
+    }
+    else
     {
-        buffer[i] = (uint8_t) (color >> 8);             // swap bytes in buffer
-        buffer[i+1] = (uint8_t) color;                  // so that writes yield correct order
+        fb_fill(first, w, color);
+        for ( row = 1; row < h; row++ )
+            memcpy(&first[row * _width], first, w * sizeof(uint16_t));
     }
 
-    return buffer;
+    fb_mask_rect(frameBuff, x, y, w, h, 1);
+    lcdFrameBufferDirty(x, y, w, h);
 }
 
 /*------------------------------------------------
- * lcdFrameBufferFree()
+ * fb_mask()
  *
- *  release memory reserved for the frame buffer
+ *  the coverage mask of a frame buffer
  *
+ * return: mask pixels, NULL if the frame buffer has no mask
  */
-void lcdFrameBufferFree(uint8_t* frameBufferPointer)
+static uint8_t* fb_mask(uint16_t* frameBuff)
 {
-    free((void*) frameBufferPointer);                       // free buffer memory
+    return (frameBuff == mask_frame) ? mask_pixels : NULL;
 }
 
 /*------------------------------------------------
- * lcdFrameBufferPush()
+ * fb_mask_rect()
  *
- *  tranfer frame buffer to LCD
+ *  set a clipped rectangle of a frame buffer's coverage mask,
+ *  if the frame buffer has one
  *
  */
-void lcdFrameBufferPush(uint8_t* frameBufferPointer)
+static void fb_mask_rect(uint16_t* frameBuff, int x, int y, int w, int h, uint8_t value)
 {
-    uint16_t  size;
+    uint8_t    *mask;
+    int         row;
 
-    size = _width * _height * sizeof(uint16_t);             // calculate frame buffer size
-    lcd_set_addr_window(0, 0, _width-1, _height-1);            // prepare display area
+    if ( (mask = fb_mask(frameBuff)) == NULL )
+        return;
 
-    // select DATA mode and write byte
-    bcm2835_gpio_write(LCD_DATA_CMD, HIGH);
-    bcm2835_spi_writenb((char*)frameBufferPointer, size);
+    for ( row = y; row < (y + h); row++ )
+        memset(&mask[(row * _width) + x], value, w);
 }
 
 /*------------------------------------------------
- * lcdFrameBufferColor()
+ * fb_blend()
  *
- *  initialize an existing (allocated) frame buffer with a color
+ *  blend a color over a pixel, with the color fields spread
+ *  over a word so all three are blended with one multiply
  *
+ * param:  pixel       background pixel
+ *         color       color to blend
+ *         alpha       color weight, 0 to AA_ALPHA_FULL
+ * return: blended pixel
  */
-void lcdFrameBufferColor(uint8_t* frameBufferPointer, uint16_t color)
+static uint16_t fb_blend(uint16_t pixel, uint16_t color, uint32_t alpha)
 {
-    uint16_t    size;
-    uint16_t    i;
-    
-    size = _width * _height * sizeof(uint16_t);         // calculate buffer size
+    uint32_t    bg, fg;
 
-    for ( i = 0; i < size; i += 2)                      // initialize buffer with color
+    bg = (pixel | ((uint32_t) pixel << 16)) & AA_RGB565_SPREAD;
+    fg = (color | ((uint32_t) color << 16)) & AA_RGB565_SPREAD;
+    bg = (bg + (((fg - bg) * alpha) >> AA_ALPHA_BITS)) & AA_RGB565_SPREAD;
+
+    return (uint16_t) (bg | (bg >> 16));
+}
+
+/*------------------------------------------------
+ * fb_clip_segment()
+ *
+ *  clip a line segment to the screen grown by a margin,
+ *  with the Liang-Barsky line clipping algorithm.
+ *  coordinates are in the segment rasterizer fixed point
+ *
+ * param:  x0, y0, x1, y1  segment end points, changed to the clipped segment
+ *         margin          screen margin for the line width
+ * return: 1 if a part of the segment is on the screen, 0 if not
+ */
+static int fb_clip_segment(int64_t* x0, int64_t* y0, int64_t* x1, int64_t* y1, int64_t margin)
+{
+    double      t0 = 0.0, t1 = 1.0, t;
+    double      dx, dy;
+    double      p[4], q[4];
+    int64_t     x_min, y_min, x_max, y_max;
+    int         i;
+
+    x_min = -margin;
+    y_min = -margin;
+    x_max = ((int64_t) (_width - 1) << AA_Q16) + margin;
+    y_max = ((int64_t) (_height - 1) << AA_Q16) + margin;
+
+    // segments inside the screen need no clipping, and segments
+    // beyond one edge are dropped, like most of a long track
+    if ( *x0 >= x_min && *x0 <= x_max && *x1 >= x_min && *x1 <= x_max &&
+         *y0 >= y_min && *y0 <= y_max && *y1 >= y_min && *y1 <= y_max )
+        return 1;
+
+    if ( (*x0 < x_min && *x1 < x_min) || (*x0 > x_max && *x1 > x_max) ||
+         (*y0 < y_min && *y1 < y_min) || (*y0 > y_max && *y1 > y_max) )
+        return 0;
+
+    dx = (double) (*x1 - *x0);
+    dy = (double) (*y1 - *y0);
+    p[0] = -dx;
+    q[0] = (double) (*x0 - x_min);
+    p[1] = dx;
+    q[1] = (double) (x_max - *x0);
+    p[2] = -dy;
+    q[2] = (double) (*y0 - y_min);
+    p[3] = dy;
+    q[3] = (double) (y_max - *y0);
+
+    for ( i = 0; i < 4; i++ )
+    {
+        if ( p[i] == 0.0 )
+        {
+            if ( q[i] < 0.0 )
+                return 0;
+            continue;
+        }
+
+        t = q[i] / p[i];
+        if ( p[i] < 0.0 && t > t0 )
+            t0 = t;
+        else if ( p[i] > 0.0 && t < t1 )
+            t1 = t;
+    }
+
+    if ( t0 > t1 )
+        return 0;
+
+    *x1 = *x0 + (int64_t) (t1 * dx);
+    *y1 = *y0 + (int64_t) (t1 * dy);
+    *x0 = *x0 + (int64_t) (t0 * dx);
+    *y0 = *y0 + (int64_t) (t0 * dy);
+
+    return 1;
+}
+
+/*------------------------------------------------
+ * fb_draw_segment()
+ *
+ *  draw an anti-aliased line segment with a width into the frame buffer.
+ *  the segment is walked one pixel at a time along its major axis, and
+ *  every step draws a span across the minor axis, as wide as the line
+ *  measured along that axis. pixels inside the span are set, and the
+ *  pixels at the span ends are blended with their coverage.
+ *  the first pixel of the segment is skipped when it is shared with
+ *  the previous segment, so that polyline joints are not blended twice
+ *
+ * param:  frameBuff       pointer to allocated frame buffer
+ *         x0, y0, x1, y1  segment end points in the rasterizer fixed point
+ *         width           line width in pixels
+ *         skip_first      '1' to skip the first pixel along the major axis
+ *         color           16-bit color in RGB565 format
+ * return: none
+ */
+static void fb_draw_segment(uint16_t* frameBuff, int64_t x0, int64_t y0, int64_t x1, int64_t y1,
+                            int width, int skip_first, uint16_t color)
+{
+    int64_t     major0, major1, minor0, d_major, d_minor;
+    int64_t     center, slope, half, a, b, lo, hi;
+    int         steep, step, i, i_end, k, k_first, k_last;
+    int         major_size, minor_size, x, y;
+    uint32_t    alpha;
+    uint16_t   *pixel;
+
+    steep = (llabs(y1 - y0) > llabs(x1 - x0));
+    if ( steep )
+    {
+        major0 = y0;
+        major1 = y1;
+        minor0 = x0;
+        d_minor = x1 - x0;
+        major_size = _height;
+        minor_size = _width;
+    }
+    else
+    {
+        major0 = x0;
+        major1 = x1;
+        minor0 = y0;
+        d_minor = y1 - y0;
+        major_size = _width;
+        minor_size = _height;
+    }
+    d_major = major1 - major0;
+
+    // pixels along the major axis, from the pixel of the start
+    // point to the pixel of the end point
+    i = (int) ((major0 + (1 << (AA_Q16 - 1))) >> AA_Q16);
+    i_end = (int) ((major1 + (1 << (AA_Q16 - 1))) >> AA_Q16);
+    step = (i_end >= i) ? 1 : -1;
+    if ( skip_first )
+    {
+        if ( i == i_end )
+            return;
+        i += step;
+    }
+
+    // minor axis position at pixel i, its change per pixel step,
+    // and the half width of the line along the minor axis
+    if ( d_major == 0 )
+    {
+        slope = 0;
+        center = minor0;
+        half = (int64_t) width << (AA_Q16 - 1);
+    }
+    else
+    {
+        slope = (d_minor << AA_Q16) / d_major;
+        center = minor0 + ((((int64_t) i << AA_Q16) - major0) * slope >> AA_Q16);
+        slope *= step;
+        half = (int64_t) (width * (double) (1 << (AA_Q16 - 1)) *
+                          sqrt(1.0 + ((double) d_minor * d_minor) / ((double) d_major * d_major)));
+    }
+
+    for ( ; ; i += step, center += slope )
+    {
+        if ( i >= 0 && i < major_size )
+        {
+            // pixel k covers the minor axis from k - 1/2 to k + 1/2
+            a = center - half;
+            b = center + half;
+            k_first = (int) ((a + (1 << (AA_Q16 - 1))) >> AA_Q16);
+            k_last = (int) ((b + (1 << (AA_Q16 - 1)) - 1) >> AA_Q16);
+            if ( k_first < 0 )
+                k_first = 0;
+            if ( k_last >= minor_size )
+                k_last = minor_size - 1;
+
+            for ( k = k_first; k <= k_last; k++ )
+            {
+                lo = ((int64_t) k << AA_Q16) - (1 << (AA_Q16 - 1));
+                hi = lo + (1 << AA_Q16);
+                if ( a > lo )
+                    lo = a;
+                if ( b < hi )
+                    hi = b;
+
+                x = steep ? k : i;
+                y = steep ? i : k;
+                pixel = &frameBuff[(y * _width) + x];
+
+                alpha = (uint32_t) (((hi - lo) * AA_ALPHA_FULL + (1 << (AA_Q16 - 1))) >> AA_Q16);
+                if ( alpha >= AA_ALPHA_FULL )
+                    *pixel = color;
+                else if ( alpha > 0 )
+                    *pixel = fb_blend(*pixel, color, alpha);
+            }
+
+            // mark the span dirty, a row of a steep segment or a column of a flat one
+            if ( k_first <= k_last )
+            {
+                if ( steep )
+                {
+                    if ( k_first < dirty_first[i] )
+                        dirty_first[i] = k_first;
+                    if ( k_last > dirty_last[i] )
+                        dirty_last[i] = k_last;
+                }
+                else
+                {
+                    for ( k = k_first; k <= k_last; k++ )
+                    {
+                        if ( i < dirty_first[k] )
+                            dirty_first[k] = i;
+                        if ( i > dirty_last[k] )
+                            dirty_last[k] = i;
+                    }
+                }
+            }
+        }
+
+        if ( i == i_end )
+            break;
+    }
+}
+
+/*------------------------------------------------
+ * fb_clip()
+ *
+ *  clip a rectangle to the screen
+ *
+ * param:  x, y, w, h  rectangle, changed to the clipped rectangle
+ * return: 1 if the clipped rectangle is not empty, 0 if it is
+ */
+static int fb_clip(int* x, int* y, int* w, int* h)
+{
+    if ( *x < 0 )
+    {
+        *w += *x;
+        *x = 0;
+    }
+    if ( *y < 0 )
+    {
+        *h += *y;
+        *y = 0;
+    }
+    if ( (*x + *w) > _width )
+        *w = _width - *x;
+    if ( (*y + *h) > _height )
+        *h = _height - *y;
+
+    return (*w > 0 && *h > 0);
+}
+
+/*------------------------------------------------
+ * glyph_cache_get()
+ *
+ *  find the glyph cache entry for a color and scale combination,
+ *  or reuse the least recently used entry for it.
+ *  transparent text ignores the background color
+ *
+ * return: cache entry, NULL if scale is not cached or out of memory
+ */
+static struct glyph_cache_t *glyph_cache_get(uint16_t textColor, uint16_t bgColor, int scale, int transparent)
+{
+    struct glyph_cache_t   *entry, *lru;
+    int                     i;
+
+    if ( scale < 1 || scale > GLYPH_CACHE_SCALE )
+        return NULL;
+
+    glyph_cache_clock++;
+
+    lru = &glyph_cache[0];
+    for ( i = 0; i < GLYPH_CACHE_ENTRIES; i++ )
+    {
+        entry = &glyph_cache[i];
+        if ( entry->pixels && entry->text_color == textColor && entry->scale == scale &&
+             (transparent || entry->bg_color == bgColor) )
+        {
+            entry->last_used = glyph_cache_clock;
+            return entry;
+        }
+
+        if ( entry->pixels == NULL || entry->last_used < lru->last_used )
+            lru = entry;
+        if ( lru->pixels == NULL )
+            break;
+    }
+
+    // (re)initialize the least recently used entry for this combination
+    entry = lru;
+    if ( entry->pixels == NULL || entry->scale != scale )
+    {
+        free(entry->pixels);
+        entry->row_pixels = FONT_PIX_WIDE * scale;
+        entry->glyph_pixels = entry->row_pixels * FONT_PIX_HIGH * scale;
+        if ( (entry->pixels = (uint16_t*) malloc(256 * entry->glyph_pixels * sizeof(uint16_t))) == NULL )
+            return NULL;
+    }
+
+    entry->text_color = textColor;
+    entry->bg_color = bgColor;
+    entry->scale = scale;
+    entry->last_used = glyph_cache_clock;
+    memset(entry->rendered, 0, sizeof(entry->rendered));
+
+    return entry;
+}
+
+/*------------------------------------------------
+ * glyph_render()
+ *
+ *  expand a font character into a glyph cache entry
+ *
+ */
+static void glyph_render(struct glyph_cache_t *entry, uint8_t c)
+{
+    const uint8_t  *font;
+    uint16_t       *pixel;
+    uint16_t        color;
+    uint32_t        mask;
+    int             col, row, i, j;
+
+    font = &Font[c*FONT_PIX_WIDE];
+    pixel = &entry->pixels[c * entry->glyph_pixels];
+
+    for ( row = 0; row < FONT_PIX_HIGH; row++ )
+    {
+        // expand the font row once, then replicate it for the scaled pixel rows
+        mask = 0;
+        for ( col = 0; col < FONT_PIX_WIDE; col++ )
+        {
+            color = (font[col] & (1 << row)) ? entry->text_color : entry->bg_color;
+            for ( j = 0; j < entry->scale; j++ )
+            {
+                *pixel++ = color;
+                if ( font[col] & (1 << row) )
+                    mask |= 1 << ((col * entry->scale) + j);
+            }
+        }
+
+        for ( i = 1; i < entry->scale; i++, pixel += entry->row_pixels )
+            memcpy(pixel, pixel - entry->row_pixels, entry->row_pixels * sizeof(uint16_t));
+
+        entry->mask[c][row] = mask;
+    }
+
+    entry->rendered[c] = 1;
+}
+
+/*------------------------------------------------
+ * fb_draw_char()
+ *
+ *  draw a character into a frame buffer, the frame buffer raster path
+ *  of lcdDrawChar(). cached glyphs are copied one pixel row at a time,
+ *  transparent text stores only the text pixels in the glyph row mask.
+ *  scales that are not cached are drawn from the font.
+ *  a coverage mask of the frame buffer is set on the text pixels,
+ *  and cleared on the background pixels of text that is not transparent.
+ *  the caller checks that the character is inside the screen
+ *
+ */
+static void fb_draw_char(uint16_t* frameBuff, int x, int y, char c, uint16_t textColor, uint16_t bgColor, int scale, int transparent)
+{
+    struct glyph_cache_t   *entry;
+    const uint8_t  *font;
+    const uint16_t *glyph;
+    uint16_t       *pixel;
+    uint8_t        *cover, *cover_row;
+    uint8_t         line;
+    uint32_t        mask;
+    int             col, row, i, j;
+
+    entry = glyph_cache_get(textColor, bgColor, scale, transparent);
+    cover = fb_mask(frameBuff);
+
+    if ( entry )
+    {
+        if ( !entry->rendered[(uint8_t) c] )
+            glyph_render(entry, (uint8_t) c);
+
+        glyph = &entry->pixels[(uint8_t) c * entry->glyph_pixels];
+        pixel = &frameBuff[x + y*_width];
+        cover_row = cover ? &cover[x + y*_width] : NULL;
+
+        for ( row = 0; row < FONT_PIX_HIGH * scale; row++ )
+        {
+            if ( !transparent )
+            {
+                memcpy(pixel, glyph, entry->row_pixels * sizeof(uint16_t));
+            }
+            else
+            {
+                for ( mask = entry->mask[(uint8_t) c][row / scale]; mask; mask &= mask - 1 )
+                {
+                    col = __builtin_ctz(mask);
+                    pixel[col] = glyph[col];
+                }
+            }
+
+            // text pixels cover the mask, the background uncovers it
+            if ( cover_row )
+            {
+                if ( !transparent )
+                    memset(cover_row, 0, entry->row_pixels);
+                for ( mask = entry->mask[(uint8_t) c][row / scale]; mask; mask &= mask - 1 )
+                    cover_row[__builtin_ctz(mask)] = 1;
+                cover_row += _width;
+            }
+
+            glyph += entry->row_pixels;
+            pixel += _width;
+        }
+    }
+    else
+    {
+        font = &Font[(uint8_t) c * FONT_PIX_WIDE];
+
+        line = 0x01;
+        for ( row = 0; row < FONT_PIX_HIGH; row++ )
+        {
+            for ( i = 0; i < scale; i++ )
+            {
+                pixel = &frameBuff[x + (y + row*scale + i)*_width];
+
+                for ( col = 0; col < FONT_PIX_WIDE; col++ )
+                {
+                    for ( j = 0; j < scale; j++, pixel++ )
+                    {
+                        if ( font[col] & line )
+                        {
+                            *pixel = textColor;
+                            if ( cover )
+                                cover[pixel - frameBuff] = 1;
+                        }
+                        else if ( !transparent )
+                        {
+                            *pixel = bgColor;
+                            if ( cover )
+                                cover[pixel - frameBuff] = 0;
+                        }
+                    }
+                }
+            }
+
+            line = line << 1;
+        }
+    }
+
+    lcdFrameBufferDirty(x, y, FONT_PIX_WIDE*scale, FONT_PIX_HIGH*scale);
+}
+
+/*------------------------------------------------
+ * lcdBusInit()
+ *
+ *  open the LCD SPI bus and the CMD/DATA and RST lines
+ *  through the IO abstraction layer, then reset the LCD.
+ *  hal_init() must be called first
+ *
+ * param:  none
+ * return: 0 if ok, -1 if failed
+ *
+ */
+int lcdBusInit(void)
+{
+    if ( hal_lcd_open() == -1 )
+        return -1;
+
+    dc_level = HIGH;                            // CMD/DATA line is HIGH after open
+
+    return 0;
+}
+
+/*------------------------------------------------
+ * lcdBusClose()
+ *
+ *  close the LCD SPI bus
+ *
+ */
+void lcdBusClose(void)
+{
+    hal_lcd_close();
+    dc_level = -1;
+}
+
+/*------------------------------------------------
+ * lcdInit()
+ *
+ *  initialization of LCD screen
+ *
+ */
+void lcdInit(void)
+{
+    x_start  = 0;
+    x_end    = 0;
+    y_start  = 0;
+    y_end    = 0;
+    x_loc    = 0;
+    y_loc    = 0;
+    _width   = 0;
+    _height  = 0;
+    rotation = 0;
+
+    lcd_dirty_clear();
+    lcd_shadow_valid = 0;
+    scroll_shift = 0;                           // software reset homes the scroll start address
+    scroll_pending = 0;
+    color_bits = LCD_COLOR_BITS;                // set by the initialization sequence
+
+    lcd_bus_dc(HIGH);                           // CMD/DATA line is setup by lcdBusInit()
+    
+    lcd_command_list(initSeq);                  // initialization commands to the display
+    lcdSetRotation(ROTATE_0);                   // set display rotation and size defaults
+}
+
+/*------------------------------------------------
+ * lcdOn()
+ *
+ *  turn LCD on
+ *
+ */
+void lcdOn(void)
+{
+    lcdDisplayFence();
+    lcd_write_command(ST7735_DISPON);
+    wait(100);
+}
+
+/*------------------------------------------------
+ * lcdOff()
+ *
+ *  turn LCD off
+ *
+ */
+void lcdOff(void)
+{
+    lcdDisplayFence();
+    lcd_write_command(ST7735_DISPOFF);
+    wait(100);
+}
+
+/*------------------------------------------------
+ * lcdHeight()
+ *
+ *  LCD height in pixels
+ *
+ */
+int lcdHeight(void)
+{
+    return _height;
+}
+
+/*------------------------------------------------
+ * lcdWidth()
+ *
+ *  return LCD width in pixels
+ *
+ */
+int lcdWidth(void)
+{
+    return _width;
+}
+
+/*------------------------------------------------
+ * lcdFontChar()
+ *
+ *  return the font columns of a character, FONT_PIX_WIDE
+ *  bytes with the top pixel row in bit 0
+ *
+ */
+const uint8_t* lcdFontChar(char c)
+{
+    return &Font[(uint8_t) c * FONT_PIX_WIDE];
+}
+
+/*------------------------------------------------
+ * lcdSetRotation()
+ *
+ *  screen rotation
+ *
+ */
+void lcdSetRotation(uint8_t mode)
+{
+    uint8_t     ctrlByte = 0x00;
+
+    if ( mode > 3 )
+        return;
+
+    lcdDisplayFence();
+
+    switch ( mode )
+    {
+        case 0:
+            ctrlByte = ROTATE_0;
+            _width  = ST7735_TFTWIDTH;
+            _height = ST7735_TFTHEIGHT;
+            break;
+
+        case 1:
+            ctrlByte = ROTATE_90;
+            _width = ST7735_TFTHEIGHT;
+            _height = ST7735_TFTWIDTH;
+             break;
+
+        case 2:
+            ctrlByte = ROTATE_180;
+            _width  = ST7735_TFTWIDTH;
+            _height = ST7735_TFTHEIGHT;
+            break;
+
+        case 3:
+            ctrlByte = ROTATE_270;
+            _width = ST7735_TFTHEIGHT;
+            _height = ST7735_TFTWIDTH;
+            break;
+    }
+
+    x_start  = 0;
+    x_end    = _width - 1;
+    y_start  = 0;
+    y_end    = _height - 1;
+    x_loc    = x_start;
+    y_loc    = y_start;
+
+    lcd_write_command(ST7735_MADCTL);
+    lcd_write_data(ctrlByte);
+    madctl = ctrlByte;
+
+    if ( scroll_shift )
+        lcd_scroll_start(0);
+    scroll_pending = 0;
+
+    lcdFrameBufferDirty(0, 0, _width, _height);         // new geometry, next push is a full frame
+    lcd_shadow_valid = 0;
+}
+
+/*------------------------------------------------
+ * lcdInvertDisplay()
+ *
+ *  inverse screen colors
+ *
+ */
+void lcdInvertDisplay(int i)
+{
+    lcdDisplayFence();
+    lcd_write_command(i ? ST7735_INVON : ST7735_INVOFF);
+}
+
+/*------------------------------------------------
+ * lcdColor565()
+ *
+ *  Pass 8-bit (each) R,G,B, get back 16-bit packed color
+ *
+ */
+uint16_t lcdColor565(uint8_t r, uint8_t g, uint8_t b)
+{
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+/*------------------------------------------------
+ * lcdSetColorBits()
+ *
+ *  set the pixel transfer format. frame buffers are RGB565 in both formats,
+ *  with 12-bit RGB444 the pixels are packed at push time and a full frame
+ *  sends 25% less SPI data, at 4 bits of color depth per channel.
+ *  the LCD content is kept, so the frame buffer shadow stays valid
+ *
+ * param:  bits    16 for RGB565 or 12 for RGB444
+ * return: previous format, or -1 if bits is not a valid format
+ */
+int lcdSetColorBits(int bits)
+{
+    int     previous;
+
+    if ( bits != 12 && bits != 16 )
+        return -1;
+
+    lcdDisplayFence();
+
+    lcd_write_command(ST7735_COLMOD);
+    lcd_write_data((bits == 12) ? COLMOD_12BIT : COLMOD_16BIT);
+
+    previous = color_bits;
+    color_bits = bits;
+
+    return previous;
+}
+
+/*------------------------------------------------
+ * lcdPixelSwap()
+ *
+ *  convert pixels between native and LCD (big-endian) byte order,
+ *  the conversion is the same in both directions.
+ *  vectorized with NEON or SSE2 when the compiler enables them
+ *
+ * param:  dst     converted pixels
+ *         src     pixels to convert, can be the same as dst
+ *         count   number of pixels
+ * return: none
+ */
+void lcdPixelSwap(uint16_t* dst, const uint16_t* src, int count)
+{
+    int     i = 0;
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    if ( dst != src )
+        memcpy(dst, src, count * sizeof(uint16_t));
+    return;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for ( ; i + 8 <= count; i += 8 )
+        vst1q_u8((uint8_t*) &dst[i], vrev16q_u8(vld1q_u8((const uint8_t*) &src[i])));
+#elif defined(__SSE2__)
+    __m128i     v;
+
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        v = _mm_loadu_si128((const __m128i*) &src[i]);
+        _mm_storeu_si128((__m128i*) &dst[i], _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+#endif
+
+    for ( ; i < count; i++ )
+        dst[i] = (uint16_t) ((src[i] << 8) | (src[i] >> 8));
+}
+
+/*------------------------------------------------
+ * lcdFrameBufferInit()
+ *
+ *  initialize a frame buffer with a color
+ *
+ */
+uint16_t* lcdFrameBufferInit(uint16_t color)
+{
+    uint16_t*   buffer;
+
+    // allocate memory and abort if cannot
+    if ( (buffer = (uint16_t*) malloc(_width * _height * sizeof(uint16_t))) == NULL )
+        return NULL;
+
+    lcdFrameBufferColor(buffer, color);                 // initialize buffer with color
+
+    return buffer;
+}
+
+/*------------------------------------------------
+ * lcdFrameBufferFree()
+ *
+ *  release memory reserved for the frame buffer
+ *
+ */
+void lcdFrameBufferFree(uint16_t* frameBufferPointer)
+{
+    free((void*) frameBufferPointer);                       // free buffer memory
+}
+
+/*------------------------------------------------
+ * lcdFrameBufferPush()
+ *
+ *  tranfer the dirty parts of the frame buffer to LCD
+ *  waits for the display thread to finish a pending push first,
+ *  do not use on buffers obtained from lcdDisplayInit() or lcdDisplaySwap()
+ *
+ * return: number of pixel data bytes sent
+ */
+int lcdFrameBufferPush(uint16_t* frameBufferPointer)
+{
+    int     sent;
+
+    lcdDisplayFence();
+
+    sent = lcd_push_spans(frameBufferPointer, dirty_first, dirty_last, scroll_pending);
+    lcd_dirty_clear();
+    scroll_pending = 0;
+
+    return sent;
+}
+
+/*------------------------------------------------
+ * lcdFrameBufferDirty()
+ *
+ *  mark a rectangle of the frame buffer as changed, so that the next
+ *  lcdFrameBufferPush() sends it to the LCD
+ *  drawing functions mark what they draw, this function is for code that
+ *  writes to the frame buffer directly
+ *
+ * param:  x, y        top left corner of the rectangle
+ *         w, h        rectangle width and height in pixels
+ * return: none
+ */
+void lcdFrameBufferDirty(int x, int y, int w, int h)
+{
+    int     row, x_last;
+
+    if ( !fb_clip(&x, &y, &w, &h) )
+        return;
+
+    x_last = x + w - 1;
+    for ( row = y; row < (y + h); row++ )
     {
-        frameBufferPointer[i] = (uint8_t) (color >> 8); // swap bytes in buffer
-        frameBufferPointer[i+1] = (uint8_t) color;      // so that writes yield correct order
+        if ( x < dirty_first[row] )
+            dirty_first[row] = x;
+        if ( x_last > dirty_last[row] )
+            dirty_last[row] = x_last;
     }
 }
 
+/*------------------------------------------------
+ * lcdFrameBufferMask()
+ *
+ *  keep a coverage mask for one frame buffer, such as an overlay layer that is
+ *  merged with other content. the mask has a byte per frame buffer pixel, the
+ *  drawing functions set it to '1' on the pixels they draw and text clears it
+ *  on the background pixels it paints, so erased text uncovers the pixels again.
+ *  lcdFrameBufferColor() clears the whole mask. anti-aliased polylines and
+ *  frame buffer scrolling do not change the mask.
+ *  the mask is kept until the next call, NULL stops keeping a mask
+ *
+ * param:  frameBuff   frame buffer that has the mask
+ *         mask        mask of (width * height) bytes
+ * return: none
+ */
+void lcdFrameBufferMask(uint16_t* frameBuff, uint8_t* mask)
+{
+    mask_frame = (frameBuff && mask) ? frameBuff : NULL;
+    mask_pixels = (frameBuff && mask) ? mask : NULL;
+}
+
+/*------------------------------------------------
+ * lcdFrameBufferColor()
+ *
+ *  initialize an existing (allocated) frame buffer with a color
+ *
+ */
+void lcdFrameBufferColor(uint16_t* frameBufferPointer, uint16_t color)
+{
+    fb_fill(frameBufferPointer, _width * _height, color);
+
+    fb_mask_rect(frameBufferPointer, 0, 0, _width, _height, 0);
+    lcdFrameBufferDirty(0, 0, _width, _height);
+}
+
 /*------------------------------------------------
  * lcdFrameBufferScroll()
  *
- *  scroll frame buffer by +/- pixels and
- *  fill new lines with color
+ *  scroll frame buffer content by +/- pixels horizontally (dx, positive to the right)
+ *  and vertically (dy, positive down), and fill the exposed lines and columns with color
+ *
+ */
+void lcdFrameBufferScroll(uint16_t* frameBufferPointer, int dx, int dy, uint16_t color)
+{
+    int         row, first, last, step;
+    int         copy_width, dst_x, src_x;
+    uint16_t   *row_pointer;
+
+    if ( dx == 0 && dy == 0 )
+        return;
+
+    if ( abs(dx) >= _width || abs(dy) >= _height )
+    {
+        lcdFrameBufferColor(frameBufferPointer, color);
+        return;
+    }
+
+    lcdFrameBufferDirty(0, 0, _width, _height);
+
+    copy_width = _width - abs(dx);
+    dst_x = (dx > 0) ? dx : 0;
+    src_x = (dx > 0) ? 0 : -dx;
+
+    // walk rows against the scroll direction so source rows are read before they are overwritten
+    if ( dy > 0 )
+    {
+        first = _height - 1;
+        last = dy - 1;
+        step = -1;
+    }
+    else
+    {
+        first = 0;
+        last = _height + dy;
+        step = 1;
+    }
+
+    for ( row = first; row != last; row += step )
+    {
+        row_pointer = &frameBufferPointer[row * _width];
+        memmove(&row_pointer[dst_x],
+                &frameBufferPointer[((row - dy) * _width) + src_x],
+                copy_width * sizeof(uint16_t));
+
+        // fill exposed columns
+        if ( dx > 0 )
+            fb_fill(row_pointer, dx, color);
+        else if ( dx < 0 )
+            fb_fill(&row_pointer[copy_width], -dx, color);
+    }
+
+    // fill exposed lines
+    first = (dy > 0) ? 0 : _height + dy;
+    fb_fill(&frameBufferPointer[first * _width], abs(dy) * _width, color);
+}
+
+/*------------------------------------------------
+ * lcdHardwareScroll()
+ *
+ *  tell the next push that the whole frame moved by +/- pixels horizontally
+ *  (dx, positive to the right) and vertically (dy, positive down) since the
+ *  last push, for example after lcdFrameBufferScroll() of the screen buffer.
+ *  a move along the scroll axis, x in landscape and y in portrait rotation,
+ *  is done by the LCD, and the push only sends the exposed lines and the
+ *  pixels that changed on top of the move, like fixed text overlays
+ *
+ * param:  dx, dy      frame move in pixels
+ * return: 1 if the LCD will scroll, 0 if the move is not along the scroll axis
+ */
+int lcdHardwareScroll(int dx, int dy)
+{
+    int     move;
+
+    if ( madctl & MADCTL_MV )
+    {
+        if ( dy != 0 )
+            return 0;
+        move = dx;
+    }
+    else
+    {
+        if ( dx != 0 )
+            return 0;
+        move = dy;
+    }
+
+    if ( move == 0 || abs(move) >= SCROLL_LINES )
+        return 0;
+
+    scroll_pending += move;
+
+    return 1;
+}
+
+/*------------------------------------------------
+ * lcdFrameBufferBlit()
+ *
+ *  copy a rectangle of pixels into the frame buffer, clipped to the screen.
+ *  the source pixels are in native byte order, like the frame buffer
+ *
+ * param:  frameBuff   pointer to allocated frame buffer
+ *         x, y        top left corner of the rectangle in the frame buffer
+ *         src         source pixels of the top left corner
+ *         w, h        rectangle width and height in pixels
+ *         stride      source pixels per row
+ * return: none
+ */
+void lcdFrameBufferBlit(uint16_t* frameBuff, int x, int y, const uint16_t* src, int w, int h, int stride)
+{
+    int     cx, cy, row;
+
+    cx = x;
+    cy = y;
+    if ( !fb_clip(&cx, &cy, &w, &h) )
+        return;
+
+    src += ((cy - y) * stride) + (cx - x);
+
+    // full width rows of a screen size source are contiguous
+    if ( w == _width && stride == _width )
+    {
+        memcpy(&frameBuff[cy * _width], src, w * h * sizeof(uint16_t));
+    }
+    else
+    {
+        for ( row = 0; row < h; row++ )
+            memcpy(&frameBuff[((cy + row) * _width) + cx], &src[row * stride], w * sizeof(uint16_t));
+    }
+
+    fb_mask_rect(frameBuff, cx, cy, w, h, 1);
+    lcdFrameBufferDirty(cx, cy, w, h);
+}
+
+/*------------------------------------------------
+ * lcdDisplayInit()
+ *
+ *  allocate a pair of frame buffers initialized with a color and start
+ *  the display thread. the LCD must be initialized and rotated first.
+ *  draw into the returned back buffer and call lcdDisplaySwap() to show it
+ *
+ * param:  color   16-bit background color
+ * return: back buffer pointer, NULL on error
+ */
+uint16_t* lcdDisplayInit(uint16_t color)
+{
+    if ( display_running )
+        return display_buffer[display_back];
+
+    display_buffer[0] = lcdFrameBufferInit(color);
+    display_buffer[1] = lcdFrameBufferInit(color);
+    if ( display_buffer[0] == NULL || display_buffer[1] == NULL )
+    {
+        lcdFrameBufferFree(display_buffer[0]);
+        lcdFrameBufferFree(display_buffer[1]);
+        display_buffer[0] = NULL;
+        display_buffer[1] = NULL;
+        return NULL;
+    }
+
+    display_back = 0;
+    display_sent = 0;
+    display_state = DISPLAY_IDLE;
+    display_running = 1;
+
+    if ( pthread_create(&display_thread, NULL, lcd_display_thread, NULL) != 0 )
+    {
+        display_running = 0;
+        lcdFrameBufferFree(display_buffer[0]);
+        lcdFrameBufferFree(display_buffer[1]);
+        display_buffer[0] = NULL;
+        display_buffer[1] = NULL;
+        return NULL;
+    }
+
+    return display_buffer[display_back];
+}
+
+/*------------------------------------------------
+ * lcdDisplayClose()
+ *
+ *  wait for the last push, stop the display thread and release the frame buffers
+ *
+ */
+void lcdDisplayClose(void)
+{
+    if ( !display_running )
+        return;
+
+    lcdDisplayFence();
+
+    pthread_mutex_lock(&display_lock);
+    display_state = DISPLAY_EXIT;
+    pthread_cond_broadcast(&display_cond);
+    pthread_mutex_unlock(&display_lock);
+
+    pthread_join(display_thread, NULL);
+    display_running = 0;
+    display_state = DISPLAY_IDLE;
+
+    lcdFrameBufferFree(display_buffer[0]);
+    lcdFrameBufferFree(display_buffer[1]);
+    display_buffer[0] = NULL;
+    display_buffer[1] = NULL;
+}
+
+/*------------------------------------------------
+ * lcdDisplaySwap()
+ *
+ *  hand the back buffer to the display thread and return the other buffer
+ *  as the new back buffer. waits if the previous push is still in progress.
+ *  the dirty spans of the handed over buffer are copied to the new back buffer
+ *  so both buffers hold the same frame when drawing resumes
+ *
+ * return: new back buffer pointer, NULL if the display thread is not running
+ */
+uint16_t* lcdDisplaySwap(void)
+{
+    uint16_t   *front, *back;
+    int         row, offset;
+
+    if ( !display_running )
+        return NULL;
+
+    lcdDisplayFence();
+
+    front = display_buffer[display_back];
+    back = display_buffer[!display_back];
+
+    // bring the new back buffer up to date with the frame about to be shown
+    for ( row = 0; row < _height; row++ )
+    {
+        if ( dirty_first[row] > dirty_last[row] )
+            continue;
+
+        offset = (row * _width) + dirty_first[row];
+        memcpy(&back[offset], &front[offset], (dirty_last[row] - dirty_first[row] + 1) * sizeof(uint16_t));
+    }
+
+    memcpy(push_first, dirty_first, sizeof(push_first));
+    memcpy(push_last, dirty_last, sizeof(push_last));
+    lcd_dirty_clear();
+    push_scroll = scroll_pending;
+    scroll_pending = 0;
+
+    pthread_mutex_lock(&display_lock);
+    display_back = !display_back;
+    display_state = DISPLAY_BUSY;
+    pthread_cond_signal(&display_cond);
+    pthread_mutex_unlock(&display_lock);
+
+    return back;
+}
+
+/*------------------------------------------------
+ * lcdDisplayFence()
+ *
+ *  wait for the display thread to finish pushing the front buffer
  *
+ * return: number of pixel data bytes sent by the last push
  */
-void lcdFrameBufferScroll(int pixels, uint16_t color)
+int lcdDisplayFence(void)
 {
+    int     sent;
+
+    if ( !display_running )
+        return 0;
+
+    pthread_mutex_lock(&display_lock);
+    while ( display_state == DISPLAY_BUSY )
+        pthread_cond_wait(&display_cond, &display_lock);
+    sent = display_sent;
+    pthread_mutex_unlock(&display_lock);
+
+    return sent;
 }
 
 /*------------------------------------------------
@@ -886,9 +2396,9 @@ void lcdFrameBufferScroll(int pixels, uint16_t color)
  *         color       16-bit color in RGB565 format
  * return: none
  */
-void lcdFillScreen(uint8_t* frameBuff, uint16_t color)
+void lcdFillScreen(uint16_t* frameBuff, uint16_t color)
 {
-    uint8_t *buffer;
+    uint16_t *buffer;
 
     // Fill existing buffer with color
     if ( frameBuff )
@@ -918,20 +2428,202 @@ void lcdFillScreen(uint8_t* frameBuff, uint16_t color)
  *         color       16-bit color in RGB565 format
  * return: none
  */
-void lcdDrawPixel(uint8_t* frameBuff, int x, int y, uint16_t color)
+void lcdDrawPixel(uint16_t* frameBuff, int x, int y, uint16_t color)
 {
     if ((x < 0) || (x >= _width) || (y < 0) || (y >= _height))
         return;
 
+    // frame buffer raster path, no LCD access
+    if ( frameBuff )
+    {
+        frameBuff[x + y*_width] = color;
+        fb_mask_rect(frameBuff, x, y, 1, 1, 1);
+        lcdFrameBufferDirty(x, y, 1, 1);
+        return;
+    }
+
+    lcdDisplayFence();
+
     lcd_set_addr_window(x,y,x+1,y+1);
 
-    lcd_push_color(frameBuff, color);
+    lcd_push_color(color);
+}
+
+/*------------------------------------------------
+ * lcdFillRect()
+ *
+ *  Draw a filled rectangle with solid color, clipped to the screen
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         x, y        top left corner of the rectangle
+ *         w, h        rectangle width and height in pixels
+ *         color       16-bit color in RGB565 format
+ * return: none
+ */
+void lcdFillRect(uint16_t* frameBuff, int x, int y, int w, int h, uint16_t color)
+{
+    if ( !fb_clip(&x, &y, &w, &h) )
+        return;
+
+    // frame buffer raster path, no LCD access
+    if ( frameBuff )
+    {
+        fb_fill_rect(frameBuff, x, y, w, h, color);
+        return;
+    }
+
+    lcdDisplayFence();
+    lcd_set_addr_window(x, y, x+w-1, y+h-1);
+    lcd_shadow_valid = 0;
+
+    // the display thread is idle, so its transmit buffer
+    // is used to send the rectangle in one transfer
+    fb_fill(lcd_tx, w*h, color);
+    lcd_write_pixels(lcd_tx, w*h);
+}
+
+/*------------------------------------------------
+ * lcdDrawHLine()
+ *
+ *  Draw a horizontal line from (x,y) to the right
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         x, y        left end of the line
+ *         w           line length in pixels
+ *         color       16-bit color in RGB565 format
+ * return: none
+ */
+void lcdDrawHLine(uint16_t* frameBuff, int x, int y, int w, uint16_t color)
+{
+    lcdFillRect(frameBuff, x, y, w, 1, color);
+}
+
+/*------------------------------------------------
+ * lcdDrawVLine()
+ *
+ *  Draw a vertical line from (x,y) down
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         x, y        top end of the line
+ *         h           line length in pixels
+ *         color       16-bit color in RGB565 format
+ * return: none
+ */
+void lcdDrawVLine(uint16_t* frameBuff, int x, int y, int h, uint16_t color)
+{
+    int         row, w = 1;
+    uint16_t   *pixel;
+
+    if ( !frameBuff )
+    {
+        lcdFillRect(NULL, x, y, w, h, color);
+        return;
+    }
+
+    if ( !fb_clip(&x, &y, &w, &h) )
+        return;
+
+    pixel = &frameBuff[(y * _width) + x];
+    for ( row = 0; row < h; row++ )
+    {
+        *pixel = color;
+        pixel += _width;
+    }
+
+    fb_mask_rect(frameBuff, x, y, 1, h, 1);
+    lcdFrameBufferDirty(x, y, 1, h);
+}
+
+/*------------------------------------------------
+ * lcdDrawRect()
+ *
+ *  Draw a rectangle outline
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         x, y        top left corner of the rectangle
+ *         w, h        rectangle width and height in pixels
+ *         color       16-bit color in RGB565 format
+ * return: none
+ */
+void lcdDrawRect(uint16_t* frameBuff, int x, int y, int w, int h, uint16_t color)
+{
+    if ( w <= 0 || h <= 0 )
+        return;
+
+    lcdDrawHLine(frameBuff, x, y, w, color);
+    if ( h > 1 )
+        lcdDrawHLine(frameBuff, x, y + h - 1, w, color);
+
+    if ( h > 2 )
+    {
+        lcdDrawVLine(frameBuff, x, y + 1, h - 2, color);
+        if ( w > 1 )
+            lcdDrawVLine(frameBuff, x + w - 1, y + 1, h - 2, color);
+    }
+}
+
+/*------------------------------------------------
+ * lcdDrawPolyline()
+ *
+ *  Draw connected line segments into the frame buffer, anti-aliased and
+ *  with a line width. Segments are clipped to the screen, so a long path
+ *  with most of its points off the screen costs little more than its
+ *  visible part.
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, must not be NULL
+ *         points      segment end points in 1/LCD_SUBPIXEL pixel
+ *         count       number of points
+ *         width       line width in pixels
+ *         color       16-bit color in RGB565 format
+ * return: none
+ */
+void lcdDrawPolyline(uint16_t* frameBuff, const struct lcd_point_t* points, int count, int width, uint16_t color)
+{
+    int         i, joined;
+    int64_t     x0, y0, x1, y1, margin;
+
+    if ( frameBuff == NULL || width < 1 )
+        return;
+
+    margin = (int64_t) (width + 1) << AA_Q16;
+    joined = 0;
+
+    // a single point is drawn as a dot
+    if ( count == 1 )
+    {
+        x0 = (int64_t) points[0].x << (AA_Q16 - LCD_SUBPIXEL_BITS);
+        y0 = (int64_t) points[0].y << (AA_Q16 - LCD_SUBPIXEL_BITS);
+        if ( fb_clip_segment(&x0, &y0, &x0, &y0, margin) )
+            fb_draw_segment(frameBuff, x0, y0, x0, y0, width, 0, color);
+        return;
+    }
+
+    for ( i = 1; i < count; i++ )
+    {
+        x0 = (int64_t) points[i - 1].x << (AA_Q16 - LCD_SUBPIXEL_BITS);
+        y0 = (int64_t) points[i - 1].y << (AA_Q16 - LCD_SUBPIXEL_BITS);
+        x1 = (int64_t) points[i].x << (AA_Q16 - LCD_SUBPIXEL_BITS);
+        y1 = (int64_t) points[i].y << (AA_Q16 - LCD_SUBPIXEL_BITS);
+
+        // the start of a segment is the end of the previous one,
+        // unless the previous segment was clipped at its end
+        if ( !fb_clip_segment(&x0, &y0, &x1, &y1, margin) )
+        {
+            joined = 0;
+            continue;
+        }
+
+        fb_draw_segment(frameBuff, x0, y0, x1, y1, width, joined, color);
+        joined = (x1 == ((int64_t) points[i].x << (AA_Q16 - LCD_SUBPIXEL_BITS)) &&
+                  y1 == ((int64_t) points[i].y << (AA_Q16 - LCD_SUBPIXEL_BITS)));
+    }
 }
 
 /*------------------------------------------------
  * lcdDrawLine()
  *
- *  Draw a line from starting point to end point
+ *  Draw a line from starting point to end point,
+ *  pixels outside of the screen are not drawn
  *
  * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
  *         xs, ys      starting point pixel
@@ -939,39 +2631,25 @@ void lcdDrawPixel(uint8_t* frameBuff, int x, int y, uint16_t color)
  *         color       16-bit color in RGB565 format
  * return: none
  */
-void lcdDrawLine(uint8_t* frameBuff, int xs, int ys, int xe, int ye, uint16_t color)
+void lcdDrawLine(uint16_t* frameBuff, int xs, int ys, int xe, int ye, uint16_t color)
 {
     int     pix, piy;
+    uint8_t *cover;
 
     int     dx, sx;     // Bresenham's line algorithm variables,
     int     dy, sy;
     int     err, e2;
 
-    // Rudimentary clipping
-    if ( xe >= _width )
-        xe = _width;
-
-    if ( xs < 0 )
-        xs = 0;
-
-    if ( ye >= _height )
-        ye = _height;
-
-    if ( ys < 0 )
-        ys = 0;
-
     // Handle a vertical line
     if ( xs == xe )
     {
-        for ( piy = ys; piy <= ye; piy++ )
-            lcdDrawPixel(frameBuff, xs, piy, color);
+        lcdDrawVLine(frameBuff, xs, (ys < ye) ? ys : ye, abs(ye - ys) + 1, color);
     }
 
     // Handle a horizontal line
     else if ( ys == ye )
     {
-        for ( pix = xs; pix <= xe; pix++ )
-            lcdDrawPixel(frameBuff, pix, ys, color);
+        lcdDrawHLine(frameBuff, (xs < xe) ? xs : xe, ys, abs(xe - xs) + 1, color);
     }
 
     // Handle a general case line from any start to any end point
@@ -986,11 +2664,29 @@ void lcdDrawLine(uint8_t* frameBuff, int xs, int ys, int xe, int ye, uint16_t co
         err = (dx>dy ? dx : -dy)/2;
         pix = xs;
         piy = ys;
+        cover = fb_mask(frameBuff);
 
-        // loop until line drawing is done
-        while ( pix != xe || piy != ye )
+        // loop until line drawing is done, frame buffer
+        // pixels are written and marked dirty in place
+        while ( 1 )
         {
-            lcdDrawPixel(frameBuff, pix, piy, color);
+            if ( !frameBuff )
+            {
+                lcdDrawPixel(NULL, pix, piy, color);
+            }
+            else if ( pix >= 0 && pix < _width && piy >= 0 && piy < _height )
+            {
+                frameBuff[(piy * _width) + pix] = color;
+                if ( cover )
+                    cover[(piy * _width) + pix] = 1;
+                if ( pix < dirty_first[piy] )
+                    dirty_first[piy] = pix;
+                if ( pix > dirty_last[piy] )
+                    dirty_last[piy] = pix;
+            }
+
+            if ( pix == xe && piy == ye )
+                break;
 
             // calculate next pixel coordinates
             e2 = err;
@@ -1026,10 +2722,11 @@ void lcdDrawLine(uint8_t* frameBuff, int xs, int ys, int xe, int ye, uint16_t co
  * return: none
  *
  */
-void lcdDrawChar(uint8_t* frameBuff, uint16_t x, uint16_t y, char c, uint16_t textColor, uint16_t bgColor, int scale, int transparent)
+void lcdDrawChar(uint16_t* frameBuff, uint16_t x, uint16_t y, char c, uint16_t textColor, uint16_t bgColor, int scale, int transparent)
 {
     uint8_t   line;             // horizontal row of pixels of character
     uint16_t  col, row, i, j;   // loop indices
+    uint16_t *pixel;
 
     // do some range checking of 'x' an 'y' coordinates
     if (((x + FONT_PIX_WIDE*scale - 1) >= _width)  ||
@@ -1038,10 +2735,23 @@ void lcdDrawChar(uint8_t* frameBuff, uint16_t x, uint16_t y, char c, uint16_t te
         return;
     }
 
+    // frame buffer raster path, no LCD access
+    if ( frameBuff )
+    {
+        fb_draw_char(frameBuff, x, y, c, textColor, bgColor, scale, transparent);
+        return;
+    }
+
+    lcdDisplayFence();
+
     lcd_set_addr_window(x, y, x+FONT_PIX_WIDE*scale-1, y+FONT_PIX_HIGH*scale-1);
+    lcd_shadow_valid = 0;
 
     // print character rows starting at the top row
-    // print the columns, starting on the left
+    // print the columns, starting on the left.
+    // the display thread is idle, so the character is built
+    // in its transmit buffer and sent in one transfer
+    pixel = lcd_tx;
     line = 0x01;
     for ( row = 0; row < FONT_PIX_HIGH; row++ )
     {
@@ -1052,21 +2762,11 @@ void lcdDrawChar(uint8_t* frameBuff, uint16_t x, uint16_t y, char c, uint16_t te
                 for ( j = 0; j < scale; j++ )
                 {
                     // Bit is set in Font, print pixel(s) in text color
-                    if ( Font[(c*FONT_PIX_WIDE+col)] & line )
-                        lcd_push_color(frameBuff, textColor);
-
-                    // Bit is cleared in Font
+                    // otherwise always paint background on LCD
+                    if ( Font[((uint8_t) c * FONT_PIX_WIDE) + col] & line )
+                        *(pixel++) = textColor;
                     else
-                    {
-                        // Always paint background on LCD, or if background is not transparent
-                        if ( frameBuff == NULL || !transparent )
-                            lcd_push_color(frameBuff, bgColor);
-
-                        // Pixel is transparent and sent only to buffer
-                        // so only advance row/column positions
-                        else
-                            update_row_column_addr();
-                    }
+                        *(pixel++) = bgColor;
                 }
             }
         }
@@ -1074,4 +2774,6 @@ void lcdDrawChar(uint8_t* frameBuff, uint16_t x, uint16_t y, char c, uint16_t te
         // move up to the next row
         line = line << 1;
     }
+
+    lcd_write_pixels(lcd_tx, pixel - lcd_tx);
 }
@@ -18,13 +18,18 @@
 #include    <unistd.h>
 #include    <fcntl.h>
 #include    <errno.h>
-#include    <termios.h>
 #include    <string.h>
+#include    <time.h>
+#include    <math.h>
+#include    <poll.h>
 
 #include    "test.h"
 #include    "pilcd.h"
 #include    "vt100lcd.h"
 #include    "util.h"
+#include    "map.h"
+#include    "gps.h"
+#include    "hal.h"
 #include    "config.h"
 
 /********************************************************************
@@ -35,11 +40,73 @@
 #define     PATTERN1_FILE   "res/pattern1.raw"
 #define     PATTERN2_FILE   "res/pattern2.raw"
 
-static union frame_buffer_t
-{
-    uint16_t pixel_words[FRAME_BUFF_SIZE];
-    uint8_t  pixel_bytes[2*FRAME_BUFF_SIZE];
-} frame_buffer;
+#define     TEST_MAP_WIDTH  256         // Synthetic map image for map patch tests
+#define     TEST_MAP_HEIGHT 255         //  pixel value encodes its own (u,v) coordinate
+#define     TEST_ROI_WIDTH  ST7735_TFTHEIGHT
+#define     TEST_ROI_HEIGHT ST7735_TFTWIDTH
+#define     TEST_BENCH_REPS 20
+#define     TEST_EDGE_POSITIONS 5
+#define     TEST_HEADING_STEP   3       // heading steps between compared patches
+#define     TEST_BIG_MAP_WIDTH  1032    // Synthetic map image for frame time vs. heading test
+#define     TEST_BIG_MAP_HEIGHT 800
+#define     TEST_SCROLL_STEPS   60      // patch moves per heading in the scroll test
+#define     TEST_SCROLL_HEADINGS 5
+#define     TEST_PUSH_UPDATES   20      // GPS data screen updates in the dirty push test
+#define     TEST_PUSH_MAX_BYTES 1024    //  and maximum pixel data bytes per update
+#define     TEST_RASTER_DRAWS   5000    // random pixel and character draws in the dirty push test
+#define     TEST_SWAP_FRAMES    100     // frames drawn in the display thread test
+#define     TEST_TIMER_SECONDS  3       // frame timer test duration
+#define     TEST_TIMER_SLACK    0.02    //  and allowed average frame period error
+#define     TEST_HWSCROLL_STEPS 40      // frame moves in the hardware scroll test
+#define     TEST_DRAW_SHAPES    500     // random shapes in the drawing primitives test
+#define     TEST_TRACK_DOTS     100     // projected track points per heading in the track test
+#define     TEST_TRACK_SEGMENTS 60      //  random polyline segments in the coverage check
+#define     TEST_TRACK_POINTS   5000    //  and breadcrumb trail points in the benchmark
+#define     TEST_COLOR_FRAMES   20      // full frames pushed per pixel transfer format
+#define     TEST_PROBE_ROW      4       // text cell with a probe pixel in the text cell test
+#define     TEST_PROBE_COL      10
+#define     TEST_FIELD_VALUES   2000    // random values in the numeric field test
+#define     TEST_FIELD_ROW      2       //  and the row of the field under test
+#define     TEST_GPS_FIELDS     8       // numeric fields of the GPS data screen
+#define     TEST_HUD_HEADINGS   3       // headings and patch moves per heading in the HUD test
+#define     TEST_HUD_STEPS      40
+#define     TEST_UART_TIMEOUT   1000    // GPS line wait in mSec
+#define     TEST_IDLE_WAIT      200     // idle line reader wait in mSec in the line reader test
+#define     TEST_IDLE_CPU       0.05    //  and the largest CPU time fraction used by the wait
+#define     TEST_GPS_STALL      200     // UI stall in mSec in the GPS thread test
+#define     TEST_GPS_STREAM     1200    //  sentences streamed while fixes are read
+#define     TEST_GPS_BURST      6       //  sentences per burst, as sent by the GPS every second
+#define     TEST_GPS_OVERRUN    8       //  and sentences written beyond a full fix queue
+#define     TEST_NMEA_VARIANTS  5       // checksum variants of every sentence in the NMEA parser test
+#define     TEST_NMEA_REPS      2000    //  and parse time repetitions
+#define     TEST_DECODE_VALUES  100000  // random fields of each type in the NMEA decoder test
+#define     TEST_DECODE_REPS    100000  //  and decode time repetitions
+#define     TEST_GLYPH_COLORS   6       // text and background colors in the glyph cache test, more than cache entries
+#define     TEST_GLYPH_SCALE    5       //  largest scale, above the largest cached scale
+#define     TEST_GLYPH_DRAWS    100000  //  and characters drawn for the draw time
+
+static uint16_t frame_buffer[FRAME_BUFF_SIZE];
+
+static uint16_t ref_frame_buffer[FRAME_BUFF_SIZE];
+
+static uint16_t test_pattern[FRAME_BUFF_SIZE];
+
+static int      gps_fields[TEST_GPS_FIELDS];
+
+static void   ref_map_patch(struct position_t *, struct map_t *, uint16_t *, uint16_t *, int, int);
+static int    cmp_map_patch(uint16_t *, uint16_t *, int);
+static double time_usec(void);
+static int    lcd_test_init(void);
+static void   gps_screen_update(uint16_t *, int);
+static void   gps_field_screen(uint16_t *);
+static void   gps_field_update(uint16_t *, int);
+static int    gps_sentence(char *, int, int);
+static void   scroll_pattern(uint16_t *, int, int, int);
+static void   hud_text(uint16_t *, int, char);
+static void   ref_fill_rect(uint16_t *, int, int, int, int, uint16_t);
+static void   ref_draw_char(uint16_t *, uint16_t, uint16_t, char, uint16_t, uint16_t, int, int);
+static double ref_segment_distance(double, double, const struct lcd_point_t *, const struct lcd_point_t *);
+static int    ref_nmea_update_pos(char *, struct position_t *);
 
 /********************************************************************
  * test_t0_lcd()
@@ -59,55 +126,39 @@ int test_t0_lcd(void)
     
     // try to initialize GPIO subsystem
     printf("  Initializing GPIO\n");
-    if ( !bcm2835_init() )
+    if ( hal_init() == -1 )
     {
-        printf("  bcm2835_init failed. Are you running as root?\n");
+        printf("  hal_init failed. Are you running as root?\n");
         return -1;
     }
     
-    // Initialize RST GPIO pin
-    bcm2835_gpio_fsel(LCD_RST, BCM2835_GPIO_FSEL_OUTP);
-    bcm2835_gpio_write(LCD_RST, HIGH);
- 
-    // Initialize SPI
+    // Initialize SPI and reset the devices on the SPI bus
     printf("  Initializing SPI\n");
-    if (!bcm2835_spi_begin())
+    if ( lcdBusInit() == -1 )
     {
-        printf("  bcm2835_spi_begin failed. Are you running as root??\n");
+        printf("  lcdBusInit failed. Is the SPI bus accessible?\n");
         return -1;
     }
     
-    // Initialize SPI for the LCD according to wiring
-    bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
-    bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
-    bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_8);
-    bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
-    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
-
-    // Reset the devices on the SPI bus
-    bcm2835_gpio_write(LCD_RST, LOW);
-    bcm2835_delay(250);
-    bcm2835_gpio_write(LCD_RST, HIGH);
-    
     // LCD initialization and test
     printf("  Testing LCD display\n");
     lcdInit();
     lcdSetRotation(3);
 
     printf("  Red\n");
-    lcdFrameBufferColor(frame_buffer.pixel_bytes, ST7735_RED);
-    lcdFrameBufferPush(frame_buffer.pixel_bytes);
-    bcm2835_delay(2000);
+    lcdFrameBufferColor(frame_buffer, ST7735_RED);
+    lcdFrameBufferPush(frame_buffer);
+    hal_delay(2000);
     
     printf("  Green\n");
-    lcdFrameBufferColor(frame_buffer.pixel_bytes, ST7735_GREEN);
-    lcdFrameBufferPush(frame_buffer.pixel_bytes);
-    bcm2835_delay(2000);
+    lcdFrameBufferColor(frame_buffer, ST7735_GREEN);
+    lcdFrameBufferPush(frame_buffer);
+    hal_delay(2000);
 
     printf("  Blue\n");
-    lcdFrameBufferColor(frame_buffer.pixel_bytes, ST7735_BLUE);
-    lcdFrameBufferPush(frame_buffer.pixel_bytes);
-    bcm2835_delay(2000);
+    lcdFrameBufferColor(frame_buffer, ST7735_BLUE);
+    lcdFrameBufferPush(frame_buffer);
+    hal_delay(2000);
 
     fd = open(PATTERN1_FILE, O_RDONLY);
     if ( fd == -1 )
@@ -118,10 +169,12 @@ int test_t0_lcd(void)
     else
     {
         printf("  %s\n", PATTERN1_FILE);
-        read(fd, (void*) frame_buffer.pixel_bytes, (2*FRAME_BUFF_SIZE));
+        read(fd, (void*) frame_buffer, (2*FRAME_BUFF_SIZE));
         close(fd);
-        lcdFrameBufferPush(frame_buffer.pixel_bytes);
-        bcm2835_delay(2000);
+        lcdPixelSwap(frame_buffer, frame_buffer, FRAME_BUFF_SIZE);
+        lcdFrameBufferDirty(0, 0, lcdWidth(), lcdHeight());
+        lcdFrameBufferPush(frame_buffer);
+        hal_delay(2000);
     }
  
     fd = open(PATTERN2_FILE, O_RDONLY);
@@ -133,24 +186,26 @@ int test_t0_lcd(void)
     else
     {
         printf("  %s\n", PATTERN2_FILE);
-        read(fd, (void*) frame_buffer.pixel_bytes, (2*FRAME_BUFF_SIZE));
+        read(fd, (void*) frame_buffer, (2*FRAME_BUFF_SIZE));
         close(fd);
-        lcdFrameBufferPush(frame_buffer.pixel_bytes);
-        bcm2835_delay(2000);
+        lcdPixelSwap(frame_buffer, frame_buffer, FRAME_BUFF_SIZE);
+        lcdFrameBufferDirty(0, 0, lcdWidth(), lcdHeight());
+        lcdFrameBufferPush(frame_buffer);
+        hal_delay(2000);
     }
     
-    lcdFrameBufferColor(frame_buffer.pixel_bytes, ST7735_BLACK);
-    lcdFrameBufferPush(frame_buffer.pixel_bytes);
+    lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+    lcdFrameBufferPush(frame_buffer);
 
     //lcdOff();
     
     printf("Done\n");
     
     // Close SPI
-    bcm2835_spi_end();
+    lcdBusClose();
 
     // Close GPIO
-    bcm2835_close();
+    hal_close();
 
     return 0;
 }
@@ -173,27 +228,18 @@ int test_t1_pbuttons(void)
     
     // try to initialize GPIO subsystem
     printf("  Initializing GPIO\n");
-    if ( !bcm2835_init() )
+    if ( hal_init() == -1 )
     {
-        printf("  bcm2835_init failed. Are you running as root?\n");
+        printf("  hal_init failed. Are you running as root?\n");
         return -1;
     }
 
     // Initialize GPIO pins for input with pull-up enabled
-    bcm2835_gpio_fsel(PBUTTON_UP, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_UP, BCM2835_GPIO_PUD_UP);
-
-    bcm2835_gpio_fsel(PBUTTON_DOWN, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_DOWN, BCM2835_GPIO_PUD_UP);
-
-    bcm2835_gpio_fsel(PBUTTON_LEFT, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_LEFT, BCM2835_GPIO_PUD_UP);
-
-    bcm2835_gpio_fsel(PBUTTON_RIGHT, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_RIGHT, BCM2835_GPIO_PUD_UP);
-
-    bcm2835_gpio_fsel(PBUTTON_SELECT, BCM2835_GPIO_FSEL_INPT);
-    bcm2835_gpio_set_pud(PBUTTON_SELECT, BCM2835_GPIO_PUD_UP);
+    hal_gpio_input(PBUTTON_UP);
+    hal_gpio_input(PBUTTON_DOWN);
+    hal_gpio_input(PBUTTON_LEFT);
+    hal_gpio_input(PBUTTON_RIGHT);
+    hal_gpio_input(PBUTTON_SELECT);
 
 
     // Loop here and report pushbuttons that are pressed
@@ -201,40 +247,40 @@ int test_t1_pbuttons(void)
     printf("  Will quit after 20 presses\n");
     while ( i < 20 )
     {
-        if ( bcm2835_gpio_lev(PBUTTON_UP) == LOW )
+        if ( hal_gpio_read(PBUTTON_UP) == LOW )
         {
             printf("  %2d UP\n", i);
             i++;
-            bcm2835_delay(500);
+            hal_delay(500);
         }
-        else if ( bcm2835_gpio_lev(PBUTTON_DOWN) == LOW )
+        else if ( hal_gpio_read(PBUTTON_DOWN) == LOW )
         {
             printf("  %2d DOWN\n", i);
             i++;
-            bcm2835_delay(500);
+            hal_delay(500);
         }
-        else if ( bcm2835_gpio_lev(PBUTTON_LEFT) == LOW )
+        else if ( hal_gpio_read(PBUTTON_LEFT) == LOW )
         {
             printf("  %2d LEFT\n", i);
             i++;
-            bcm2835_delay(500);
+            hal_delay(500);
         }
-        else if ( bcm2835_gpio_lev(PBUTTON_RIGHT) == LOW )
+        else if ( hal_gpio_read(PBUTTON_RIGHT) == LOW )
         {
             printf("  %2d RIGHT\n", i);
             i++;
-            bcm2835_delay(500);
+            hal_delay(500);
         }
-        else if ( bcm2835_gpio_lev(PBUTTON_SELECT) == LOW )
+        else if ( hal_gpio_read(PBUTTON_SELECT) == LOW )
         {
             printf("  %2d SELECT\n", i);
             i++;
-            bcm2835_delay(500);
+            hal_delay(500);
         }
     }
 
     // Close GPIO
-    bcm2835_close();
+    hal_close();
 
     return 0;
 }
@@ -254,14 +300,15 @@ int test_t2_gps(void)
     int     newline_count = 0;
     int     uart_fd;
     int     read_result;
-    char    nmea_text[512] = {0};
+    char   *nmea_text;
+    struct  uart_reader_t   uart;
     struct  position_t  pos;
     int     valid_fix;
     
     printf("Test t2\n");
     
     // Open UART0 port
-    uart_fd = open(UART0, O_RDWR | O_NOCTTY | O_NDELAY);
+    uart_fd = hal_uart_open();
     if ( uart_fd == -1 )
     {
         printf("  Error %d opening %s\n", errno, UART0);
@@ -270,20 +317,15 @@ int test_t2_gps(void)
     else
     {
         printf("  Initializing UART0\n");
-        
-        // Setup UART options
-        uart_set_interface_attr(uart_fd, B9600, 0);
-        uart_set_blocking(uart_fd, 0);
+        uart_reader_init(&uart, uart_fd);
         
         // Read some data and print to stdout
-        fcntl(uart_fd, F_SETFL, FNDELAY);
-        
         memset(&pos, 0, sizeof(struct  position_t));
 
         while ( newline_count < 60 )
         {
             // try to read a text line from the UART
-            read_result = uart_read_line(uart_fd, nmea_text, 512);
+            read_result = uart_read_line(&uart, &nmea_text, TEST_UART_TIMEOUT);
 
             // if an error occurred, then abort
             if ( read_result < 0 )
@@ -326,3 +368,2859 @@ int test_t2_gps(void)
     return 0;
 }
 
+/********************************************************************
+ * test_t3_map_patch()
+ *
+ *  Render map patches from a synthetic map image at sub-degree headings,
+ *  compare the fixed-point kernel of get_map_patch() to the original
+ *  floating point transform, compare the SIMD kernel (if built) to the
+ *  scalar kernel, compare the cardinal heading (quadrant) kernel to the
+ *  rotation kernel, and print the time per frame of all kernels.
+ *  Each synthetic map pixel encodes its own coordinate, so the comparison
+ *  allows a difference of one source pixel in each direction.
+ *  Does not require any hardware.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or kernel mismatch
+ *
+ */
+int test_t3_map_patch(void)
+{
+    static const double edge_pos[TEST_EDGE_POSITIONS][2] =
+        {{0.5, 0.5}, {0.98, 0.03}, {0.03, 0.98}, {0.7, 0.95}, {-0.5, 0.5}};
+
+    uint16_t       *image_buffer, *ref_image;
+    struct map_t    map_attrib;
+    struct position_t   pos;
+    int     u, v, theta, rep, p;
+    int     mismatch = 0;
+    double  start, ref_time, fixed_time, simd_time;
+
+    printf("Test t3\n");
+
+    // The reference transform reads a row-major image, the kernels
+    // read the image in the build's layout
+    ref_image = malloc(sizeof(uint16_t) * TEST_MAP_WIDTH * TEST_MAP_HEIGHT);
+    image_buffer = malloc(sizeof(uint16_t) * map_image_pixels(TEST_MAP_WIDTH, TEST_MAP_HEIGHT));
+    if ( ref_image == NULL || image_buffer == NULL )
+    {
+        printf("  Error allocating map image\n");
+        free(ref_image);
+        free(image_buffer);
+        return -1;
+    }
+
+    // Build a synthetic map where pixel value is (v*256 + u + 1),
+    // value '0' is reserved for out of map black pixels
+    for ( v = 0; v < TEST_MAP_HEIGHT; v++ )
+    {
+        for ( u = 0; u < TEST_MAP_WIDTH; u++ )
+            ref_image[v * TEST_MAP_WIDTH + u] = (uint16_t)((v << 8) + u + 1);
+        map_image_store_row(image_buffer, TEST_MAP_WIDTH, v, &ref_image[v * TEST_MAP_WIDTH]);
+    }
+
+    memset(&map_attrib, 0, sizeof(struct map_t));
+    strncpy(map_attrib.file_name, "synthetic", MAX_FILE_NAME_LEN);
+    map_attrib.width = TEST_MAP_WIDTH;
+    map_attrib.height = TEST_MAP_HEIGHT;
+    map_attrib.tl_lat = 1.0;
+    map_attrib.tl_long = 0.0;
+    map_attrib.br_lat = 0.0;
+    map_attrib.br_long = 1.0;
+
+    memset(&pos, 0, sizeof(struct position_t));
+    pos.latitude = 0.5;
+    pos.longitude = 0.5;
+
+    // Compare kernels at headings in sub-degree steps, the scalar kernel against the
+    // floating point transform and the SIMD kernel bit-exact against the scalar kernel
+    printf("  Comparing kernels, SIMD kernel is '%s'\n", MAP_SIMD_NAME);
+    for ( theta = 0; theta < MAP_HEADING_FULL; theta += TEST_HEADING_STEP )
+    {
+        pos.heading = (float)theta / MAP_HEADING_RES;
+        map_patch_kernel(MAP_KERNEL_SCALAR);
+        get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+        ref_map_patch(&pos, &map_attrib, ref_image, ref_frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+        if ( cmp_map_patch(frame_buffer, ref_frame_buffer, TEST_ROI_WIDTH * TEST_ROI_HEIGHT) )
+        {
+            printf("  Scalar kernel mismatch at heading %.1f\n", pos.heading);
+            mismatch++;
+        }
+
+        if ( map_patch_kernel(MAP_KERNEL_SIMD) == MAP_KERNEL_SIMD )
+        {
+            get_map_patch(&pos, &map_attrib, image_buffer, ref_frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+            if ( memcmp(frame_buffer, ref_frame_buffer, sizeof(uint16_t) * TEST_ROI_WIDTH * TEST_ROI_HEIGHT) )
+            {
+                printf("  SIMD kernel mismatch at heading %.1f\n", pos.heading);
+                mismatch++;
+            }
+        }
+
+        // At cardinal headings compare the quadrant kernel bit-exact against
+        // the rotation kernel, also with the patch clipped at the map edges
+        if ( (theta % MAP_HEADING_QUARTER) == 0 )
+        {
+            for ( p = 0; p < TEST_EDGE_POSITIONS; p++ )
+            {
+                pos.latitude = edge_pos[p][0];
+                pos.longitude = edge_pos[p][1];
+                map_patch_kernel(MAP_KERNEL_SCALAR);
+                get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+                map_patch_kernel(MAP_KERNEL_SCALAR | MAP_KERNEL_NO_QUADRANT);
+                get_map_patch(&pos, &map_attrib, image_buffer, ref_frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+                if ( memcmp(frame_buffer, ref_frame_buffer, sizeof(uint16_t) * TEST_ROI_WIDTH * TEST_ROI_HEIGHT) )
+                {
+                    printf("  Quadrant kernel mismatch at heading %.1f position %d\n", pos.heading, p);
+                    mismatch++;
+                }
+            }
+
+            pos.latitude = 0.5;
+            pos.longitude = 0.5;
+        }
+    }
+
+    // Time all kernels over all headings
+    start = time_usec();
+    for ( rep = 0; rep < TEST_BENCH_REPS; rep++ )
+        for ( theta = 0; theta < 360; theta++ )
+        {
+            pos.heading = (float)theta;
+            ref_map_patch(&pos, &map_attrib, ref_image, ref_frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+        }
+    ref_time = (time_usec() - start) / (TEST_BENCH_REPS * 360);
+
+    map_patch_kernel(MAP_KERNEL_SCALAR);
+    start = time_usec();
+    for ( rep = 0; rep < TEST_BENCH_REPS; rep++ )
+        for ( theta = 0; theta < 360; theta++ )
+        {
+            pos.heading = (float)theta;
+            get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+        }
+    fixed_time = (time_usec() - start) / (TEST_BENCH_REPS * 360);
+
+    printf("  Floating point kernel %8.1f [usec/frame]\n", ref_time);
+    printf("  Fixed point kernel    %8.1f [usec/frame]\n", fixed_time);
+
+    if ( map_patch_kernel(MAP_KERNEL_SIMD) == MAP_KERNEL_SIMD )
+    {
+        start = time_usec();
+        for ( rep = 0; rep < TEST_BENCH_REPS; rep++ )
+            for ( theta = 0; theta < 360; theta++ )
+            {
+                pos.heading = (float)theta;
+                get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+            }
+        simd_time = (time_usec() - start) / (TEST_BENCH_REPS * 360);
+
+        printf("  SIMD %-4s kernel      %8.1f [usec/frame]\n", MAP_SIMD_NAME, simd_time);
+    }
+
+    printf("  %d mismatches\n", mismatch);
+
+    free(ref_image);
+    free(image_buffer);
+
+    printf("Done\n");
+
+    return mismatch ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t4_map_heading()
+ *
+ *  Time get_map_patch() per heading on a synthetic map image of
+ *  typical map size, to show the effect of the map image memory
+ *  layout on frame time. Prints frame time at 15 degree heading steps
+ *  and the ratio of slowest to fastest heading, and the frame time
+ *  in north-up mode.
+ *  Does not require any hardware.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error
+ *
+ */
+int test_t4_map_heading(void)
+{
+    uint16_t       *image_buffer;
+    uint16_t        row_buffer[TEST_BIG_MAP_WIDTH];
+    struct map_t    map_attrib;
+    struct position_t   pos;
+    int     u, v, theta, rep;
+    double  start, frame_time, min_time, max_time;
+
+    printf("Test t4\n");
+
+    image_buffer = malloc(sizeof(uint16_t) * map_image_pixels(TEST_BIG_MAP_WIDTH, TEST_BIG_MAP_HEIGHT));
+    if ( image_buffer == NULL )
+    {
+        printf("  Error allocating map image\n");
+        return -1;
+    }
+
+    for ( v = 0; v < TEST_BIG_MAP_HEIGHT; v++ )
+    {
+        for ( u = 0; u < TEST_BIG_MAP_WIDTH; u++ )
+            row_buffer[u] = (uint16_t)((v * TEST_BIG_MAP_WIDTH) + u);
+        map_image_store_row(image_buffer, TEST_BIG_MAP_WIDTH, v, row_buffer);
+    }
+
+    memset(&map_attrib, 0, sizeof(struct map_t));
+    strncpy(map_attrib.file_name, "synthetic", MAX_FILE_NAME_LEN);
+    map_attrib.width = TEST_BIG_MAP_WIDTH;
+    map_attrib.height = TEST_BIG_MAP_HEIGHT;
+    map_attrib.tl_lat = 1.0;
+    map_attrib.tl_long = 0.0;
+    map_attrib.br_lat = 0.0;
+    map_attrib.br_long = 1.0;
+
+    memset(&pos, 0, sizeof(struct position_t));
+
+    printf("  Map image %dx%d, %s layout, SIMD kernel is '%s'\n",
+           TEST_BIG_MAP_WIDTH, TEST_BIG_MAP_HEIGHT, MAP_TILED_IMAGE ? "tiled" : "row-major", MAP_SIMD_NAME);
+
+    min_time = 1.0e9;
+    max_time = 0.0;
+
+    // Move the position between frames so consecutive frames
+    // do not hit the same (cached) map image area
+    for ( theta = 0; theta < 360; theta += 15 )
+    {
+        pos.heading = (float)theta;
+        start = time_usec();
+        for ( rep = 0; rep < TEST_BENCH_REPS; rep++ )
+        {
+            pos.latitude = 0.2 + (0.6 * rep) / TEST_BENCH_REPS;
+            pos.longitude = 0.8 - (0.6 * rep) / TEST_BENCH_REPS;
+            get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+        }
+        frame_time = (time_usec() - start) / TEST_BENCH_REPS;
+
+        if ( frame_time < min_time )
+            min_time = frame_time;
+        if ( frame_time > max_time )
+            max_time = frame_time;
+
+        printf("  Heading %3d  %8.1f [usec/frame]\n", theta, frame_time);
+    }
+
+    printf("  Slowest to fastest heading %.2f\n", max_time / min_time);
+
+    map_north_up(1);
+    start = time_usec();
+    for ( rep = 0; rep < TEST_BENCH_REPS; rep++ )
+    {
+        pos.latitude = 0.2 + (0.6 * rep) / TEST_BENCH_REPS;
+        pos.longitude = 0.8 - (0.6 * rep) / TEST_BENCH_REPS;
+        get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+    }
+    frame_time = (time_usec() - start) / TEST_BENCH_REPS;
+    map_north_up(0);
+
+    printf("  North-up     %8.1f [usec/frame]\n", frame_time);
+
+    free(image_buffer);
+
+    printf("Done\n");
+
+    return 0;
+}
+
+/********************************************************************
+ * test_t5_map_scroll()
+ *
+ *  Move the map patch over a synthetic map image at a constant heading,
+ *  compare incremental (scroll) rendering to full rendering of the patch,
+ *  and print the time per frame of both. The incremental patch origin is
+ *  snapped to whole screen pixels, so the comparison allows a difference
+ *  of one source pixel in each direction.
+ *  The map layer is scrolled only when the patch size matches the LCD,
+ *  so the test initializes the LCD and displays the scrolling map.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or mismatch
+ *
+ */
+int test_t5_map_scroll(void)
+{
+    static const float heading[TEST_SCROLL_HEADINGS] = {0.0, 90.0, 30.5, 217.3, 333.3};
+
+    uint16_t       *image_buffer, *row_buffer;
+    struct map_t    map_attrib;
+    struct position_t   pos;
+    int     u, v, h, step;
+    int     mismatch = 0;
+    double  start, scroll_time, full_time;
+
+    printf("Test t5\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    // Build the synthetic map, see test_t3_map_patch()
+    image_buffer = malloc(sizeof(uint16_t) * map_image_pixels(TEST_MAP_WIDTH, TEST_MAP_HEIGHT));
+    row_buffer = malloc(sizeof(uint16_t) * TEST_MAP_WIDTH);
+    if ( image_buffer == NULL || row_buffer == NULL )
+    {
+        printf("  Error allocating map image\n");
+        free(image_buffer);
+        free(row_buffer);
+        return -1;
+    }
+
+    for ( v = 0; v < TEST_MAP_HEIGHT; v++ )
+    {
+        for ( u = 0; u < TEST_MAP_WIDTH; u++ )
+            row_buffer[u] = (uint16_t)((v << 8) + u + 1);
+        map_image_store_row(image_buffer, TEST_MAP_WIDTH, v, row_buffer);
+    }
+
+    memset(&map_attrib, 0, sizeof(struct map_t));
+    strncpy(map_attrib.file_name, "synthetic", MAX_FILE_NAME_LEN);
+    map_attrib.width = TEST_MAP_WIDTH;
+    map_attrib.height = TEST_MAP_HEIGHT;
+    map_attrib.tl_lat = 1.0;
+    map_attrib.tl_long = 0.0;
+    map_attrib.br_lat = 0.0;
+    map_attrib.br_long = 1.0;
+
+    memset(&pos, 0, sizeof(struct position_t));
+
+    for ( h = 0; h < TEST_SCROLL_HEADINGS; h++ )
+    {
+        pos.heading = heading[h];
+
+        // Compare incremental to full rendering while moving
+        // the patch center two pixels right and one pixel down per step
+        for ( step = 0; step < TEST_SCROLL_STEPS; step++ )
+        {
+            pos.longitude = (60 + (2 * step) + 0.5) / TEST_MAP_WIDTH;
+            pos.latitude = 1.0 - (70 + step + 0.5) / TEST_MAP_HEIGHT;
+
+            map_patch_kernel(MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR);
+            get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+            map_patch_kernel((MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR) | MAP_KERNEL_NO_SCROLL);
+            get_map_patch(&pos, &map_attrib, image_buffer, ref_frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+
+            if ( cmp_map_patch(frame_buffer, ref_frame_buffer, TEST_ROI_WIDTH * TEST_ROI_HEIGHT) )
+            {
+                printf("  Scroll mismatch at heading %.1f step %d\n", pos.heading, step);
+                mismatch++;
+            }
+
+            lcdFrameBufferPush(frame_buffer);
+        }
+
+        // Time incremental and full rendering over the same moves
+        map_patch_kernel(MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR);
+        start = time_usec();
+        for ( step = 0; step < TEST_SCROLL_STEPS; step++ )
+        {
+            pos.longitude = (60 + (2 * step) + 0.5) / TEST_MAP_WIDTH;
+            pos.latitude = 1.0 - (70 + step + 0.5) / TEST_MAP_HEIGHT;
+            get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+        }
+        scroll_time = (time_usec() - start) / TEST_SCROLL_STEPS;
+
+        map_patch_kernel((MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR) | MAP_KERNEL_NO_SCROLL);
+        start = time_usec();
+        for ( step = 0; step < TEST_SCROLL_STEPS; step++ )
+        {
+            pos.longitude = (60 + (2 * step) + 0.5) / TEST_MAP_WIDTH;
+            pos.latitude = 1.0 - (70 + step + 0.5) / TEST_MAP_HEIGHT;
+            get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+        }
+        full_time = (time_usec() - start) / TEST_SCROLL_STEPS;
+
+        printf("  Heading %5.1f  scroll %8.1f  full %8.1f [usec/frame]\n", pos.heading, scroll_time, full_time);
+    }
+
+    map_patch_kernel(MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR);
+
+    printf("  %d mismatches\n", mismatch);
+
+    free(row_buffer);
+    free(image_buffer);
+
+    lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+    lcdFrameBufferPush(frame_buffer);
+
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return mismatch ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t6_dirty_push()
+ *
+ *  Compare random pixel and character draws into the frame buffer
+ *  with a reference raster that reads the font.
+ *  Draw the GPS data screen with a changing position, the same way
+ *  gps_data() in nav.c does, and print the pixel data bytes sent to
+ *  the LCD per update. Only changed pixels should be sent.
+ *  Also print the time to draw one update into the frame buffer.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error, a raster mismatch or a push sent more than expected
+ *
+ */
+int test_t6_dirty_push(void)
+{
+    char    heart_beat = '*';
+    int     i, sent, max_sent, x, y, scale, transparent;
+    int     mismatch = 0;
+    int     errors = 0;
+    char    c;
+    uint16_t    color, bg_color;
+    double  start, draw_time;
+
+    printf("Test t6\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    // Pixels and characters drawn into the frame buffer match the
+    // reference raster, including draws that fall off the screen
+    srand(1);
+    for ( i = 0; i < (FRAME_BUFF_SIZE); i++ )
+        frame_buffer[i] = (uint16_t) rand();
+    memcpy(ref_frame_buffer, frame_buffer, sizeof(frame_buffer));
+
+    for ( i = 0; i < TEST_RASTER_DRAWS; i++ )
+    {
+        x = (rand() % (lcdWidth() + 20)) - 10;
+        y = (rand() % (lcdHeight() + 20)) - 10;
+        color = (uint16_t) rand();
+
+        if ( i & 1 )
+        {
+            lcdDrawPixel(frame_buffer, x, y, color);
+            ref_fill_rect(ref_frame_buffer, x, y, 1, 1, color);
+        }
+        else
+        {
+            c = (char) (rand() % 256);
+            bg_color = (uint16_t) rand();
+            scale = 1 + (rand() % 3);
+            transparent = rand() % 2;
+            lcdDrawChar(frame_buffer, x, y, c, color, bg_color, scale, transparent);
+            ref_draw_char(ref_frame_buffer, x, y, c, color, bg_color, scale, transparent);
+        }
+
+        if ( memcmp(frame_buffer, ref_frame_buffer, sizeof(frame_buffer)) )
+        {
+            printf("  %s draw %d mismatch at (%d,%d)\n", (i & 1) ? "Pixel" : "Character", i, x, y);
+            memcpy(ref_frame_buffer, frame_buffer, sizeof(frame_buffer));
+            mismatch++;
+        }
+    }
+
+    printf("  Raster draws      %6d, %d mismatched\n", TEST_RASTER_DRAWS, mismatch);
+    if ( mismatch )
+        errors++;
+
+    vt100_lcd_init(LCD_ROTATION, 1, ST7735_BLACK, ST7735_WHITE);
+
+    // Full screen draw sends the whole frame
+    lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+    vt100_lcd_printf(frame_buffer, 0, "\e[0;0f GPS data");
+    sent = lcdFrameBufferPush(frame_buffer);
+    printf("  Full screen       %6d [bytes]\n", sent);
+    if ( sent != ((FRAME_BUFF_SIZE * LCD_COLOR_BITS) / 8) )
+        errors++;
+
+    // Nothing changed, nothing to send
+    sent = lcdFrameBufferPush(frame_buffer);
+    printf("  No change         %6d [bytes]\n", sent);
+    if ( sent != 0 )
+        errors++;
+
+    // Heart beat character only
+    vt100_lcd_printf(frame_buffer, 0, "\e[2;1f%c", heart_beat);
+    sent = lcdFrameBufferPush(frame_buffer);
+    printf("  Heart beat        %6d [bytes]\n", sent);
+    if ( sent > (2 * FONT_PIX_WIDE * FONT_PIX_HIGH) )
+        errors++;
+
+    // GPS data lines erased and reprinted with a slowly changing position
+    max_sent = 0;
+    for ( i = 0; i < TEST_PUSH_UPDATES; i++ )
+    {
+        gps_screen_update(frame_buffer, i);
+        sent = lcdFrameBufferPush(frame_buffer);
+
+        // The first update draws all text lines
+        if ( i == 0 )
+            printf("  GPS data first    %6d [bytes]\n", sent);
+        else if ( sent > max_sent )
+            max_sent = sent;
+    }
+
+    printf("  GPS data update   %6d [bytes] max\n", max_sent);
+    if ( max_sent > TEST_PUSH_MAX_BYTES )
+        errors++;
+
+    // Text drawing time into the frame buffer, without the push
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        gps_screen_update(frame_buffer, i);
+    draw_time = (time_usec() - start) / TEST_BENCH_REPS;
+    printf("  GPS data draw   %8.1f [uSec] per update\n", draw_time);
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t7_display_swap()
+ *
+ *  Draw a scrolling screen with GPS data text, first with synchronous
+ *  pushes and then through the display thread, and print the frame times.
+ *  With the display thread the SPI transfer of a frame overlaps drawing
+ *  of the next one. After each swap the new back buffer must hold the
+ *  frame that was just handed to the display thread, and both runs must
+ *  send the same number of bytes.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or buffer mismatch
+ *
+ */
+int test_t7_display_swap(void)
+{
+    int         i, sync_sent, async_sent;
+    int         mismatch = 0;
+    double      start, sync_time, async_time;
+    uint16_t   *back, *front;
+
+    printf("Test t7\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    vt100_lcd_init(LCD_ROTATION, 1, ST7735_BLACK, ST7735_WHITE);
+
+    // Synchronous push of every frame
+    lcdFrameBufferColor(frame_buffer, ST7735_BLUE);
+    lcdFrameBufferPush(frame_buffer);
+
+    sync_sent = 0;
+    start = time_usec();
+    for ( i = 0; i < TEST_SWAP_FRAMES; i++ )
+    {
+        lcdFrameBufferScroll(frame_buffer, 0, 1, (i & 1) ? ST7735_BLUE : ST7735_CYAN);
+        vt100_lcd_invalidate();
+        gps_screen_update(frame_buffer, i);
+        sync_sent += lcdFrameBufferPush(frame_buffer);
+    }
+    sync_time = (time_usec() - start) / TEST_SWAP_FRAMES;
+
+    // Same frames through the display thread
+    back = lcdDisplayInit(ST7735_BLUE);
+    if ( back == NULL )
+    {
+        printf("  lcdDisplayInit failed\n");
+        return -1;
+    }
+    back = lcdDisplaySwap();
+    lcdDisplayFence();
+
+    async_sent = 0;
+    start = time_usec();
+    for ( i = 0; i < TEST_SWAP_FRAMES; i++ )
+    {
+        lcdFrameBufferScroll(back, 0, 1, (i & 1) ? ST7735_BLUE : ST7735_CYAN);
+        vt100_lcd_invalidate();
+        gps_screen_update(back, i);
+
+        // bytes of the previous frame, the swap waits for its push anyway
+        if ( i > 0 )
+            async_sent += lcdDisplayFence();
+
+        front = back;
+        back = lcdDisplaySwap();
+        if ( memcmp(back, front, 2 * FRAME_BUFF_SIZE) )
+            mismatch++;
+    }
+    async_sent += lcdDisplayFence();
+    async_time = (time_usec() - start) / TEST_SWAP_FRAMES;
+
+    lcdDisplayClose();
+
+    printf("  Synchronous push  %8.1f [uSec] per frame, %d [bytes]\n", sync_time, sync_sent);
+    printf("  Display thread    %8.1f [uSec] per frame, %d [bytes]\n", async_time, async_sent);
+    printf("  %d buffer mismatches\n", mismatch);
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return (mismatch || sync_sent != async_sent) ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t8_frame_timer()
+ *
+ *  Run the display frame timer at FRAME_RATE and at 1 fps, and measure
+ *  the frame period and its jitter, the way gps_data() and gps_map_nav()
+ *  in nav.c wait for frame ticks with poll().
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if the timer cannot be opened, frames were missed,
+ *            or the average frame period is off
+ *
+ */
+int test_t8_frame_timer(void)
+{
+    static const int rates[] = { FRAME_RATE, 1 };
+
+    int             timer_fd, frames, ticks, fps, i;
+    int             missed = 0;
+    int             errors = 0;
+    double          period, start, last, now, interval;
+    double          max_interval;
+    struct pollfd   poll_fd;
+
+    printf("Test t8\n");
+
+    // The navigator frame rate, and a one second period
+    // that is set with 'tv_sec' of the timer period
+    for ( i = 0; i < (int) (sizeof(rates) / sizeof(int)); i++ )
+    {
+        fps = rates[i];
+
+        timer_fd = frame_timer_open(fps);
+        if ( timer_fd == -1 )
+        {
+            printf("  frame_timer_open(%d) failed, error %d\n", fps, errno);
+            errors++;
+            continue;
+        }
+
+        poll_fd.fd = timer_fd;
+        poll_fd.events = POLLIN;
+
+        period = 1000000.0 / fps;
+        frames = 0;
+        missed = 0;
+        max_interval = 0.0;
+        start = time_usec();
+        last = start;
+
+        while ( frames < (TEST_TIMER_SECONDS * fps) )
+        {
+            if ( poll(&poll_fd, 1, -1) == -1 )
+                continue;
+
+            if ( (ticks = frame_timer_ack(timer_fd)) == 0 )
+                continue;
+
+            now = time_usec();
+            interval = now - last;
+            last = now;
+
+            // The first tick is measured from the timer start
+            if ( interval > max_interval && frames > 0 )
+                max_interval = interval;
+
+            missed += ticks - 1;
+            frames += ticks;
+        }
+
+        close(timer_fd);
+
+        interval = (last - start) / frames;
+
+        printf("  Frame rate        %6d [fps]\n", fps);
+        printf("  Frame period      %8.1f [uSec] average, %8.1f [uSec] max\n", interval, max_interval);
+        printf("  %d missed frames\n", missed);
+
+        if ( missed || fabs(interval - period) > (period * TEST_TIMER_SLACK) )
+            errors++;
+    }
+
+    printf("Done\n");
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t9_hw_scroll()
+ *
+ *  Move a pattern with a fixed text line on top along the LCD scroll
+ *  axis, the way the map moves when panning along it, and print the
+ *  pixel data bytes sent per move with and without hardware scroll.
+ *  With hardware scroll only the exposed lines and the text line should
+ *  be sent. The pattern must move smoothly on the LCD without tearing
+ *  or wrapped lines.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a push sent more than expected
+ *
+ */
+int test_t9_hw_scroll(void)
+{
+    static const int move[] = {1, 2, 4, 8, -3};
+
+    int     i, hw, d, dx, dy, origin, cross, sent, max_sent;
+    int     errors = 0;
+    double  total[2];
+
+    printf("Test t9\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    vt100_lcd_init(LCD_ROTATION, 1, ST7735_BLACK, ST7735_WHITE);
+
+    // Pixels across the scroll axis, the axis is the 160 pixel side
+    cross = (lcdWidth() == ST7735_TFTHEIGHT) ? lcdHeight() : lcdWidth();
+    max_sent = 2 * ((8 * cross) + (FONT_PIX_HIGH * ST7735_TFTHEIGHT));
+
+    for ( hw = 0; hw < 2; hw++ )
+    {
+        origin = 0;
+        scroll_pattern(frame_buffer, 0, ST7735_TFTHEIGHT, origin);
+        lcdFrameBufferPush(frame_buffer);
+
+        total[hw] = 0.0;
+        for ( i = 0; i < TEST_HWSCROLL_STEPS; i++ )
+        {
+            // Move the frame, draw the exposed lines and the text on top
+            d = move[i % (sizeof(move) / sizeof(int))];
+            origin += d;
+            dx = (lcdWidth() == ST7735_TFTHEIGHT) ? -d : 0;
+            dy = (lcdWidth() == ST7735_TFTHEIGHT) ? 0 : -d;
+
+            lcdFrameBufferScroll(frame_buffer, dx, dy, ST7735_BLACK);
+            if ( d > 0 )
+                scroll_pattern(frame_buffer, ST7735_TFTHEIGHT - d, d, origin);
+            else
+                scroll_pattern(frame_buffer, 0, -d, origin);
+            vt100_lcd_invalidate();
+            vt100_lcd_printf(frame_buffer, 0, "\e[0;0fHW scroll %s %3d", hw ? "on " : "off", i);
+
+            if ( hw && !lcdHardwareScroll(dx, dy) )
+                errors++;
+
+            sent = lcdFrameBufferPush(frame_buffer);
+            total[hw] += sent;
+            if ( hw && sent > max_sent )
+                errors++;
+        }
+    }
+
+    printf("  Software push     %8.1f [bytes] per move\n", total[0] / TEST_HWSCROLL_STEPS);
+    printf("  Hardware scroll   %8.1f [bytes] per move\n", total[1] / TEST_HWSCROLL_STEPS);
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t10_draw_primitives()
+ *
+ *  Draw random, partly off screen, lines, rectangles and blits into
+ *  the frame buffer and compare them to the same shapes drawn pixel
+ *  by pixel. Print the time to fill the screen and to draw a menu
+ *  highlight bar, with the fill primitive and pixel by pixel.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a shape mismatch
+ *
+ */
+int test_t10_draw_primitives(void)
+{
+    int         i, shape, x, y, w, h, px, py;
+    int         width, height;
+    int         mismatch = 0;
+    uint16_t    color;
+    double      start, fill_time, pixel_time;
+
+    printf("Test t10\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    width = lcdWidth();
+    height = lcdHeight();
+    srand(1);
+
+    for ( i = 0; i < TEST_DRAW_SHAPES; i++ )
+    {
+        shape = rand() % 5;
+        x = (rand() % (width + 40)) - 20;
+        y = (rand() % (height + 40)) - 20;
+        w = rand() % (width / 2);
+        h = rand() % (height / 2);
+        color = (uint16_t) rand();
+
+        memcpy(ref_frame_buffer, frame_buffer, sizeof(frame_buffer));
+
+        switch ( shape )
+        {
+            case 0:
+                lcdDrawHLine(frame_buffer, x, y, w, color);
+                ref_fill_rect(ref_frame_buffer, x, y, w, 1, color);
+                break;
+
+            case 1:
+                lcdDrawVLine(frame_buffer, x, y, h, color);
+                ref_fill_rect(ref_frame_buffer, x, y, 1, h, color);
+                break;
+
+            case 2:
+                lcdFillRect(frame_buffer, x, y, w, h, color);
+                ref_fill_rect(ref_frame_buffer, x, y, w, h, color);
+                break;
+
+            case 3:
+                lcdDrawRect(frame_buffer, x, y, w, h, color);
+                if ( w > 0 && h > 0 )
+                {
+                    ref_fill_rect(ref_frame_buffer, x, y, w, 1, color);
+                    ref_fill_rect(ref_frame_buffer, x, y + h - 1, w, 1, color);
+                    ref_fill_rect(ref_frame_buffer, x, y, 1, h, color);
+                    ref_fill_rect(ref_frame_buffer, x + w - 1, y, 1, h, color);
+                }
+                break;
+
+            // Blit a screen size pattern buffer at an offset
+            case 4:
+                for ( py = 0; py < height; py++ )
+                    for ( px = 0; px < width; px++ )
+                        test_pattern[(py * width) + px] = (uint16_t) ((px * 31) ^ (py << 6) ^ color);
+                lcdFrameBufferBlit(frame_buffer, x, y, &test_pattern[(h * width) + w],
+                                   width - w, height - h, width);
+                for ( py = 0; py < (height - h); py++ )
+                    for ( px = 0; px < (width - w); px++ )
+                        if ( (x + px) >= 0 && (x + px) < width && (y + py) >= 0 && (y + py) < height )
+                            ref_frame_buffer[((y + py) * width) + x + px] = test_pattern[((h + py) * width) + w + px];
+                break;
+        }
+
+        if ( memcmp(frame_buffer, ref_frame_buffer, sizeof(frame_buffer)) )
+        {
+            printf("  Shape %d mismatch at (%d,%d) size %dx%d\n", shape, x, y, w, h);
+            mismatch++;
+        }
+    }
+
+    lcdFrameBufferPush(frame_buffer);
+
+    // Full screen and menu bar fill times
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        lcdFillRect(frame_buffer, 0, 0, width, height, (uint16_t) i);
+    fill_time = (time_usec() - start) / TEST_BENCH_REPS;
+
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        for ( y = 0; y < height; y++ )
+            for ( x = 0; x < width; x++ )
+                lcdDrawPixel(frame_buffer, x, y, (uint16_t) i);
+    pixel_time = (time_usec() - start) / TEST_BENCH_REPS;
+    printf("  Screen fill   %8.1f [uSec], pixel by pixel %8.1f [uSec]\n", fill_time, pixel_time);
+
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        lcdFillRect(frame_buffer, 5, 40, width - 10, FONT_PIX_HIGH, (uint16_t) i);
+    fill_time = (time_usec() - start) / TEST_BENCH_REPS;
+
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        for ( y = 40; y < (40 + FONT_PIX_HIGH); y++ )
+            for ( x = 5; x < (width - 5); x++ )
+                lcdDrawPixel(frame_buffer, x, y, (uint16_t) i);
+    pixel_time = (time_usec() - start) / TEST_BENCH_REPS;
+    printf("  Menu bar fill %8.1f [uSec], pixel by pixel %8.1f [uSec]\n", fill_time, pixel_time);
+
+    lcdFrameBufferPush(frame_buffer);
+
+    printf("  %d mismatches\n", mismatch);
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return mismatch ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t11_map_track()
+ *
+ *  Draw track points over map patches rendered from a synthetic map image
+ *  at several headings, and check that each point lands on the map pixel
+ *  it was projected from. Draw random polylines at two line widths and
+ *  check that no pixel is drawn away from the line and that the line has
+ *  no gaps. Print the time to draw a breadcrumb trail over the map.
+ *  Each synthetic map pixel encodes its own coordinate, so the projection
+ *  check allows a difference of one source pixel in each direction.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or mismatch
+ *
+ */
+int test_t11_map_track(void)
+{
+    static const float heading[TEST_SCROLL_HEADINGS] = {0.0, 90.0, 30.5, 217.3, 333.3};
+    static const int line_width[2] = {1, 3};
+
+    uint16_t       *image_buffer, *row_buffer;
+    struct map_t    map_attrib;
+    struct position_t   pos;
+    struct geo_point_t  point, *trail;
+    struct lcd_point_t  line[TEST_TRACK_SEGMENTS + 1];
+    int     u, v, h, i, w, x, y, found, value;
+    int     width, height;
+    int     mismatch = 0;
+    double  nearest, dist, start, trail_time;
+
+    printf("Test t11\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    width = lcdWidth();
+    height = lcdHeight();
+
+    // Build the synthetic map, see test_t3_map_patch()
+    image_buffer = malloc(sizeof(uint16_t) * map_image_pixels(TEST_MAP_WIDTH, TEST_MAP_HEIGHT));
+    row_buffer = malloc(sizeof(uint16_t) * TEST_MAP_WIDTH);
+    trail = malloc(sizeof(struct geo_point_t) * TEST_TRACK_POINTS);
+    if ( image_buffer == NULL || row_buffer == NULL || trail == NULL )
+    {
+        printf("  Error allocating map image\n");
+        free(image_buffer);
+        free(row_buffer);
+        free(trail);
+        return -1;
+    }
+
+    for ( v = 0; v < TEST_MAP_HEIGHT; v++ )
+    {
+        for ( u = 0; u < TEST_MAP_WIDTH; u++ )
+            row_buffer[u] = (uint16_t)((v << 8) + u + 1);
+        map_image_store_row(image_buffer, TEST_MAP_WIDTH, v, row_buffer);
+    }
+
+    memset(&map_attrib, 0, sizeof(struct map_t));
+    strncpy(map_attrib.file_name, "synthetic", MAX_FILE_NAME_LEN);
+    map_attrib.width = TEST_MAP_WIDTH;
+    map_attrib.height = TEST_MAP_HEIGHT;
+    map_attrib.tl_lat = 1.0;
+    map_attrib.tl_long = 0.0;
+    map_attrib.br_lat = 0.0;
+    map_attrib.br_long = 1.0;
+
+    memset(&pos, 0, sizeof(struct position_t));
+    pos.longitude = 128.3 / TEST_MAP_WIDTH;
+    pos.latitude = 1.0 - 127.7 / TEST_MAP_HEIGHT;
+    srand(1);
+
+    // Draw map pixel centers near the patch center as dots, the fully
+    // covered dot pixels must show the same map pixel in the patch
+    for ( h = 0; h < TEST_SCROLL_HEADINGS; h++ )
+    {
+        pos.heading = heading[h];
+        get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, width, height);
+        memcpy(ref_frame_buffer, frame_buffer, sizeof(frame_buffer));
+
+        for ( i = 0; i < TEST_TRACK_DOTS; i++ )
+        {
+            u = 128 + (rand() % 81) - 40;
+            v = 127 + (rand() % 81) - 40;
+            point.longitude = (u + 0.5) / TEST_MAP_WIDTH;
+            point.latitude = 1.0 - (v + 0.5) / TEST_MAP_HEIGHT;
+
+            map_draw_track(&point, 1, frame_buffer, 2, 0);
+
+            found = 0;
+            for ( y = 0; y < height; y++ )
+            {
+                for ( x = 0; x < width; x++ )
+                {
+                    if ( frame_buffer[(y * width) + x] != 0 )
+                        continue;
+
+                    found++;
+                    value = ref_frame_buffer[(y * width) + x] - 1;
+                    if ( abs((value & 0xff) - u) > 1 || abs((value >> 8) - v) > 1 )
+                    {
+                        printf("  Track point (%d,%d) drawn over map pixel (%d,%d) at heading %.1f\n",
+                               u, v, value & 0xff, value >> 8, pos.heading);
+                        mismatch++;
+                    }
+                }
+            }
+
+            if ( !found )
+            {
+                printf("  Track point (%d,%d) not drawn at heading %.1f\n", u, v, pos.heading);
+                mismatch++;
+            }
+
+            memcpy(frame_buffer, ref_frame_buffer, sizeof(frame_buffer));
+        }
+
+        lcdFrameBufferPush(frame_buffer);
+    }
+
+    // Draw random, partly off screen, polylines on a black screen
+    for ( w = 0; w < 2; w++ )
+    {
+        for ( i = 0; i <= TEST_TRACK_SEGMENTS; i++ )
+        {
+            line[i].x = (rand() % ((width + 40) * LCD_SUBPIXEL)) - (20 * LCD_SUBPIXEL);
+            line[i].y = (rand() % ((height + 40) * LCD_SUBPIXEL)) - (20 * LCD_SUBPIXEL);
+        }
+
+        lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+        lcdDrawPolyline(frame_buffer, line, TEST_TRACK_SEGMENTS + 1, line_width[w], ST7735_WHITE);
+
+        // Span ends are evaluated at whole pixels along the segment,
+        // so a segment end may reach up to half a pixel further
+        found = 0;
+        for ( y = 0; y < height; y++ )
+        {
+            for ( x = 0; x < width; x++ )
+            {
+                nearest = 1e9;
+                for ( i = 0; i < TEST_TRACK_SEGMENTS; i++ )
+                {
+                    dist = ref_segment_distance(x, y, &line[i], &line[i + 1]);
+                    if ( dist < nearest )
+                        nearest = dist;
+                }
+
+                if ( frame_buffer[(y * width) + x] != ST7735_BLACK && nearest > (line_width[w] / 2.0) + 1.5 )
+                    found++;
+                else if ( frame_buffer[(y * width) + x] == ST7735_BLACK && nearest < 0.3 )
+                    found++;
+            }
+        }
+
+        if ( found )
+        {
+            printf("  %d pixels wrong in polyline of width %d\n", found, line_width[w]);
+            mismatch++;
+        }
+
+        lcdFrameBufferPush(frame_buffer);
+    }
+
+    // A breadcrumb trail with steps of about one map pixel, drawn over a rotated map
+    trail[0].longitude = pos.longitude;
+    trail[0].latitude = pos.latitude;
+    for ( i = 1; i < TEST_TRACK_POINTS; i++ )
+    {
+        trail[i].longitude = trail[i - 1].longitude + (((rand() % 201) - 100) / 100.0) / TEST_MAP_WIDTH;
+        trail[i].latitude = trail[i - 1].latitude + (((rand() % 201) - 100) / 100.0) / TEST_MAP_HEIGHT;
+    }
+
+    pos.heading = 30.5;
+    get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, width, height);
+
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        map_draw_track(trail, TEST_TRACK_POINTS, frame_buffer, 2, ST7735_MAGENTA);
+    trail_time = (time_usec() - start) / TEST_BENCH_REPS;
+    printf("  Trail of %d points %8.1f [uSec]\n", TEST_TRACK_POINTS, trail_time);
+
+    lcdFrameBufferPush(frame_buffer);
+
+    printf("  %d mismatches\n", mismatch);
+    printf("Done\n");
+
+    free(image_buffer);
+    free(row_buffer);
+    free(trail);
+    lcdBusClose();
+    hal_close();
+
+    return mismatch ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t12_color_bits()
+ *
+ *  Push full frames and a small odd size rectangle in the 16-bit RGB565
+ *  and the 12-bit RGB444 pixel transfer formats, check the pixel data
+ *  bytes sent, and print the time to push a full frame in each format.
+ *  The last frames stay on the LCD to compare the color depth.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or unexpected byte count
+ *
+ */
+int test_t12_color_bits(void)
+{
+    static const int color_bits[2] = {16, 12};
+
+    int     b, i, x, y, sent, expected;
+    int     width, height;
+    int     errors = 0;
+    double  start, push_time;
+
+    printf("Test t12\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    width = lcdWidth();
+    height = lcdHeight();
+
+    // Color gradients, red across and green down with a blue band pattern
+    for ( y = 0; y < height; y++ )
+        for ( x = 0; x < width; x++ )
+            test_pattern[(y * width) + x] = lcdColor565((x * 255) / (width - 1), (y * 255) / (height - 1), ((x + y) & 0x20) ? 0xff : 0x40);
+
+    for ( b = 0; b < 2; b++ )
+    {
+        lcdSetColorBits(color_bits[b]);
+
+        // Every frame is the pattern or its inverse, so all pixels change
+        start = time_usec();
+        for ( i = 0; i < TEST_COLOR_FRAMES; i++ )
+        {
+            for ( x = 0; x < FRAME_BUFF_SIZE; x++ )
+                frame_buffer[x] = (i & 1) ? test_pattern[x] : ~test_pattern[x];
+            lcdFrameBufferDirty(0, 0, width, height);
+            sent = lcdFrameBufferPush(frame_buffer);
+            expected = (FRAME_BUFF_SIZE * color_bits[b]) / 8;
+            if ( sent != expected )
+            {
+                printf("  %d-bit full frame sent %d bytes, expected %d\n", color_bits[b], sent, expected);
+                errors++;
+            }
+        }
+        push_time = (time_usec() - start) / TEST_COLOR_FRAMES;
+        printf("  %d-bit full frame %6d [bytes] %8.1f [uSec]\n", color_bits[b], sent, push_time);
+
+        // An odd pixel count ends with a single RGB444 pixel in two bytes
+        lcdFillRect(frame_buffer, 11, 13, 7, 5, ST7735_WHITE);
+        sent = lcdFrameBufferPush(frame_buffer);
+        expected = (color_bits[b] == 12) ? (((7 * 5 * 3) + 1) / 2) : (7 * 5 * 2);
+        printf("  %d-bit 7x5 rectangle %6d [bytes]\n", color_bits[b], sent);
+        if ( sent != expected )
+            errors++;
+    }
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    lcdSetColorBits(LCD_COLOR_BITS);
+    lcdBusClose();
+    hal_close();
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t13_text_cells()
+ *
+ *  Draw the GPS data screen through the VT100 text cells. Check that
+ *  rewriting unchanged text does not rasterize it, that invalidated text
+ *  is drawn again, and that incremental updates match the same text drawn
+ *  on a cleared screen. Print the time to rewrite the screen with unchanged
+ *  text and to draw it again in full.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a text mismatch
+ *
+ */
+int test_t13_text_cells(void)
+{
+    int         i, probe_offset;
+    int         errors = 0;
+    uint16_t    probe;
+    double      start, same_time, full_time;
+
+    printf("Test t13\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    vt100_lcd_init(LCD_ROTATION, 1, ST7735_BLACK, ST7735_WHITE);
+
+    lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+    gps_screen_update(frame_buffer, 0);
+    lcdFrameBufferPush(frame_buffer);
+
+    // A pixel changed behind the back of the text cells stays
+    // changed when the same text is written again
+    probe_offset = ((TEST_PROBE_ROW * FONT_PIX_HIGH + 3) * lcdWidth()) + (TEST_PROBE_COL * FONT_PIX_WIDE) + 2;
+    probe = frame_buffer[probe_offset];
+    frame_buffer[probe_offset] = ~probe;
+    gps_screen_update(frame_buffer, 0);
+    if ( frame_buffer[probe_offset] != (uint16_t) ~probe )
+    {
+        printf("  Unchanged text was drawn again\n");
+        errors++;
+    }
+
+    // and is restored after the text cells are invalidated
+    vt100_lcd_invalidate();
+    gps_screen_update(frame_buffer, 0);
+    if ( frame_buffer[probe_offset] != probe )
+    {
+        printf("  Invalidated text was not drawn again\n");
+        errors++;
+    }
+
+    // Incremental updates match the text drawn on a cleared screen
+    for ( i = 1; i < TEST_PUSH_UPDATES; i++ )
+    {
+        gps_screen_update(frame_buffer, i);
+        lcdFrameBufferPush(frame_buffer);
+
+        lcdFrameBufferColor(ref_frame_buffer, ST7735_BLACK);
+        vt100_lcd_invalidate();
+        gps_screen_update(ref_frame_buffer, i);
+        if ( memcmp(frame_buffer, ref_frame_buffer, sizeof(frame_buffer)) )
+        {
+            printf("  Text mismatch at update %d\n", i);
+            errors++;
+        }
+    }
+
+    // Rewrite time with unchanged text and with all text drawn again
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        gps_screen_update(frame_buffer, TEST_PUSH_UPDATES);
+    same_time = (time_usec() - start) / TEST_BENCH_REPS;
+
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+    {
+        vt100_lcd_invalidate();
+        gps_screen_update(frame_buffer, TEST_PUSH_UPDATES);
+    }
+    full_time = (time_usec() - start) / TEST_BENCH_REPS;
+    printf("  Unchanged text %8.1f [uSec], drawn in full %8.1f [uSec]\n", same_time, full_time);
+
+    lcdFrameBufferPush(frame_buffer);
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t14_text_fields()
+ *
+ *  Check numeric fields against the same numbers formatted with
+ *  snprintf() and printed through the VT100 driver, for random values,
+ *  widths, decimals and alignments. Check that a GPS data update through
+ *  fields only sends the characters that changed, and print the time of
+ *  a GPS data update through fields and through VT100 printf() lines.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a field mismatch
+ *
+ */
+int test_t14_text_fields(void)
+{
+    static const double float_values[] = {42.272169, -71.214177, 10.25, 3.1, 120.0, 0.0, -0.04, 359.94, 1e12};
+
+    int         i, field, width, decimals, flags;
+    int         sent, max_sent;
+    int         errors = 0;
+    long        value;
+    char        ref_text[64];
+    const char *ref_format;
+    double      start, field_time, printf_time;
+
+    printf("Test t14\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    vt100_lcd_init(LCD_ROTATION, 1, ST7735_BLACK, ST7735_WHITE);
+
+    // Fixed point fields match printf() formatting, including values that do not fit
+    srand(14);
+    for ( i = 0; i < TEST_FIELD_VALUES; i++ )
+    {
+        width = 1 + (rand() % VT100_FIELD_WIDTH);
+        decimals = rand() % 7;
+        flags = (i % 3 == 0) ? 0 : ((i % 3 == 1) ? VT100_FIELD_LEFT : VT100_FIELD_ZERO);
+        value = (long) (rand() >> (rand() % 31));
+        if ( rand() & 1 )
+            value = -value;
+
+        ref_format = (flags & VT100_FIELD_LEFT) ? "%-*.*f" : ((flags & VT100_FIELD_ZERO) ? "%0*.*f" : "%*.*f");
+        snprintf(ref_text, sizeof(ref_text), ref_format, width, decimals, value / pow(10.0, decimals));
+        if ( (int) strlen(ref_text) > width )
+        {
+            memset(ref_text, '*', width);
+            ref_text[width] = 0;
+        }
+
+        vt100_lcd_field_reset();
+        field = vt100_lcd_field(TEST_FIELD_ROW, 0, width, decimals, flags, ST7735_WHITE, ST7735_BLACK);
+
+        lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+        vt100_lcd_invalidate();
+        vt100_lcd_field_int(frame_buffer, field, value);
+
+        lcdFrameBufferColor(ref_frame_buffer, ST7735_BLACK);
+        vt100_lcd_invalidate();
+        vt100_lcd_printf(ref_frame_buffer, 0, "\e[%d;0f%s", TEST_FIELD_ROW, ref_text);
+
+        if ( memcmp(frame_buffer, ref_frame_buffer, sizeof(frame_buffer)) )
+        {
+            printf("  Field mismatch for %ld width %d decimals %d flags %d, expected '%s'\n", value, width, decimals, flags, ref_text);
+            errors++;
+        }
+    }
+
+    // Floating point values are rounded to the field decimals
+    for ( i = 0; i < (int) (sizeof(float_values) / sizeof(double)); i++ )
+    {
+        vt100_lcd_field_reset();
+        field = vt100_lcd_field(TEST_FIELD_ROW, 0, 11, 3, 0, ST7735_WHITE, ST7735_BLACK);
+
+        snprintf(ref_text, sizeof(ref_text), "%11.3f", float_values[i]);
+        if ( strlen(ref_text) > 11 )
+            strcpy(ref_text, "***********");
+
+        lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+        vt100_lcd_invalidate();
+        vt100_lcd_field_float(frame_buffer, field, float_values[i]);
+
+        lcdFrameBufferColor(ref_frame_buffer, ST7735_BLACK);
+        vt100_lcd_invalidate();
+        vt100_lcd_printf(ref_frame_buffer, 0, "\e[%d;0f%s", TEST_FIELD_ROW, ref_text);
+
+        if ( memcmp(frame_buffer, ref_frame_buffer, sizeof(frame_buffer)) )
+        {
+            printf("  Field mismatch for %f, expected '%s'\n", float_values[i], ref_text);
+            errors++;
+        }
+    }
+
+    // A GPS data update through fields only draws the changed characters
+    lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+    vt100_lcd_invalidate();
+    gps_field_screen(frame_buffer);
+    gps_field_update(frame_buffer, 0);
+    lcdFrameBufferPush(frame_buffer);
+
+    max_sent = 0;
+    for ( i = 1; i < TEST_PUSH_UPDATES; i++ )
+    {
+        gps_field_update(frame_buffer, i);
+        sent = lcdFrameBufferPush(frame_buffer);
+        if ( sent > max_sent )
+            max_sent = sent;
+    }
+
+    printf("  GPS field update  %6d [bytes] max\n", max_sent);
+    if ( max_sent > TEST_PUSH_MAX_BYTES )
+        errors++;
+
+    // Update time through fields and through printf() lines
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        gps_field_update(frame_buffer, i);
+    field_time = (time_usec() - start) / TEST_BENCH_REPS;
+
+    lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+    vt100_lcd_invalidate();
+    gps_screen_update(frame_buffer, 0);
+
+    start = time_usec();
+    for ( i = 0; i < TEST_BENCH_REPS; i++ )
+        gps_screen_update(frame_buffer, i);
+    printf_time = (time_usec() - start) / TEST_BENCH_REPS;
+    printf("  GPS data update fields %8.1f [uSec], printf %8.1f [uSec]\n", field_time, printf_time);
+
+    lcdFrameBufferPush(frame_buffer);
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t15_map_hud()
+ *
+ *  Move a map patch under the map HUD layer while the HUD heart beat
+ *  toggles, and compare with a full patch render that has the HUD text
+ *  drawn transparent over it. The HUD has black text, which must stay
+ *  opaque. Check that a track is drawn under the HUD, that the HUD
+ *  looks the same as transparent text drawn over the map, and print the
+ *  time to redraw a patch that did not move with the HUD and with the
+ *  text drawn on every frame.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a frame mismatch
+ *
+ */
+int test_t15_map_hud(void)
+{
+    static const float heading[TEST_HUD_HEADINGS] = {0.0, 30.5, 270.0};
+
+    uint16_t       *image_buffer, *row_buffer, *hud;
+    struct map_t    map_attrib;
+    struct position_t   pos;
+    struct geo_point_t  track[2];
+    char    heart_beat = '*';
+    int     u, v, h, i, step;
+    int     errors = 0;
+    double  start, hud_time, text_time;
+
+    printf("Test t15\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    vt100_lcd_init(LCD_ROTATION, 1, ST7735_BLACK, ST7735_WHITE);
+
+    // Build the synthetic map, see test_t3_map_patch()
+    image_buffer = malloc(sizeof(uint16_t) * map_image_pixels(TEST_MAP_WIDTH, TEST_MAP_HEIGHT));
+    row_buffer = malloc(sizeof(uint16_t) * TEST_MAP_WIDTH);
+    if ( image_buffer == NULL || row_buffer == NULL )
+    {
+        printf("  Error allocating map image\n");
+        free(image_buffer);
+        free(row_buffer);
+        return -1;
+    }
+
+    for ( v = 0; v < TEST_MAP_HEIGHT; v++ )
+    {
+        for ( u = 0; u < TEST_MAP_WIDTH; u++ )
+            row_buffer[u] = (uint16_t)((v << 8) + u + 1);
+        map_image_store_row(image_buffer, TEST_MAP_WIDTH, v, row_buffer);
+    }
+
+    memset(&map_attrib, 0, sizeof(struct map_t));
+    strncpy(map_attrib.file_name, "synthetic", MAX_FILE_NAME_LEN);
+    map_attrib.width = TEST_MAP_WIDTH;
+    map_attrib.height = TEST_MAP_HEIGHT;
+    map_attrib.tl_lat = 1.0;
+    map_attrib.tl_long = 0.0;
+    map_attrib.br_lat = 0.0;
+    map_attrib.br_long = 1.0;
+
+    memset(&pos, 0, sizeof(struct position_t));
+
+    // HUD of the map screen in nav.c
+    hud = map_hud_clear();
+
+    map_patch_kernel(MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR);
+
+    for ( h = 0; h < TEST_HUD_HEADINGS; h++ )
+    {
+        pos.heading = heading[h];
+
+        for ( step = 0; step < TEST_HUD_STEPS; step++ )
+        {
+            pos.longitude = (60 + (2 * step) + 0.5) / TEST_MAP_WIDTH;
+            pos.latitude = 1.0 - (70 + step + 0.5) / TEST_MAP_HEIGHT;
+
+            heart_beat = (heart_beat == '*') ? ' ' : '*';
+            hud_text(hud, 0, heart_beat);
+            map_hud_update();
+
+            get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+
+            map_patch_kernel((MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR) | MAP_KERNEL_NO_SCROLL);
+            get_map_patch(&pos, &map_attrib, image_buffer, ref_frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+            map_patch_kernel(MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR);
+
+            hud_text(ref_frame_buffer, 1, heart_beat);
+
+            if ( cmp_map_patch(frame_buffer, ref_frame_buffer, TEST_ROI_WIDTH * TEST_ROI_HEIGHT) )
+            {
+                printf("  HUD mismatch at heading %.1f step %d\n", pos.heading, step);
+                errors++;
+            }
+
+            // A track across the cursor stays under the HUD
+            track[0].latitude = pos.latitude + 0.3;
+            track[0].longitude = pos.longitude - 0.3;
+            track[1].latitude = pos.latitude - 0.3;
+            track[1].longitude = pos.longitude + 0.3;
+            map_draw_track(track, 2, frame_buffer, 3, ST7735_MAGENTA);
+
+            // The HUD text drawn again over the frame changes nothing
+            memcpy(ref_frame_buffer, frame_buffer, sizeof(uint16_t) * TEST_ROI_WIDTH * TEST_ROI_HEIGHT);
+            hud_text(ref_frame_buffer, 1, heart_beat);
+
+            for ( i = 0; i < TEST_ROI_WIDTH * TEST_ROI_HEIGHT; i++ )
+            {
+                if ( frame_buffer[i] != ref_frame_buffer[i] )
+                {
+                    printf("  Track over the HUD at heading %.1f step %d\n", pos.heading, step);
+                    errors++;
+                    break;
+                }
+            }
+
+            lcdFrameBufferPush(frame_buffer);
+        }
+    }
+
+    // The HUD looks the same as the text drawn transparent over the map
+    get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+    map_hud_clear();
+    map_patch_kernel((MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR) | MAP_KERNEL_NO_SCROLL);
+    get_map_patch(&pos, &map_attrib, image_buffer, ref_frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+    map_patch_kernel(MAP_SIMD ? MAP_KERNEL_SIMD : MAP_KERNEL_SCALAR);
+
+    hud_text(ref_frame_buffer, 1, heart_beat);
+
+    if ( cmp_map_patch(frame_buffer, ref_frame_buffer, TEST_ROI_WIDTH * TEST_ROI_HEIGHT) )
+    {
+        printf("  HUD differs from transparent text\n");
+        errors++;
+    }
+
+    // Frame time with the HUD, and with the text drawn over every frame
+    hud = map_hud_clear();
+    vt100_lcd_invalidate();
+    vt100_lcd_printf(hud, 0, "\e[15;0f\e[34;40mPress 'LEFT' to exit.\e[37;40m");
+    vt100_lcd_printf(hud, 0, "\e[0;22f\e[34;40mN-up\e[37;40m");
+    vt100_lcd_printf(hud, 0, "\e[0;0f\e[34;40m*\e[37;40m");
+    lcdDrawChar(hud, 78, 60, 0, ST7735_BLUE, ST7735_BLACK, 1, 0);
+    map_hud_update();
+
+    get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+    start = time_usec();
+    for ( step = 0; step < TEST_BENCH_REPS; step++ )
+        get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+    hud_time = (time_usec() - start) / TEST_BENCH_REPS;
+
+    map_hud_clear();
+    start = time_usec();
+    for ( step = 0; step < TEST_BENCH_REPS; step++ )
+    {
+        get_map_patch(&pos, &map_attrib, image_buffer, frame_buffer, TEST_ROI_WIDTH, TEST_ROI_HEIGHT);
+
+        lcdDrawChar(frame_buffer, 78, 60, 0, ST7735_BLUE, ST7735_BLACK, 1, 1);
+        vt100_lcd_invalidate();
+        vt100_lcd_printf(frame_buffer, 1, "\e[15;0f\e[34;40mPress 'LEFT' to exit.\e[37;40m");
+        vt100_lcd_printf(frame_buffer, 1, "\e[0;22f\e[34;40mN-up\e[37;40m");
+        vt100_lcd_printf(frame_buffer, 1, "\e[0;0f\e[34;40m*\e[37;40m");
+    }
+    text_time = (time_usec() - start) / TEST_BENCH_REPS;
+
+    printf("  Map patch redrawn with HUD %8.1f  text %8.1f [usec/frame]\n", hud_time, text_time);
+
+    free(row_buffer);
+    free(image_buffer);
+
+    lcdFrameBufferColor(frame_buffer, ST7735_BLACK);
+    lcdFrameBufferPush(frame_buffer);
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t16_uart_reader()
+ *
+ *  Feed NMEA text through a pipe to the UART line reader in pieces
+ *  that split lines, and check the lines it returns. Check that a line
+ *  longer than the reader buffer is returned in parts, and that waiting
+ *  for text times out without using the CPU.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a line mismatch
+ *
+ */
+int test_t16_uart_reader(void)
+{
+    static const char *sentences[] =
+    {
+        "$GPGGA,123519,4216.3301,N,07112.8507,W,1,08,0.9,545.4,M,46.9,M,,*4B",
+        "$GPRMC,123519,A,4216.3301,N,07112.8507,W,000.5,054.7,191194,020.3,E*6D",
+        "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39",
+    };
+
+    struct uart_reader_t    uart;
+    struct timespec         cpu_start, cpu_end;
+    char   *line;
+    char    long_line[2 * UART_READ_BUFF];
+    int     pipe_fd[2];
+    int     i, n, pos, len, piece, total;
+    int     errors = 0;
+    double  start, wall_time, cpu_time;
+
+    printf("Test t16\n");
+
+    if ( pipe(pipe_fd) == -1 )
+    {
+        printf("  Error %d opening pipe\n", errno);
+        return -1;
+    }
+    fcntl(pipe_fd[0], F_SETFL, O_NONBLOCK);
+    uart_reader_init(&uart, pipe_fd[0]);
+
+    // Sentences written in pieces of growing size, a partial line is not returned
+    piece = 1;
+    for ( i = 0; i < (int) (sizeof(sentences) / sizeof(char *)); i++ )
+    {
+        len = strlen(sentences[i]);
+        for ( pos = 0; pos < len; pos += piece, piece = (piece % 13) + 1 )
+        {
+            if ( uart_read_line(&uart, &line, 0) != 0 )
+            {
+                printf("  Partial line %d returned\n", i);
+                errors++;
+            }
+            write(pipe_fd[1], &sentences[i][pos], (len - pos) < piece ? (len - pos) : piece);
+        }
+        write(pipe_fd[1], "\r\n", 2);
+
+        n = uart_read_line(&uart, &line, TEST_UART_TIMEOUT);
+        if ( n != len || strcmp(line, sentences[i]) )
+        {
+            printf("  Line %d mismatch\n", i);
+            errors++;
+        }
+    }
+
+    // Lines that arrive together are all returned without waiting
+    for ( i = 0; i < (int) (sizeof(sentences) / sizeof(char *)); i++ )
+    {
+        write(pipe_fd[1], sentences[i], strlen(sentences[i]));
+        write(pipe_fd[1], "\r\n", 2);
+    }
+
+    for ( i = 0; (n = uart_read_line(&uart, &line, 0)) > 0; i++ )
+    {
+        if ( i >= (int) (sizeof(sentences) / sizeof(char *)) || strcmp(line, sentences[i]) )
+        {
+            printf("  Buffered line %d mismatch\n", i);
+            errors++;
+            break;
+        }
+    }
+
+    if ( i != (int) (sizeof(sentences) / sizeof(char *)) )
+    {
+        printf("  %d of %d buffered lines returned\n", i, (int) (sizeof(sentences) / sizeof(char *)));
+        errors++;
+    }
+
+    // A line longer than the buffer is returned in parts
+    for ( i = 0; i < (int) sizeof(long_line) - 1; i++ )
+        long_line[i] = 'A' + (i % 26);
+    long_line[i] = '\n';
+    write(pipe_fd[1], long_line, sizeof(long_line));
+
+    total = 0;
+    while ( (n = uart_read_line(&uart, &line, 0)) > 0 )
+    {
+        if ( memcmp(line, &long_line[total], n) )
+        {
+            printf("  Long line mismatch at %d\n", total);
+            errors++;
+        }
+        total += n;
+    }
+
+    if ( total != (int) sizeof(long_line) - 1 )
+    {
+        printf("  Long line returned %d of %d characters\n", total, (int) sizeof(long_line) - 1);
+        errors++;
+    }
+
+    // Waiting for a line sleeps in poll() until the timeout
+    start = time_usec();
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+    n = uart_read_line(&uart, &line, TEST_IDLE_WAIT);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+    wall_time = time_usec() - start;
+    cpu_time = ((cpu_end.tv_sec - cpu_start.tv_sec) * 1000000.0) + ((cpu_end.tv_nsec - cpu_start.tv_nsec) / 1000.0);
+
+    printf("  Idle wait %8.1f [mSec], CPU %8.3f [mSec]\n", wall_time / 1000.0, cpu_time / 1000.0);
+    if ( n != 0 || wall_time < (TEST_IDLE_WAIT * 1000.0) || cpu_time > (TEST_IDLE_CPU * wall_time) )
+        errors++;
+
+    close(pipe_fd[0]);
+    close(pipe_fd[1]);
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t17_gps_thread()
+ *
+ *  Feed NMEA sentences through a pipe to the GPS ingest thread and
+ *  read the queued fixes as the UI thread does. No sentence is lost
+ *  while the reader stalls, a full queue drops and counts fixes, and
+ *  sentences streamed in bursts are read in order.
+ *  Print the latency from a sentence burst to its last fix.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a lost fix
+ *
+ */
+int test_t17_gps_thread(void)
+{
+    struct gps_fix_t    fix;
+    struct pollfd       poll_fd;
+    struct timespec     cpu_start, cpu_end;
+    char    text[(GPS_FIX_QUEUE + TEST_GPS_OVERRUN) * 96];
+    int     pipe_fd[2];
+    int     i, len, number, expected, count;
+    int     errors = 0;
+    double  start, latency, wall_time, cpu_time;
+    double  total_latency = 0.0, max_latency = 0.0;
+
+    printf("Test t17\n");
+
+    if ( pipe(pipe_fd) == -1 )
+    {
+        printf("  Error %d opening pipe\n", errno);
+        return -1;
+    }
+    fcntl(pipe_fd[0], F_SETFL, O_NONBLOCK);
+
+    if ( gps_open(pipe_fd[0]) == -1 )
+    {
+        printf("  Error starting GPS thread\n");
+        close(pipe_fd[0]);
+        close(pipe_fd[1]);
+        return -1;
+    }
+
+    poll_fd.fd = gps_fix_fd();
+    poll_fd.events = POLLIN;
+
+    // Sentences that arrive while the reader stalls are all queued,
+    // every fourth sentence has a bad checksum and keeps the last position
+    len = 0;
+    for ( i = 0; i < GPS_FIX_QUEUE; i++ )
+        len += gps_sentence(&text[len], i, i % 4);
+    write(pipe_fd[1], text, len);
+    hal_delay(TEST_GPS_STALL);
+
+    if ( poll(&poll_fd, 1, 0) != 1 )
+    {
+        printf("  Queued fixes not signaled\n");
+        errors++;
+    }
+
+    for ( count = 0; gps_read(&fix); count++ )
+    {
+        number = (fix.pos.min * 60) + (int) fix.pos.sec;
+        expected = ((count % 4) || count == 0) ? count : count - 1;
+        if ( fix.status != ((count % 4) ? GPS_FIX_VALID : GPS_FIX_INVALID) || number != expected )
+        {
+            printf("  Fix %d is sentence %d status %d\n", count, number, fix.status);
+            errors++;
+            break;
+        }
+    }
+
+    if ( count != GPS_FIX_QUEUE || gps_overruns() != 0 )
+    {
+        printf("  %d of %d fixes read, %u dropped\n", count, GPS_FIX_QUEUE, gps_overruns());
+        errors++;
+    }
+
+    if ( poll(&poll_fd, 1, 0) != 0 )
+    {
+        printf("  Empty queue signaled\n");
+        errors++;
+    }
+
+    // Sentences beyond a full queue are dropped and counted
+    len = 0;
+    for ( i = 0; i < GPS_FIX_QUEUE + TEST_GPS_OVERRUN; i++ )
+        len += gps_sentence(&text[len], i + 100, 1);
+    write(pipe_fd[1], text, len);
+    hal_delay(TEST_GPS_STALL);
+
+    number = -1;
+    for ( count = 0; gps_read(&fix); count++ )
+        number = (fix.pos.min * 60) + (int) fix.pos.sec;
+
+    if ( count != GPS_FIX_QUEUE || number != (GPS_FIX_QUEUE - 1 + 100) || gps_overruns() != TEST_GPS_OVERRUN )
+    {
+        printf("  Full queue read %d fixes, %u dropped\n", count, gps_overruns());
+        errors++;
+    }
+
+    // Flushed fixes are not read
+    len = 0;
+    for ( i = 0; i < TEST_GPS_BURST; i++ )
+        len += gps_sentence(&text[len], i, 1);
+    write(pipe_fd[1], text, len);
+    hal_delay(TEST_GPS_STALL);
+    gps_flush();
+
+    if ( gps_read(&fix) || poll(&poll_fd, 1, 0) != 0 )
+    {
+        printf("  Fixes read after flush\n");
+        errors++;
+    }
+
+    // Sentence bursts are read while the thread parses the next ones
+    expected = 0;
+    for ( i = 0; i < TEST_GPS_STREAM && !errors; i += TEST_GPS_BURST )
+    {
+        len = 0;
+        for ( count = 0; count < TEST_GPS_BURST; count++ )
+            len += gps_sentence(&text[len], i + count, 1);
+
+        start = time_usec();
+        write(pipe_fd[1], text, len);
+
+        while ( expected < (i + TEST_GPS_BURST) )
+        {
+            if ( poll(&poll_fd, 1, TEST_UART_TIMEOUT) != 1 )
+            {
+                printf("  Timeout waiting for fix %d\n", expected);
+                errors++;
+                break;
+            }
+
+            while ( gps_read(&fix) )
+            {
+                number = (fix.pos.min * 60) + (int) fix.pos.sec;
+                if ( number != (expected % 3600) )
+                {
+                    printf("  Fix %d is sentence %d\n", expected, number);
+                    errors++;
+                }
+                expected++;
+            }
+        }
+
+        latency = time_usec() - start;
+        total_latency += latency;
+        if ( latency > max_latency )
+            max_latency = latency;
+    }
+
+    printf("  Burst to fix latency avg %8.1f [uSec], max %8.1f [uSec]\n",
+           total_latency / (TEST_GPS_STREAM / TEST_GPS_BURST), max_latency);
+
+    if ( gps_overruns() != TEST_GPS_OVERRUN )
+    {
+        printf("  %u fixes dropped while streaming\n", gps_overruns() - TEST_GPS_OVERRUN);
+        errors++;
+    }
+
+    // A closed UART leaves the thread idle
+    close(pipe_fd[1]);
+    start = time_usec();
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+    hal_delay(TEST_IDLE_WAIT);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+    wall_time = time_usec() - start;
+    cpu_time = ((cpu_end.tv_sec - cpu_start.tv_sec) * 1000000.0) + ((cpu_end.tv_nsec - cpu_start.tv_nsec) / 1000.0);
+
+    printf("  Closed UART %8.1f [mSec], CPU %8.3f [mSec]\n", wall_time / 1000.0, cpu_time / 1000.0);
+    if ( cpu_time > (TEST_IDLE_CPU * wall_time) )
+        errors++;
+
+    gps_close();
+    close(pipe_fd[0]);
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t18_nmea_tokenizer()
+ *
+ *  Parse NMEA sentences with nmea_update_pos() and with the reference
+ *  parser that extracts every field with nmea_get_field(), and compare
+ *  the position and fix status after every sentence. Check the field
+ *  offsets and lengths of the tokenizer, and print the field split
+ *  and parse time per sentence of both parsers.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a position mismatch
+ *
+ */
+int test_t18_nmea_tokenizer(void)
+{
+    static const char *bodies[] =
+    {
+        "GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+        "GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W",
+        "GPGGA,092750.000,5321.6802,S,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,",
+        "GPRMC,092750.000,A,5321.6802,S,00630.3372,W,0.02,31.66,280511,,,A",
+        "GPGGA,092751.000,,,,,0,00,,,M,,M,,",
+        "GPRMC,092751.000,V,,,,,,,280511,,,N",
+        "GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.37",
+        "GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30",
+        "GPVTG,054.7,T,034.4,M,005.5,N,010.2,K",
+        "GPZZZ,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24",
+    };
+
+    struct nmea_sentence_t  sentence;
+    struct position_t   pos, ref_pos;
+    char    sentences[TEST_NMEA_VARIANTS * (sizeof(bodies) / sizeof(char *))][128];
+    char    text[128];
+    char    data[128];
+    char    field[16];
+    int     count = 0;
+    int     i, n, rep, valid, ref_valid;
+    int     errors = 0;
+    double  start, split_time, ref_split_time, parse_time, ref_parse_time;
+
+    printf("Test t18\n");
+
+    // Every sentence with a valid checksum, a lower case checksum after a repeated '$',
+    // a wrong checksum, a missing checksum and a truncated checksum
+    for ( i = 0; i < (int) (sizeof(bodies) / sizeof(char *)); i++ )
+    {
+        strcpy(text, bodies[i]);
+        sprintf(sentences[count++], "$%s*%02X", bodies[i], nmea_checksum(text));
+        sprintf(sentences[count++], "$$%s*%02x", bodies[i], nmea_checksum(text));
+        sprintf(sentences[count++], "$%s*%02X", bodies[i], nmea_checksum(text) ^ 0x01);
+        sprintf(sentences[count++], "$%s", bodies[i]);
+        sprintf(sentences[count++], "$%s*%X", bodies[i], nmea_checksum(text) >> 4);
+    }
+
+    // Field offsets and lengths
+    if ( nmea_tokenize(sentences[0], &sentence) != 15 ||
+         nmea_field_copy(&sentence, NMEA_GGA_LAT, field, sizeof(field)) != 8 || strcmp(field, "4807.038") ||
+         !nmea_field_is(&sentence, NMEA_MSG_ID, "GPGGA") || nmea_field_is(&sentence, NMEA_MSG_ID, "GPGG") ||
+         sentence.field[NMEA_GGA_DCID].length != 0 || nmea_field_is(&sentence, NMEA_GGA_DCID + 1, "") )
+    {
+        printf("  GGA sentence fields mismatch\n");
+        errors++;
+    }
+
+    if ( nmea_tokenize(sentences[(sizeof(bodies) / sizeof(char *) - 1) * TEST_NMEA_VARIANTS], &sentence) != NMEA_FIELDS ||
+         strncmp(nmea_field_text(&sentence, NMEA_FIELDS - 1), "19,", 3) )
+    {
+        printf("  Long sentence fields mismatch\n");
+        errors++;
+    }
+
+    // Same position and fix status after every sentence
+    memset(&pos, 0, sizeof(struct position_t));
+    memset(&ref_pos, 0, sizeof(struct position_t));
+
+    for ( i = 0; i < count; i++ )
+    {
+        strcpy(text, sentences[i]);
+        ref_valid = ref_nmea_update_pos(text, &ref_pos);
+        valid = nmea_update_pos(sentences[i], &pos);
+
+        if ( valid != ref_valid || memcmp(&pos, &ref_pos, sizeof(struct position_t)) )
+        {
+            printf("  Sentence %d mismatch |%s|\n", i, sentences[i]);
+            errors++;
+        }
+    }
+
+    // Field split time of the GGA and RMC sentences with a valid checksum,
+    // the reference splits the checksum and then every field
+    start = time_usec();
+    for ( rep = 0; rep < TEST_NMEA_REPS; rep++ )
+    {
+        for ( i = 0; i < (4 * TEST_NMEA_VARIANTS); i += TEST_NMEA_VARIANTS )
+        {
+            strcpy(text, sentences[i]);
+            lstrip(text, "$");
+            nmea_get_field(text, '*', NMEA_MSG, data, sizeof(data));
+            nmea_get_field(text, '*', NMEA_CHECKSUM, field, sizeof(field));
+            for ( n = 0; nmea_get_field(data, ',', n, field, sizeof(field)) != -1; n++ );
+        }
+    }
+    ref_split_time = (time_usec() - start) / (TEST_NMEA_REPS * 4);
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_NMEA_REPS; rep++ )
+    {
+        for ( i = 0; i < (4 * TEST_NMEA_VARIANTS); i += TEST_NMEA_VARIANTS )
+        {
+            strcpy(text, sentences[i]);
+            nmea_tokenize(text, &sentence);
+        }
+    }
+    split_time = (time_usec() - start) / (TEST_NMEA_REPS * 4);
+
+    // Parse time of all sentences, sentences are copied for both parsers
+    // because the reference parser modifies the sentence string
+    start = time_usec();
+    for ( rep = 0; rep < TEST_NMEA_REPS; rep++ )
+    {
+        for ( i = 0; i < count; i++ )
+        {
+            strcpy(text, sentences[i]);
+            ref_nmea_update_pos(text, &ref_pos);
+        }
+    }
+    ref_parse_time = (time_usec() - start) / (TEST_NMEA_REPS * count);
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_NMEA_REPS; rep++ )
+    {
+        for ( i = 0; i < count; i++ )
+        {
+            strcpy(text, sentences[i]);
+            nmea_update_pos(text, &pos);
+        }
+    }
+    parse_time = (time_usec() - start) / (TEST_NMEA_REPS * count);
+
+    printf("  Field split time    %6.3f [uSec], reference %6.3f [uSec]\n", split_time, ref_split_time);
+    printf("  Sentence parse time %6.3f [uSec], reference %6.3f [uSec]\n", parse_time, ref_parse_time);
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t19_nmea_decoders()
+ *
+ *  Decode random coordinate, time and decimal fields with the NMEA
+ *  field decoders, and compare them to exact integer results.
+ *  Coordinates must be within half a micro-degree of the exact value.
+ *  Print the largest error of the sscanf() decoding that the decoders
+ *  replaced, check that malformed fields are rejected, and print the
+ *  decode time per field of both.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a decoded value mismatch
+ *
+ */
+int test_t19_nmea_decoders(void)
+{
+    static const char *bad_coords[] = { "", ",", "4807.03", "48a7.038", "4860.000", ".038" };
+    static const char *bad_times[] = { "", "*", "12:519", "1235", "996199,", "240000,", "126000,", "125961," };
+    static const char *bad_fixed[] = { "", ",", "-", ".", "-.*" };
+
+    char    text[32];
+    int     i, n, rep, deg, deg_digits, decimals;
+    int     hour, min, exact_hour, exact_min;
+    int64_t minutes, scale, exact_udeg;
+    int32_t udeg, msec, exact_msec, value, exact_value;
+    float   f_deg, f_min, f_sec, f_value;
+    double  exact_deg, error;
+    double  max_error = 0.0, max_ref_error = 0.0;
+    double  max_time_error = 0.0, max_value_error = 0.0;
+    double  start, decode_time[4], ref_time[4];
+    int     errors = 0;
+
+    printf("Test t19\n");
+
+    srand(1);
+
+    // Latitude and longitude with 3 to 5 minute decimals
+    for ( i = 0; i < TEST_DECODE_VALUES; i++ )
+    {
+        deg_digits = (i & 1) ? NMEA_LONG_DEG : NMEA_LAT_DEG;
+        deg = rand() % ((i & 1) ? 180 : 90);
+        decimals = 3 + (rand() % 3);
+        for ( scale = 1, n = 0; n < decimals; n++ )
+            scale *= 10;
+        minutes = (((int64_t) rand() * RAND_MAX) + rand()) % (60 * scale);
+
+        sprintf(text, "%0*d%02d.%0*lld,", deg_digits, deg, (int) (minutes / scale), decimals, (long long) (minutes % scale));
+
+        exact_udeg = ((((deg * 60 * scale) + minutes) * 2000000) + (60 * scale)) / (120 * scale);
+        exact_deg = deg + (minutes / (60.0 * scale));
+
+        if ( nmea_decode_coord(text, deg_digits, &udeg) != 0 || udeg != exact_udeg )
+        {
+            printf("  Coordinate |%s| decoded %d, exact %lld\n", text, udeg, (long long) exact_udeg);
+            errors++;
+            continue;
+        }
+
+        error = fabs((udeg / 1000000.0) - exact_deg) * 1000000.0;
+        if ( error > max_error )
+            max_error = error;
+
+        sscanf(text, (deg_digits == NMEA_LAT_DEG) ? "%2f%7f" : "%3f%7f", &f_deg, &f_min);
+        error = fabs((f_deg + f_min/60.0) - exact_deg) * 1000000.0;
+        if ( error > max_ref_error )
+            max_ref_error = error;
+    }
+
+    printf("  Coordinate max error %10.3f [uDeg], sscanf() %10.3f [uDeg]\n", max_error, max_ref_error);
+    if ( max_error > 0.5 + 1e-6 )
+        errors++;
+
+    // UTC time with 0 to 3 second decimals
+    for ( i = 0; i < TEST_DECODE_VALUES; i++ )
+    {
+        exact_hour = rand() % 24;
+        exact_min = rand() % 60;
+        exact_msec = rand() % 60000;
+        decimals = i % 4;
+        for ( scale = 1, n = decimals; n < 3; n++ )
+            scale *= 10;
+        exact_msec -= exact_msec % scale;
+
+        if ( decimals )
+            sprintf(text, "%02d%02d%02d.%0*d,", exact_hour, exact_min, exact_msec / 1000, decimals, (int) ((exact_msec % 1000) / scale));
+        else
+            sprintf(text, "%02d%02d%02d,", exact_hour, exact_min, exact_msec / 1000);
+
+        if ( nmea_decode_time(text, &hour, &min, &msec) != 0 ||
+             hour != exact_hour || min != exact_min || msec != exact_msec )
+        {
+            printf("  Time |%s| decoded %d:%d:%d\n", text, hour, min, msec);
+            errors++;
+            continue;
+        }
+
+        sscanf(text, "%2d%2d%6f", &hour, &min, &f_sec);
+        error = fabs((f_sec * 1000.0) - exact_msec);
+        if ( error > max_time_error )
+            max_time_error = error;
+    }
+
+    printf("  Time max error       %10.3f [mSec], sscanf() %10.3f [mSec]\n", 0.0, max_time_error);
+
+    // Speed and course with 0 to 3 decimals, decoded to thousandths
+    for ( i = 0; i < TEST_DECODE_VALUES; i++ )
+    {
+        exact_value = rand() % 1000000;
+        decimals = i % 4;
+        for ( scale = 1, n = decimals; n < 3; n++ )
+            scale *= 10;
+        exact_value -= exact_value % scale;
+
+        if ( decimals )
+            sprintf(text, "%d.%0*d,", exact_value / 1000, decimals, (int) ((exact_value % 1000) / scale));
+        else
+            sprintf(text, "%d,", exact_value / 1000);
+
+        if ( nmea_decode_fixed(text, 3, &value) != 0 || value != exact_value )
+        {
+            printf("  Decimal |%s| decoded %d, exact %d\n", text, value, exact_value);
+            errors++;
+            continue;
+        }
+
+        sscanf(text, "%4f", &f_value);
+        error = fabs(f_value - (exact_value / 1000.0));
+        if ( error > max_value_error )
+            max_value_error = error;
+    }
+
+    printf("  Decimal max error    %10.3f,        sscanf() %10.3f\n", 0.0, max_value_error);
+
+    // Rounding of extra decimals
+    if ( nmea_decode_fixed("1.2345*", 3, &value) != 0 || value != 1235 ||
+         nmea_decode_fixed("0.0004,", 3, &value) != 0 || value != 0 ||
+         nmea_decode_fixed("-2.5,", 0, &value) != 0 || value != -3 ||
+         nmea_decode_fixed("08,", 0, &value) != 0 || value != 8 )
+    {
+        printf("  Decimal rounding mismatch\n");
+        errors++;
+    }
+
+    // Malformed fields
+    for ( i = 0; i < (int) (sizeof(bad_coords) / sizeof(char *)); i++ )
+    {
+        if ( nmea_decode_coord(bad_coords[i], NMEA_LONG_DEG, &udeg) == 0 &&
+             nmea_decode_coord(bad_coords[i], NMEA_LAT_DEG, &udeg) == 0 )
+        {
+            printf("  Coordinate |%s| not rejected\n", bad_coords[i]);
+            errors++;
+        }
+    }
+
+    for ( i = 0; i < (int) (sizeof(bad_times) / sizeof(char *)); i++ )
+    {
+        if ( nmea_decode_time(bad_times[i], &hour, &min, &msec) == 0 )
+        {
+            printf("  Time |%s| not rejected\n", bad_times[i]);
+            errors++;
+        }
+    }
+
+    // A leap second is a valid time
+    if ( nmea_decode_time("235960.5,", &hour, &min, &msec) != 0 || hour != 23 || min != 59 || msec != 60500 )
+    {
+        printf("  Leap second not decoded\n");
+        errors++;
+    }
+
+    for ( i = 0; i < (int) (sizeof(bad_fixed) / sizeof(char *)); i++ )
+    {
+        if ( nmea_decode_fixed(bad_fixed[i], 3, &value) == 0 )
+        {
+            printf("  Decimal |%s| not rejected\n", bad_fixed[i]);
+            errors++;
+        }
+    }
+
+    // Decode time per field, against the decoding they replaced
+    start = time_usec();
+    for ( rep = 0; rep < TEST_DECODE_REPS; rep++ )
+        nmea_decode_coord("4807.038,N", NMEA_LAT_DEG, &udeg);
+    decode_time[0] = time_usec() - start;
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_DECODE_REPS; rep++ )
+        sscanf("4807.038,N", "%2f%7f", &f_deg, &f_min);
+    ref_time[0] = time_usec() - start;
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_DECODE_REPS; rep++ )
+        nmea_decode_time("123519.000,", &hour, &min, &msec);
+    decode_time[1] = time_usec() - start;
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_DECODE_REPS; rep++ )
+        sscanf("123519.000,", "%2d%2d%6f", &hour, &min, &f_sec);
+    ref_time[1] = time_usec() - start;
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_DECODE_REPS; rep++ )
+        nmea_decode_fixed("022.4,", 3, &value);
+    decode_time[2] = time_usec() - start;
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_DECODE_REPS; rep++ )
+        sscanf("022.4,", "%4f", &f_value);
+    ref_time[2] = time_usec() - start;
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_DECODE_REPS; rep++ )
+        nmea_decode_fixed("08,", 0, &value);
+    decode_time[3] = time_usec() - start;
+
+    start = time_usec();
+    for ( rep = 0; rep < TEST_DECODE_REPS; rep++ )
+        value = atoi("08,");
+    ref_time[3] = time_usec() - start;
+
+    printf("  Coordinate decode %7.4f [uSec], sscanf() %7.4f [uSec]\n", decode_time[0] / TEST_DECODE_REPS, ref_time[0] / TEST_DECODE_REPS);
+    printf("  Time decode       %7.4f [uSec], sscanf() %7.4f [uSec]\n", decode_time[1] / TEST_DECODE_REPS, ref_time[1] / TEST_DECODE_REPS);
+    printf("  Decimal decode    %7.4f [uSec], sscanf() %7.4f [uSec]\n", decode_time[2] / TEST_DECODE_REPS, ref_time[2] / TEST_DECODE_REPS);
+    printf("  Integer decode    %7.4f [uSec], atoi()   %7.4f [uSec]\n", decode_time[3] / TEST_DECODE_REPS, ref_time[3] / TEST_DECODE_REPS);
+
+    printf("  %d errors\n", errors);
+    printf("Done\n");
+
+    return errors ? -1 : 0;
+}
+
+/********************************************************************
+ * test_t20_glyph_cache()
+ *
+ *  Draw characters 0 to 255 into the frame buffer with lcdDrawChar(),
+ *  opaque and transparent at scales 1 to 5, and compare every draw with
+ *  a reference raster that reads the font. The text and background colors
+ *  cycle through more combinations than the glyph cache holds, so cached
+ *  glyphs are evicted and rendered again. Print the time to draw one
+ *  character with the glyph cache and with the reference raster.
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error or a character mismatch
+ *
+ */
+int test_t20_glyph_cache(void)
+{
+    int         pass, combo, scale, transparent, c, i, x, y;
+    int         mismatch = 0;
+    uint16_t    color[TEST_GLYPH_COLORS], bg_color[TEST_GLYPH_COLORS];
+    double      start, draw_time[2], ref_time[2];
+
+    printf("Test t20\n");
+
+    if ( lcd_test_init() )
+        return -1;
+
+    srand(1);
+    for ( combo = 0; combo < TEST_GLYPH_COLORS; combo++ )
+    {
+        color[combo] = (uint16_t) rand();
+        bg_color[combo] = (uint16_t) rand();
+    }
+
+    for ( i = 0; i < FRAME_BUFF_SIZE; i++ )
+        frame_buffer[i] = (uint16_t) rand();
+    memcpy(ref_frame_buffer, frame_buffer, sizeof(frame_buffer));
+
+    // Every character of every combination and scale, twice, so the
+    // second pass draws glyphs that were evicted after the first
+    for ( pass = 0; pass < 2; pass++ )
+    {
+        for ( combo = 0; combo < TEST_GLYPH_COLORS; combo++ )
+        {
+            for ( scale = 1; scale <= TEST_GLYPH_SCALE; scale++ )
+            {
+                for ( transparent = 0; transparent < 2; transparent++ )
+                {
+                    for ( c = 0; c < 256; c++ )
+                    {
+                        x = (c * 7) % (lcdWidth() - (FONT_PIX_WIDE * scale) + 1);
+                        y = (c * 13) % (lcdHeight() - (FONT_PIX_HIGH * scale) + 1);
+
+                        lcdDrawChar(frame_buffer, x, y, (char) c, color[combo], bg_color[combo], scale, transparent);
+                        ref_draw_char(ref_frame_buffer, x, y, (char) c, color[combo], bg_color[combo], scale, transparent);
+
+                        if ( memcmp(frame_buffer, ref_frame_buffer, sizeof(frame_buffer)) )
+                        {
+                            if ( mismatch < 10 )
+                                printf("  Character %d mismatch, colors %d scale %d %s\n",
+                                       c, combo, scale, transparent ? "transparent" : "opaque");
+                            memcpy(ref_frame_buffer, frame_buffer, sizeof(frame_buffer));
+                            mismatch++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("  Character draws %8d, %d mismatched\n", 2 * TEST_GLYPH_COLORS * TEST_GLYPH_SCALE * 2 * 256, mismatch);
+
+    // Draw time per character at scale 1, the GPS screen text size
+    for ( transparent = 0; transparent < 2; transparent++ )
+    {
+        start = time_usec();
+        for ( i = 0; i < TEST_GLYPH_DRAWS; i++ )
+            lcdDrawChar(frame_buffer, (i * 6) % 150, (i * 8) % 120, (char) (' ' + (i % 95)), color[0], bg_color[0], 1, transparent);
+        draw_time[transparent] = (time_usec() - start) * 1000.0 / TEST_GLYPH_DRAWS;
+
+        start = time_usec();
+        for ( i = 0; i < TEST_GLYPH_DRAWS; i++ )
+            ref_draw_char(ref_frame_buffer, (i * 6) % 150, (i * 8) % 120, (char) (' ' + (i % 95)), color[0], bg_color[0], 1, transparent);
+        ref_time[transparent] = (time_usec() - start) * 1000.0 / TEST_GLYPH_DRAWS;
+    }
+
+    printf("  Opaque draw     %8.1f [nSec] per character, reference %8.1f [nSec]\n", draw_time[0], ref_time[0]);
+    printf("  Transparent draw%8.1f [nSec] per character, reference %8.1f [nSec]\n", draw_time[1], ref_time[1]);
+    printf("  %d errors\n", mismatch ? 1 : 0);
+    printf("Done\n");
+
+    lcdBusClose();
+    hal_close();
+
+    return mismatch ? -1 : 0;
+}
+
+/********************************************************************
+ * ref_map_patch()
+ *
+ *  Reference map patch kernel using the original double precision
+ *  per-pixel transform, with the heading rounded to MAP_HEADING_RES. Used to validate and time get_map_patch().
+ *
+ *  param:  same as get_map_patch()
+ *  return: none
+ *
+ */
+static void ref_map_patch(struct position_t *pos, struct map_t *map_attrib, uint16_t *image_buffer,
+                          uint16_t *frame, int roi_img_width, int roi_img_height)
+{
+    int     y, x, yt, xt, u, v;
+    int     hwidth, hheight;
+    int     roi_center_x, roi_center_y;
+    double  map_res_x, map_res_y;
+    double  theta, sin_theta, cos_theta;
+
+    hheight = roi_img_height / 2;
+    hwidth = roi_img_width / 2;
+    theta = lroundf(pos->heading * MAP_HEADING_RES) / (double)MAP_HEADING_RES;
+    sin_theta = sin(theta * M_PI / 180.0);
+    cos_theta = cos(theta * M_PI / 180.0);
+
+    map_res_x = fabs(map_attrib->br_long - map_attrib->tl_long) / (double)map_attrib->width;
+    roi_center_x = (int)(fabs(pos->longitude - map_attrib->tl_long) / map_res_x);
+
+    map_res_y = fabs(map_attrib->br_lat - map_attrib->tl_lat) / (double)map_attrib->height;
+    roi_center_y = (int)(fabs(pos->latitude - map_attrib->tl_lat) / map_res_y);
+
+    for ( y = 0; y < roi_img_height; y++ )
+    {
+        for ( x = 0; x < roi_img_width; x++ )
+        {
+            xt = x - hwidth;
+            yt = y - hheight;
+
+            u = (int)(xt * cos_theta - yt * sin_theta) + roi_center_x;
+            v = (int)(xt * sin_theta + yt * cos_theta) + roi_center_y;
+
+            if ( u >= 0 && u < map_attrib->width && v >= 0 && v < map_attrib->height )
+                frame[(y * roi_img_width) + x] = image_buffer[(v * map_attrib->width) + u];
+            else
+                frame[(y * roi_img_width) + x] = ST7735_BLACK;
+        }
+    }
+}
+
+/********************************************************************
+ * cmp_map_patch()
+ *
+ *  Compare two map patches rendered from the synthetic map image.
+ *  Pixels match if their encoded source coordinates are within one pixel,
+ *  or if one of them is out of the map and the other is on the map edge.
+ *
+ *  param:  pointers to two map patches, pixel count
+ *  return: number of mismatched pixels
+ *
+ */
+static int cmp_map_patch(uint16_t *patch, uint16_t *ref_patch, int pixels)
+{
+    int     i, u, v, ref_u, ref_v;
+    int     mismatch = 0;
+
+    for ( i = 0; i < pixels; i++ )
+    {
+        if ( patch[i] == ref_patch[i] )
+            continue;
+
+        u = (patch[i] - 1) & 0xff;
+        v = (patch[i] - 1) >> 8;
+        ref_u = (ref_patch[i] - 1) & 0xff;
+        ref_v = (ref_patch[i] - 1) >> 8;
+
+        if ( patch[i] == ST7735_BLACK )
+        {
+            u = ref_u;
+            v = ref_v;
+        }
+
+        if ( patch[i] == ST7735_BLACK || ref_patch[i] == ST7735_BLACK )
+        {
+            if ( u > 0 && u < (TEST_MAP_WIDTH - 1) && v > 0 && v < (TEST_MAP_HEIGHT - 1) )
+                mismatch++;
+        }
+        else if ( abs(u - ref_u) > 1 || abs(v - ref_v) > 1 )
+        {
+            mismatch++;
+        }
+    }
+
+    return mismatch;
+}
+
+/********************************************************************
+ * time_usec()
+ *
+ *  Monotonic time stamp for benchmarks.
+ *
+ *  param:  none
+ *  return: time in micro-seconds
+ *
+ */
+static double time_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0) + (ts.tv_nsec / 1000.0);
+}
+
+/********************************************************************
+ * lcd_test_init()
+ *
+ *  Initialize GPIO, SPI and the LCD for tests that display output,
+ *  same sequence as test_t0_lcd().
+ *
+ *  param:  none
+ *  return: 0 if no error,
+ *         -1 if error initializing the IO subsystem or SPI
+ *
+ */
+static int lcd_test_init(void)
+{
+    if ( hal_init() == -1 )
+    {
+        printf("  hal_init failed. Are you running as root?\n");
+        return -1;
+    }
+
+    if ( lcdBusInit() == -1 )
+    {
+        printf("  lcdBusInit failed. Is the SPI bus accessible?\n");
+        return -1;
+    }
+
+    lcdInit();
+    lcdSetRotation(LCD_ROTATION);
+
+    return 0;
+}
+
+/********************************************************************
+ * gps_screen_update()
+ *
+ *  Draw one update of the GPS data screen with VT100 printf() lines
+ *  that are erased and printed again, with a slowly changing position.
+ *
+ *  param:  frame buffer and update number
+ *  return: none
+ *
+ */
+static void gps_screen_update(uint16_t *frame, int update)
+{
+    vt100_lcd_printf(frame, 0, "\e[2;1f%c", (update & 1) ? ' ' : '*');
+    vt100_lcd_printf(frame, 0, "\e[3;0f\e[2KUTC Time %02d:%02d:%#-6.3f", 12, 30, 10.0 + update);
+    vt100_lcd_printf(frame, 0, "\e[4;0f\e[2KLatitude %#-10.6f", 42.272169 + (update * 0.000011));
+    vt100_lcd_printf(frame, 0, "\e[5;0f\e[2KLongitude %#-10.6f", -71.214177);
+    vt100_lcd_printf(frame, 0, "\e[6;0f\e[2KSatellites %d", 7);
+    vt100_lcd_printf(frame, 0, "\e[7;0f\e[2KGround speed %-5.2f [mph]", 3.1);
+    vt100_lcd_printf(frame, 0, "\e[8;0f\e[2KHeading %-5.1f [deg]", 120.0);
+    vt100_lcd_printf(frame, 0, "\e[10;0f\e[2K");
+}
+
+/********************************************************************
+ * gps_field_screen()
+ *
+ *  Print the GPS data screen labels and register its numeric
+ *  fields the same way gps_data() in nav.c does.
+ *
+ *  param:  frame buffer
+ *  return: none
+ *
+ */
+static void gps_field_screen(uint16_t *frame)
+{
+    vt100_lcd_printf(frame, 0, "\e[3;0fUTC Time   :  :");
+    vt100_lcd_printf(frame, 0, "\e[4;0fLatitude");
+    vt100_lcd_printf(frame, 0, "\e[5;0fLongitude");
+    vt100_lcd_printf(frame, 0, "\e[6;0fSatellites");
+    vt100_lcd_printf(frame, 0, "\e[7;0fGround speed        [mph]");
+    vt100_lcd_printf(frame, 0, "\e[8;0fHeading       [deg]");
+
+    vt100_lcd_field_reset();
+    gps_fields[0] = vt100_lcd_field(3, 9, 2, 0, VT100_FIELD_ZERO, ST7735_WHITE, ST7735_BLACK);
+    gps_fields[1] = vt100_lcd_field(3, 12, 2, 0, VT100_FIELD_ZERO, ST7735_WHITE, ST7735_BLACK);
+    gps_fields[2] = vt100_lcd_field(3, 15, 6, 3, VT100_FIELD_ZERO, ST7735_WHITE, ST7735_BLACK);
+    gps_fields[3] = vt100_lcd_field(4, 9, 10, 6, VT100_FIELD_LEFT, ST7735_WHITE, ST7735_BLACK);
+    gps_fields[4] = vt100_lcd_field(5, 10, 11, 6, VT100_FIELD_LEFT, ST7735_WHITE, ST7735_BLACK);
+    gps_fields[5] = vt100_lcd_field(6, 11, 2, 0, VT100_FIELD_LEFT, ST7735_WHITE, ST7735_BLACK);
+    gps_fields[6] = vt100_lcd_field(7, 13, 6, 2, VT100_FIELD_LEFT, ST7735_WHITE, ST7735_BLACK);
+    gps_fields[7] = vt100_lcd_field(8, 8, 5, 1, VT100_FIELD_LEFT, ST7735_WHITE, ST7735_BLACK);
+}
+
+/********************************************************************
+ * gps_field_update()
+ *
+ *  Draw one update of the GPS data screen through numeric fields
+ *  the same way gps_data() in nav.c does, with the position of
+ *  gps_screen_update().
+ *
+ *  param:  frame buffer and update number
+ *  return: none
+ *
+ */
+static void gps_field_update(uint16_t *frame, int update)
+{
+    vt100_lcd_printf(frame, 0, "\e[2;1f%c", (update & 1) ? ' ' : '*');
+    vt100_lcd_field_int(frame, gps_fields[0], 12);
+    vt100_lcd_field_int(frame, gps_fields[1], 30);
+    vt100_lcd_field_float(frame, gps_fields[2], 10.0 + update);
+    vt100_lcd_field_float(frame, gps_fields[3], 42.272169 + (update * 0.000011));
+    vt100_lcd_field_float(frame, gps_fields[4], -71.214177);
+    vt100_lcd_field_int(frame, gps_fields[5], 7);
+    vt100_lcd_field_float(frame, gps_fields[6], 3.1);
+    vt100_lcd_field_float(frame, gps_fields[7], 120.0);
+    vt100_lcd_printf(frame, 0, "\e[10;0f\e[2K");
+}
+
+/********************************************************************
+ * gps_sentence()
+ *
+ *  Format a GGA sentence with a UTC time of minutes and seconds
+ *  that encode the sentence number, so the parsed fix can be
+ *  matched to its sentence.
+ *
+ *  param:  text buffer, sentence number, '0' for a bad checksum
+ *  return: sentence length including the line end
+ *
+ */
+static int gps_sentence(char *text, int number, int valid)
+{
+    char    gga[80];
+
+    snprintf(gga, sizeof(gga), "GPGGA,12%02d%02d.000,4216.3301,N,07112.8507,W,1,08,0.9,545.4,M,46.9,M,,",
+             (number / 60) % 60, number % 60);
+
+    return sprintf(text, "$%s*%02X\r\n", gga, (nmea_checksum(gga) + (valid ? 0 : 1)) & 0xff);
+}
+
+/********************************************************************
+ * scroll_pattern()
+ *
+ *  Draw lines of a test pattern along the LCD scroll axis,
+ *  line n of the frame buffer shows pattern line n + origin.
+ *
+ *  param:  frame buffer, first line and line count, pattern origin
+ *  return: none
+ *
+ */
+static void scroll_pattern(uint16_t *frame, int first, int count, int origin)
+{
+    int         line, i, across;
+    uint16_t    color;
+
+    across = (lcdWidth() == ST7735_TFTHEIGHT) ? lcdHeight() : lcdWidth();
+
+    for ( line = first; line < (first + count); line++ )
+    {
+        for ( i = 0; i < across; i++ )
+        {
+            color = ((((line + origin) / 12) ^ (i / 16)) & 1) ? ST7735_BLUE : ST7735_YELLOW;
+            if ( ((line + origin) % 50) == 0 )
+                color = ST7735_RED;
+
+            if ( lcdWidth() == ST7735_TFTHEIGHT )
+                frame[(i * lcdWidth()) + line] = color;
+            else
+                frame[(line * lcdWidth()) + i] = color;
+        }
+    }
+
+    if ( lcdWidth() == ST7735_TFTHEIGHT )
+        lcdFrameBufferDirty(first, 0, count, lcdHeight());
+    else
+        lcdFrameBufferDirty(0, first, lcdWidth(), count);
+}
+
+/********************************************************************
+ * hud_text()
+ *
+ *  Draw the HUD text of the map screen in nav.c, with a black
+ *  north marker and black text that must not be transparent.
+ *
+ *  param:  frame buffer, '1' to draw transparent text, heart beat character
+ *  return: none
+ *
+ */
+static void hud_text(uint16_t *frame, int transparent, char heart_beat)
+{
+    vt100_lcd_invalidate();
+    vt100_lcd_printf(frame, transparent, "\e[15;0f\e[34;40mPress 'LEFT' to exit.\e[37;40m");
+    vt100_lcd_printf(frame, transparent, "\e[0;22f\e[34;40mN-up\e[37;40m");
+    vt100_lcd_printf(frame, transparent, "\e[11;0f\e[30;40mBlack text\e[37;40m");
+    vt100_lcd_printf(frame, transparent, "\e[13;0f\e[31;40m** Fix not valid **\e[37;40m");
+    vt100_lcd_printf(frame, transparent, "\e[0;0f\e[34;40m%c\e[37;40m", heart_beat);
+    lcdDrawChar(frame, 78, 60, 0, ST7735_BLUE, ST7735_BLACK, 1, transparent);
+    lcdDrawChar(frame, 20, 40, 'N', ST7735_BLACK, ST7735_BLACK, 2, transparent);
+}
+
+/********************************************************************
+ * ref_fill_rect()
+ *
+ *  Reference rectangle fill, pixel by pixel with clipping.
+ *
+ *  param:  frame buffer, top left corner, width and height, color
+ *  return: none
+ *
+ */
+static void ref_fill_rect(uint16_t *frame, int x, int y, int w, int h, uint16_t color)
+{
+    int     px, py;
+
+    for ( py = y; py < (y + h); py++ )
+        for ( px = x; px < (x + w); px++ )
+            if ( px >= 0 && px < lcdWidth() && py >= 0 && py < lcdHeight() )
+                frame[(py * lcdWidth()) + px] = color;
+}
+
+/********************************************************************
+ * ref_draw_char()
+ *
+ *  Reference character raster that reads the font one bit per
+ *  pixel, with the screen range check of lcdDrawChar().
+ *  Used to validate the frame buffer path of lcdDrawChar().
+ *
+ *  param:  same as lcdDrawChar()
+ *  return: none
+ *
+ */
+static void ref_draw_char(uint16_t *frame, uint16_t x, uint16_t y, char c, uint16_t color, uint16_t bg_color, int scale, int transparent)
+{
+    const uint8_t  *font;
+    int     col, row, px, py;
+
+    if ( (x + (FONT_PIX_WIDE * scale) - 1) >= lcdWidth() ||
+         (y + (FONT_PIX_HIGH * scale) - 1) >= lcdHeight() )
+        return;
+
+    font = lcdFontChar(c);
+
+    for ( py = 0; py < (FONT_PIX_HIGH * scale); py++ )
+    {
+        for ( px = 0; px < (FONT_PIX_WIDE * scale); px++ )
+        {
+            col = px / scale;
+            row = py / scale;
+            if ( font[col] & (1 << row) )
+                frame[((y + py) * lcdWidth()) + x + px] = color;
+            else if ( !transparent )
+                frame[((y + py) * lcdWidth()) + x + px] = bg_color;
+        }
+    }
+}
+
+/********************************************************************
+ * ref_segment_distance()
+ *
+ *  Distance of a pixel center from a polyline segment.
+ *
+ *  param:  pixel coordinates, segment end points in 1/LCD_SUBPIXEL pixel
+ *  return: distance in pixels
+ *
+ */
+static double ref_segment_distance(double x, double y, const struct lcd_point_t *p0, const struct lcd_point_t *p1)
+{
+    double  x0, y0, dx, dy, len, t;
+
+    x0 = (double)p0->x / LCD_SUBPIXEL;
+    y0 = (double)p0->y / LCD_SUBPIXEL;
+    dx = (double)p1->x / LCD_SUBPIXEL - x0;
+    dy = (double)p1->y / LCD_SUBPIXEL - y0;
+    len = (dx * dx) + (dy * dy);
+
+    t = (len > 0.0) ? (((x - x0) * dx) + ((y - y0) * dy)) / len : 0.0;
+    if ( t < 0.0 )
+        t = 0.0;
+    else if ( t > 1.0 )
+        t = 1.0;
+
+    return hypot(x - x0 - (t * dx), y - y0 - (t * dy));
+}
+
+/********************************************************************
+ * ref_nmea_update_pos()
+ *
+ *  Reference NMEA parser that extracts every field with
+ *  nmea_get_field() into a scratch string, and decodes numbers
+ *  in double precision with sscanf(), coordinates are rounded to
+ *  micro-degrees. Used to validate and time nmea_update_pos().
+ *
+ *  param:  same as nmea_update_pos(), the sentence string is modified
+ *  return: same as nmea_update_pos()
+ *
+ */
+static int ref_nmea_update_pos(char *str, struct position_t *pos)
+{
+    int     exit_value = 0;
+    char    gps_data[128] = {0};
+    char    checksum_str[4] = {0};
+    char    data_field[16] = {0};
+    double  deg, min, value;
+
+    lstrip(str, "$");
+    nmea_get_field(str, '*', NMEA_MSG, gps_data, 128);
+    nmea_get_field(str, '*', NMEA_CHECKSUM, checksum_str, 4);
+
+    if ( strtol(checksum_str, NULL, 16) != nmea_checksum(gps_data) )
+        return 0;
+
+    nmea_get_field(gps_data, ',', NMEA_MSG_ID, data_field, 16);
+
+    if ( strcmp(data_field, "GPGGA") == 0 )
+    {
+        nmea_get_field(gps_data, ',', NMEA_GGA_FIXOK, data_field, 16);
+        if ( atoi(data_field) == 1 )
+        {
+            nmea_get_field(gps_data, ',', NMEA_GGA_UTC, data_field, 16);
+            strncpy(pos->gga_time, data_field, 16);
+            sscanf(data_field, "%2d%2d%lf", &(pos->hour), &(pos->min), &value);
+            pos->sec = value;
+
+            nmea_get_field(gps_data, ',', NMEA_GGA_LAT, data_field, 16);
+            sscanf(data_field, "%2lf%lf", &deg, &min);
+            pos->latitude = lround((deg + min/60.0) * 1000000.0) / 1000000.0;
+            nmea_get_field(gps_data, ',', NMEA_GGA_NS, data_field, 16);
+            if ( data_field[0] == 'S')
+                pos->latitude *= -1.0;
+
+            nmea_get_field(gps_data, ',', NMEA_GGA_LONG, data_field, 16);
+            sscanf(data_field, "%3lf%lf", &deg, &min);
+            pos->longitude = lround((deg + min/60.0) * 1000000.0) / 1000000.0;
+            nmea_get_field(gps_data, ',', NMEA_GGA_EW, data_field, 16);
+            if ( data_field[0] == 'W')
+                pos->longitude *= -1.0;
+
+            nmea_get_field(gps_data, ',', NMEA_GGA_SAT, data_field, 16);
+            pos->sat_count = atoi(data_field);
+
+            exit_value = 1;
+        }
+    }
+    else if ( strcmp(data_field, "GPRMC") == 0 )
+    {
+        nmea_get_field(gps_data, ',', NMEA_RMC_STATUS, data_field, 16);
+        if ( strcmp(data_field, "A") == 0 )
+        {
+            nmea_get_field(gps_data, ',', NMEA_RMC_UTC, data_field, 16);
+            strncpy(pos->rmc_time, data_field, 16);
+
+            nmea_get_field(gps_data, ',', NMEA_RMC_GNDSPD, data_field, 16);
+            if ( sscanf(data_field, "%lf", &value) == 1 )
+                pos->ground_spd = value * 1.150779;
+
+            nmea_get_field(gps_data, ',', NMEA_RMC_COURSE, data_field, 16);
+            if ( sscanf(data_field, "%lf", &value) == 1 )
+                pos->heading = value;
+
+            exit_value = 1;
+        }
+    }
+
+    if ( exit_value == 1 && strcmp(pos->gga_time, pos->rmc_time) == 0 )
+        pos->gga_rmc_sync = 1;
+    else
+        pos->gga_rmc_sync = 0;
+
+    return exit_value;
+}
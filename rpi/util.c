@@ -17,10 +17,14 @@
 #include    <termios.h>
 #include    <unistd.h>
 #include    <ctype.h>
+#include    <stdint.h>
+#include    <poll.h>
+#include    <sys/timerfd.h>
 #include    <libxml/parser.h>
 #include    <libxml/tree.h>
 
 #include    "util.h"
+#include    "hal.h"
 #include    "config.h"
 
 /********************************************************************
@@ -28,6 +32,12 @@
  *
  */
 #define     PB_DEBUONCE     100     // push button debounce delay in mSec
+#define     UDEG_PER_DEG    1000000 // micro-degrees per degree
+#define     NMEA_MIN_DIGITS 8       // decoded digits of coordinate minute fractions
+#define     KNOTS_TO_MPH    1.150779
+
+// Decimal digit test that does not depend on the locale
+#define     NMEA_DIGIT(c)   ((unsigned int) ((c) - '0') < 10)
 
 /********************************************************************
  * Static functions
@@ -36,6 +46,32 @@
 static int  get_maps(xmlNode*, struct map_t**);
 static void get_map_elements(xmlNode *, struct map_t *);
 
+/********************************************************************
+ * uart_open()
+ *
+ *  Open a UART for non-blocking reads at 9600 baud, 8N1.
+ *
+ *  param:  UART device name
+ *  return: file descriptor,
+ *         -1 if error opening the UART
+ *
+ */
+int uart_open(const char *device)
+{
+    int     fd;
+
+    fd = open(device, O_RDWR | O_NOCTTY | O_NDELAY);
+    if ( fd == -1 )
+        return -1;
+
+    // Setup UART options
+    uart_set_interface_attr(fd, B9600, 0);
+    uart_set_blocking(fd, 0);
+    fcntl(fd, F_SETFL, FNDELAY);
+
+    return fd;
+}
+
 /********************************************************************
  * uart_set_interface_attr()
  *
@@ -121,88 +157,135 @@ int uart_set_blocking(int fd, int should_block)
     return 0;
 }
 
+/********************************************************************
+ * uart_reader_init()
+ *
+ *  Initialize a buffered line reader for a UART opened with uart_open().
+ *
+ *  param:  pointer to line reader, UART file descriptor
+ *  return: none
+ *
+ */
+void uart_reader_init(struct uart_reader_t *reader, int fd)
+{
+    reader->fd = fd;
+    reader->start = 0;
+    reader->scan = 0;
+    reader->end = 0;
+}
+
 /********************************************************************
  * uart_read_line()
  *
  *  Read a text line from the UART stream.
- *  Reads an entire line from file 'fd', storing characters read into a buffer
- *  pointed to by 'lineptr'.  The buffer is null-terminated
- *  and does not includes the newline character, if one was found before
- *  storage buffer space is depleted.
- *  Before calling uart_read_line(), *lineptr should contain a
- *  pointer to an allocated buffer *n bytes in size.  If the
- *  buffer is not large enough to hold the line, only *n characters will
- *  be read and null terminated, and the function will return the numbers of
- *  characters read.
- *
- *  param:  file descriptor, pointer to input buffer, size of input buffer
- *  return: Number of characters read including the delimiter character, but not including the terminating null byte ('\0')
- *         -1 if error initializing
+ *  UART text is read into the reader buffer with one read() of everything
+ *  that is available, and lines are returned in place in the buffer, without
+ *  the line end characters and null terminated. Empty lines are skipped.
+ *  When no complete line is buffered the function waits for UART text
+ *  with poll() up to the timeout, so waiting does not use the CPU.
+ *  The partial line is moved to the start of the buffer before reading,
+ *  and a line that fills the buffer is returned as it is.
+ *  poll() on the UART does not report text that is already buffered,
+ *  so call until it returns '0' after the UART becomes readable.
+ *
+ *  param:  pointer to line reader, pointer to returned line pointer, timeout in milliseconds,
+ *          '0' to only read the available text, '-1' to wait for a line
+ *  return: Number of characters in the line, the line is valid until the next call
+ *          '0' if no complete line arrived before the timeout
+ *         -1 if error reading the UART
  *
  */
-int uart_read_line(int fd, char *lineptr, int n)
+int uart_read_line(struct uart_reader_t *reader, char **lineptr, int timeout)
 {
-    char   *str;
-    char    c;
+    struct pollfd   poll_fd;
     int     read_result;
-    int     count = 0;
+    int     length;
+    char    c;
 
-    if ( lineptr == NULL || n == 0 )
+    if ( lineptr == NULL )
         return 0;
 
-    str = lineptr;
-
-    // Read c character from UART and pack into the destination buffer
-    // passed in lineptr. Terminate with '\0' when buffer space is depleted or
-    // a new line character is encountered.
-    while ( count < (n - 1) )
+    while ( 1 )
     {
-        read_result = read(fd, &c, 1);
-
-        // handle errors in read
-        if ( read_result == -1 && errno == EAGAIN )
+        // Return the next complete line in the buffer
+        for ( ; reader->scan < reader->end; reader->scan++ )
         {
-            continue;
-        }
+            c = reader->buff[reader->scan];
+            if ( c != '\n' && c != '\r' )
+                continue;
 
-        else if ( read_result == -1 && errno != EAGAIN )
-        {
-            return -1;
+            reader->buff[reader->scan] = '\0';
+            *lineptr = &reader->buff[reader->start];
+            length = reader->scan - reader->start;
+            reader->start = ++reader->scan;
+
+            if ( length > 0 )
+                return length;
         }
 
-        // nothing read so keep looping for next character
-        // TODO need timeout here
-        else if ( read_result == 0 )
+        // Move the partial line to the start of the buffer,
+        // or return it if it fills the buffer
+        if ( reader->start > 0 )
         {
-            break;
+            memmove(reader->buff, &reader->buff[reader->start], reader->end - reader->start);
+            reader->end -= reader->start;
+            reader->scan -= reader->start;
+            reader->start = 0;
         }
-
-        // end of line so terminate string and exit
-        else if ( c == '\n' || c == '\r' )
+        else if ( reader->end == (UART_READ_BUFF - 1) )
         {
-            *str = '\0';
-            break;
+            reader->buff[reader->end] = '\0';
+            *lineptr = reader->buff;
+            length = reader->end;
+            reader->scan = 0;
+            reader->end = 0;
+            return length;
         }
 
-        *str++ = c;
-        count++;
-    }
+        // Wait for UART text
+        poll_fd.fd = reader->fd;
+        poll_fd.events = POLLIN;
+        read_result = poll(&poll_fd, 1, timeout);
 
-    return count;
+        if ( read_result == -1 && errno == EINTR )
+            continue;
+        else if ( read_result == -1 )
+            return -1;
+        else if ( read_result == 0 )
+            return 0;
+
+        // Read everything available
+        read_result = read(reader->fd, &reader->buff[reader->end], (UART_READ_BUFF - 1) - reader->end);
+
+        if ( read_result == -1 && (errno == EAGAIN || errno == EINTR) )
+            continue;
+        else if ( read_result == -1 )
+            return -1;
+
+        // end of file, such as a closed pipe
+        else if ( read_result == 0 )
+            return 0;
+
+        reader->end += read_result;
+    }
 }
 
 /********************************************************************
  * uart_flush()
  *
- *  Flush UART buffer.
+ *  Flush UART buffer and the line reader buffer.
  *
- *  param:  file descriptor
+ *  param:  pointer to line reader
  *  return: '0' on success. '-1' on failure and set errno to indicate the error
  *
  */
-int uart_flush(int fd)
+int uart_flush(struct uart_reader_t *reader)
 {
-    return tcflush(fd, TCIOFLUSH);
+    reader->start = 0;
+    reader->scan = 0;
+    reader->end = 0;
+
+    return tcflush(reader->fd, TCIOFLUSH);
 }
 
 /********************************************************************
@@ -408,84 +491,391 @@ int nmea_checksum(char *str)
     return (int)checksum;
 }
 
+/********************************************************************
+ * nmea_tokenize()
+ *
+ *  Split an NMEA sentence into its fields in one pass, and validate
+ *  the checksum while splitting. Leading '$' characters are skipped.
+ *  Fields are not copied, the offset and length of every field in the
+ *  sentence text are recorded, and fields are read in place with the
+ *  nmea_field_*() functions. Fields beyond NMEA_FIELDS are included in
+ *  the checksum but are not recorded.
+ *
+ *  param:  NMEA sentence string, pointer to tokenized sentence
+ *  return: Number of recorded fields,
+ *          '0' if the checksum is missing or does not match
+ *
+ */
+int nmea_tokenize(const char *str, struct nmea_sentence_t *sentence)
+{
+    uint8_t     checksum = 0;
+    int         count = 0;
+    int         start = 0;
+    int         i, n;
+    int         sum, digit;
+    char        c;
+
+    while ( *str == '$' )
+        str++;
+
+    sentence->text = str;
+    sentence->count = 0;
+
+    // Split the fields up to the checksum delimiter
+    for ( i = 0; (c = str[i]) != '*'; i++ )
+    {
+        if ( c == '\0' )
+            return 0;
+
+        checksum ^= (uint8_t) c;
+
+        if ( c == ',' )
+        {
+            if ( count < NMEA_FIELDS )
+            {
+                sentence->field[count].offset = start;
+                sentence->field[count].length = i - start;
+                count++;
+            }
+            start = i + 1;
+        }
+    }
+
+    if ( count < NMEA_FIELDS )
+    {
+        sentence->field[count].offset = start;
+        sentence->field[count].length = i - start;
+        count++;
+    }
+
+    // Two hex digit checksum after the delimiter
+    sum = 0;
+    for ( n = 0, i++; n < 2; n++, i++ )
+    {
+        c = str[i];
+        if ( c >= '0' && c <= '9' )
+            digit = c - '0';
+        else if ( (c | 0x20) >= 'a' && (c | 0x20) <= 'f' )
+            digit = (c | 0x20) - 'a' + 10;
+        else
+            return 0;
+
+        sum = (sum << 4) + digit;
+    }
+
+    if ( sum != checksum )
+        return 0;
+
+    sentence->count = count;
+
+    return count;
+}
+
+/********************************************************************
+ * nmea_field_is()
+ *
+ *  Compare a tokenized NMEA field to a string.
+ *
+ *  param:  pointer to tokenized sentence, 0-based field index, string
+ *  return: 1 if the field equals the string, 0 if not or if there is no such field
+ *
+ */
+int nmea_field_is(const struct nmea_sentence_t *sentence, int field, const char *str)
+{
+    const struct nmea_field_t *f;
+
+    if ( field < 0 || field >= sentence->count )
+        return 0;
+
+    f = &sentence->field[field];
+
+    return ( strncmp(&sentence->text[f->offset], str, f->length) == 0 && str[f->length] == '\0' );
+}
+
+/********************************************************************
+ * nmea_field_text()
+ *
+ *  Return a tokenized NMEA field in place.
+ *  The field is not '\0' terminated, it ends with the ',' or '*'
+ *  delimiter, so it can be read with functions that stop at the first
+ *  character that is not part of a number, such as atoi().
+ *
+ *  param:  pointer to tokenized sentence, 0-based field index
+ *  return: Pointer to the field in the sentence text,
+ *          or to an empty string if there is no such field
+ *
+ */
+const char *nmea_field_text(const struct nmea_sentence_t *sentence, int field)
+{
+    if ( field < 0 || field >= sentence->count )
+        return "";
+
+    return &sentence->text[sentence->field[field].offset];
+}
+
+/********************************************************************
+ * nmea_field_copy()
+ *
+ *  Copy a tokenized NMEA field to a '\0' terminated string.
+ *  The rest of the string space is cleared, so equal fields
+ *  always leave equal string space.
+ *
+ *  param:  pointer to tokenized sentence, 0-based field index,
+ *          pointer to allocated field string and its length
+ *  return: Field length in bytes, or '-1' if there is no such field
+ *
+ */
+int nmea_field_copy(const struct nmea_sentence_t *sentence, int field, char *field_str, int field_size)
+{
+    int     field_len;
+
+    if ( field < 0 || field >= sentence->count || field_size == 0 )
+        return -1;
+
+    field_len = sentence->field[field].length;
+    field_len = ((field_len+1) > field_size) ? (field_size - 1) : field_len;
+    memcpy(field_str, &sentence->text[sentence->field[field].offset], field_len);
+    memset(&field_str[field_len], 0, field_size - field_len);
+
+    return field_len;
+}
+
+/********************************************************************
+ * nmea_decode_coord()
+ *
+ *  Decode an NMEA latitude 'ddmm.mmmm' or longitude 'dddmm.mmmm' field
+ *  in place, into micro-degrees. The minutes are decoded as an exact
+ *  integer count of their last digit, and converted with integer
+ *  arithmetic, so the only error is the rounding to the nearest
+ *  micro-degree. The hemisphere is not part of the field.
+ *
+ *  param:  field text ending with a non-digit character,
+ *          number of degree digits (NMEA_LAT_DEG or NMEA_LONG_DEG),
+ *          pointer to returned micro-degrees
+ *  return: '0' if decoded, '-1' if the field is not a valid coordinate
+ *
+ */
+int nmea_decode_coord(const char *text, int deg_digits, int32_t *udeg)
+{
+    int32_t     deg = 0;
+    int64_t     min = 0;
+    int64_t     scale = 1;
+    int         i;
+
+    // Degrees and whole minutes have a fixed number of digits
+    for ( i = 0; i < deg_digits + 2; i++ )
+    {
+        if ( !NMEA_DIGIT(text[i]) )
+            return -1;
+
+        if ( i < deg_digits )
+            deg = (deg * 10) + (text[i] - '0');
+        else
+            min = (min * 10) + (text[i] - '0');
+    }
+
+    // Minute fraction, digits beyond NMEA_MIN_DIGITS are below a micro-degree
+    if ( text[i] == '.' )
+    {
+        for ( i++; NMEA_DIGIT(text[i]); i++ )
+        {
+            if ( scale < 100000000 )
+            {
+                min = (min * 10) + (text[i] - '0');
+                scale *= 10;
+            }
+        }
+    }
+
+    if ( min >= (60 * scale) )
+        return -1;
+
+    // Minutes to micro-degrees rounded to nearest
+    *udeg = (deg * UDEG_PER_DEG) + (int32_t) (((min * UDEG_PER_DEG * 2) + (60 * scale)) / (120 * scale));
+
+    return 0;
+}
+
+/********************************************************************
+ * nmea_decode_time()
+ *
+ *  Decode an NMEA UTC time 'hhmmss.sss' field in place.
+ *  Seconds are returned in milliseconds, digits beyond
+ *  milliseconds are dropped. Hours above 23, minutes above 59
+ *  and seconds above 60, a leap second, are not valid.
+ *
+ *  param:  field text ending with a non-digit character,
+ *          pointers to returned hours, minutes and milliseconds
+ *  return: '0' if decoded, '-1' if the field is not a valid time
+ *
+ */
+int nmea_decode_time(const char *text, int *hour, int *min, int32_t *msec)
+{
+    int     digit[6];
+    int32_t fraction = 0;
+    int32_t scale = 1000;
+    int     i;
+
+    for ( i = 0; i < 6; i++ )
+    {
+        if ( !NMEA_DIGIT(text[i]) )
+            return -1;
+        digit[i] = text[i] - '0';
+    }
+
+    if ( text[i] == '.' )
+    {
+        for ( i++; NMEA_DIGIT(text[i]) && scale > 1; i++ )
+        {
+            scale /= 10;
+            fraction += (text[i] - '0') * scale;
+        }
+    }
+
+    if ( ((digit[0] * 10) + digit[1]) > 23 || ((digit[2] * 10) + digit[3]) > 59 ||
+         ((digit[4] * 10) + digit[5]) > 60 )
+        return -1;
+
+    *hour = (digit[0] * 10) + digit[1];
+    *min = (digit[2] * 10) + digit[3];
+    *msec = (((digit[4] * 10) + digit[5]) * 1000) + fraction;
+
+    return 0;
+}
+
+/********************************************************************
+ * nmea_decode_fixed()
+ *
+ *  Decode an NMEA decimal field, such as a speed or a course,
+ *  in place into a fixed-point integer with 'decimals' fraction digits.
+ *  Further fraction digits are rounded to nearest.
+ *
+ *  param:  field text ending with a character that is not part of the number,
+ *          fraction digits of the returned value, pointer to returned value
+ *  return: '0' if decoded, '-1' if the field is empty, not a number or too large
+ *
+ */
+int nmea_decode_fixed(const char *text, int decimals, int32_t *value)
+{
+    int64_t     result = 0;
+    int         negative = 0;
+    int         digits = 0;
+    int         i = 0;
+
+    if ( text[i] == '-' )
+    {
+        negative = 1;
+        i++;
+    }
+
+    for ( ; NMEA_DIGIT(text[i]); i++, digits++ )
+    {
+        result = (result * 10) + (text[i] - '0');
+        if ( result > INT32_MAX )
+            return -1;
+    }
+
+    if ( text[i] == '.' )
+    {
+        for ( i++; NMEA_DIGIT(text[i]); i++, digits++ )
+        {
+            if ( decimals > 0 )
+            {
+                result = (result * 10) + (text[i] - '0');
+                decimals--;
+            }
+            else if ( decimals == 0 )
+            {
+                result += (text[i] >= '5');
+                decimals--;
+            }
+        }
+    }
+
+    if ( digits == 0 )
+        return -1;
+
+    for ( ; decimals > 0; decimals-- )
+        result *= 10;
+
+    if ( result > INT32_MAX )
+        return -1;
+
+    *value = negative ? (int32_t) -result : (int32_t) result;
+
+    return 0;
+}
+
 /********************************************************************
  * nmea_update_pos()
  *
  *  Extract GPS information from NMEA sentence string,
  *  and update GPS position data structure.
  *  Function handles only 'GGA' and 'RMC' sentences.
+ *  The sentence is tokenized once and fields are decoded in place
+ *  with exact integer arithmetic, the sentence string is not modified.
+ *  Coordinates are rounded to micro-degrees.
  *
  *  param:  NMEA sentence string, pointer to position data structure
  *  return: 1- valid fix indicated, 0- Invalid fix indicated
  *
  */
-int nmea_update_pos(char *str, struct position_t *pos)
+int nmea_update_pos(const char *str, struct position_t *pos)
 {
+    struct nmea_sentence_t  sentence;
     int     exit_value = 0;
-    char    gps_data[128] = {0};
-    char    checksum_str[4] = {0};
-    char    data_field[16] = {0};
-    float   deg, min;
-
-    // Strip '$' header and separate the fields in the NMEA sentence
-    lstrip(str, "$");
-    nmea_get_field(str, '*', NMEA_MSG, gps_data, 128);
-    nmea_get_field(str, '*', NMEA_CHECKSUM, checksum_str, 4);
+    int     hour, min;
+    int32_t value, msec, lat, lon;
 
-    // Validate the checksum
-    if ( strtol(checksum_str, NULL, 16) != nmea_checksum(gps_data) )
+    // Separate the fields in the NMEA sentence and validate the checksum
+    if ( nmea_tokenize(str, &sentence) == 0 )
     {
         return 0;
     }
 
     // Handle GGA and RMC sentences
-    nmea_get_field(gps_data, ',', NMEA_MSG_ID, data_field, 16);
-
-    if ( strcmp(data_field, "GPGGA") == 0 )
+    if ( nmea_field_is(&sentence, NMEA_MSG_ID, "GPGGA") )
     {
-        nmea_get_field(gps_data, ',', NMEA_GGA_FIXOK, data_field, 16);
-        if ( atoi(data_field) == 1 )
+        if ( nmea_decode_fixed(nmea_field_text(&sentence, NMEA_GGA_FIXOK), 0, &value) == 0 && value == 1 &&
+             nmea_decode_time(nmea_field_text(&sentence, NMEA_GGA_UTC), &hour, &min, &msec) == 0 &&
+             nmea_decode_coord(nmea_field_text(&sentence, NMEA_GGA_LAT), NMEA_LAT_DEG, &lat) == 0 &&
+             nmea_decode_coord(nmea_field_text(&sentence, NMEA_GGA_LONG), NMEA_LONG_DEG, &lon) == 0 )
         {
-            nmea_get_field(gps_data, ',', NMEA_GGA_UTC, data_field, 16);
-            strncpy(pos->gga_time, data_field, 16);
-            sscanf(data_field, "%2d%2d%6f", &(pos->hour), &(pos->min), &(pos->sec));
-
-            nmea_get_field(gps_data, ',', NMEA_GGA_LAT, data_field, 16);
-            sscanf(data_field, "%2f%7f", &deg, &min);
-            pos->latitude = deg + min/60.0;
-            nmea_get_field(gps_data, ',', NMEA_GGA_NS, data_field, 16);
-            if ( data_field[0] == 'S')
-                pos->latitude *= -1.0;
-
-            nmea_get_field(gps_data, ',', NMEA_GGA_LONG, data_field, 16);
-            sscanf(data_field, "%3f%7f", &deg, &min);
-            pos->longitude = deg + min/60.0;
-            nmea_get_field(gps_data, ',', NMEA_GGA_EW, data_field, 16);
-            if ( data_field[0] == 'W')
-                pos->longitude *= -1.0;
-
-            nmea_get_field(gps_data, ',', NMEA_GGA_SAT, data_field, 16);
-            pos->sat_count = atoi(data_field);
+            nmea_field_copy(&sentence, NMEA_GGA_UTC, pos->gga_time, sizeof(pos->gga_time));
+            pos->hour = hour;
+            pos->min = min;
+            pos->sec = msec / 1000.0;
+
+            if ( nmea_field_is(&sentence, NMEA_GGA_NS, "S") )
+                lat = -lat;
+            pos->latitude = (double) lat / UDEG_PER_DEG;
+
+            if ( nmea_field_is(&sentence, NMEA_GGA_EW, "W") )
+                lon = -lon;
+            pos->longitude = (double) lon / UDEG_PER_DEG;
+
+            if ( nmea_decode_fixed(nmea_field_text(&sentence, NMEA_GGA_SAT), 0, &value) == 0 )
+                pos->sat_count = value;
+            else
+                pos->sat_count = 0;
 
             exit_value = 1;
         }
         else
             exit_value = 0;
     }
-    else if ( strcmp(data_field, "GPRMC") == 0 )
+    else if ( nmea_field_is(&sentence, NMEA_MSG_ID, "GPRMC") )
     {
-        nmea_get_field(gps_data, ',', NMEA_RMC_STATUS, data_field, 16);
-        if ( strcmp(data_field, "A") == 0 )
+        if ( nmea_field_is(&sentence, NMEA_RMC_STATUS, "A") )
         {
-            nmea_get_field(gps_data, ',', NMEA_RMC_UTC, data_field, 16);
-            strncpy(pos->rmc_time, data_field, 16);
+            nmea_field_copy(&sentence, NMEA_RMC_UTC, pos->rmc_time, sizeof(pos->rmc_time));
 
-            nmea_get_field(gps_data, ',', NMEA_RMC_GNDSPD, data_field, 16);
-            sscanf(data_field, "%4f", &(pos->ground_spd));
-            pos->ground_spd *= 1.150779;
+            // Speed and course are left unchanged when their fields are empty
+            if ( nmea_decode_fixed(nmea_field_text(&sentence, NMEA_RMC_GNDSPD), 3, &value) == 0 )
+                pos->ground_spd = (value / 1000.0) * KNOTS_TO_MPH;
 
-            nmea_get_field(gps_data, ',', NMEA_RMC_COURSE, data_field, 16);
-            sscanf(data_field, "%6f", &(pos->heading));
+            if ( nmea_decode_fixed(nmea_field_text(&sentence, NMEA_RMC_COURSE), 3, &value) == 0 )
+                pos->heading = value / 1000.0;
 
             exit_value = 1;
         }
@@ -519,50 +909,50 @@ int push_button_read(void)
     int     push_button_code = -1;
 
     // Read and de-bounce UP button
-    if ( bcm2835_gpio_lev(PBUTTON_UP) == LOW )
+    if ( hal_gpio_read(PBUTTON_UP) == LOW )
     {
-        bcm2835_delay(PB_DEBUONCE);
-        if ( bcm2835_gpio_lev(PBUTTON_UP) == LOW )
+        hal_delay(PB_DEBUONCE);
+        if ( hal_gpio_read(PBUTTON_UP) == LOW )
         {
             push_button_code = PB_UP;
         }
     }
 
     // Read and de-bounce UP button
-    else if ( bcm2835_gpio_lev(PBUTTON_DOWN) == LOW )
+    else if ( hal_gpio_read(PBUTTON_DOWN) == LOW )
     {
-        bcm2835_delay(PB_DEBUONCE);
-        if ( bcm2835_gpio_lev(PBUTTON_DOWN) == LOW )
+        hal_delay(PB_DEBUONCE);
+        if ( hal_gpio_read(PBUTTON_DOWN) == LOW )
         {
             push_button_code = PB_DOWN;
         }
     }
 
     // Read and de-bounce LEFT button
-    else if ( bcm2835_gpio_lev(PBUTTON_LEFT) == LOW )
+    else if ( hal_gpio_read(PBUTTON_LEFT) == LOW )
     {
-        bcm2835_delay(PB_DEBUONCE);
-        if ( bcm2835_gpio_lev(PBUTTON_LEFT) == LOW )
+        hal_delay(PB_DEBUONCE);
+        if ( hal_gpio_read(PBUTTON_LEFT) == LOW )
         {
             push_button_code = PB_LEFT;
         }
     }
 
     // Read and de-bounce RIGHT button
-    else if ( bcm2835_gpio_lev(PBUTTON_RIGHT) == LOW )
+    else if ( hal_gpio_read(PBUTTON_RIGHT) == LOW )
     {
-        bcm2835_delay(PB_DEBUONCE);
-        if ( bcm2835_gpio_lev(PBUTTON_RIGHT) == LOW )
+        hal_delay(PB_DEBUONCE);
+        if ( hal_gpio_read(PBUTTON_RIGHT) == LOW )
         {
             push_button_code = PB_RIGHT;
         }
     }
 
     // Read and de-bounce SELECT button
-    else if ( bcm2835_gpio_lev(PBUTTON_SELECT) == LOW )
+    else if ( hal_gpio_read(PBUTTON_SELECT) == LOW )
     {
-        bcm2835_delay(PB_DEBUONCE);
-        if ( bcm2835_gpio_lev(PBUTTON_SELECT) == LOW )
+        hal_delay(PB_DEBUONCE);
+        if ( hal_gpio_read(PBUTTON_SELECT) == LOW )
         {
             push_button_code = PB_SELECT;
         }
@@ -571,6 +961,65 @@ int push_button_read(void)
     return push_button_code;
 }
 
+/********************************************************************
+ * frame_timer_open()
+ *
+ *  Open a periodic timer that paces display frames.
+ *  The returned file descriptor becomes readable at every frame tick
+ *  and can be waited on with poll() together with the UART.
+ *
+ *  param:  frame rate in frames per second
+ *  return: timer file descriptor, '-1' on failure and set errno to indicate the error
+ *
+ */
+int frame_timer_open(int fps)
+{
+    int                 fd;
+    struct itimerspec   period;
+
+    if ( fps <= 0 )
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if ( fd == -1 )
+        return -1;
+
+    // A period of a second or longer does not fit in 'tv_nsec'
+    period.it_interval.tv_sec = 1 / fps;
+    period.it_interval.tv_nsec = (1000000000L / fps) % 1000000000L;
+    period.it_value = period.it_interval;
+
+    if ( timerfd_settime(fd, 0, &period, NULL) == -1 )
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/********************************************************************
+ * frame_timer_ack()
+ *
+ *  Acknowledge frame ticks of a frame timer.
+ *
+ *  param:  timer file descriptor
+ *  return: number of frame ticks since the last call, '0' if none
+ *
+ */
+int frame_timer_ack(int fd)
+{
+    uint64_t    ticks;
+
+    if ( read(fd, &ticks, sizeof(ticks)) != sizeof(ticks) )
+        return 0;
+
+    return (int) ticks;
+}
+
 /********************************************************************
  * get_maps()
  *
@@ -587,7 +1036,7 @@ static int get_maps(xmlNode *a_node, struct map_t **map_meta_data_ptr)
     int      map_count = 0;
     xmlNode *cur_node = NULL;
     struct map_t *new_map_meta_data;
-    struct map_t *curr_map;
+    struct map_t *curr_map = NULL;
 
     for (cur_node = a_node; cur_node; cur_node = cur_node->next)
     {
@@ -642,7 +1091,7 @@ static void get_map_elements(xmlNode *a_node, struct map_t *map_meta_data)
         if ( cur_node->type == XML_ELEMENT_NODE && xmlStrEqual(cur_node->name, (const xmlChar *)"file") )
         {
             content = xmlNodeGetContent(cur_node);
-            strncpy(map_meta_data->file_name, (const char *)content, MAX_FILE_NAME_LEN);
+            strncpy(map_meta_data->file_name, (const char *)content, MAX_FILE_NAME_LEN - 1);
             xmlFree(content);
         }
         else if ( cur_node->type == XML_ELEMENT_NODE && xmlStrEqual(cur_node->name, (const xmlChar *)"height") )
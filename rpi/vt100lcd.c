@@ -12,6 +12,8 @@
 #include    <string.h>
 #include    <assert.h>
 #include    <stdarg.h>
+#include    <limits.h>
+#include    <math.h>
 
 #include    "pilcd.h"                   // ST7735 1.8" LCD driver
 #include    "vt100lcd.h"                // VT100 API
@@ -35,6 +37,41 @@
 
 #define     VT100_LINE_LEN  80
 
+#define     VT100_MAX_ROWS  (ST7735_TFTHEIGHT / FONT_PIX_HIGH)  // text cell grid for the
+#define     VT100_MAX_COLS  (ST7735_TFTHEIGHT / FONT_PIX_WIDE)  // longer screen side in both directions
+
+/* a text cell holds the character, attributes and colors packed in one word,
+ * so checking a cell for a change is one compare
+ */
+typedef uint64_t    vt100cell_t;
+
+#define     CELL(c, a, fg, bg)  ((vt100cell_t) (uint8_t) (c) | ((vt100cell_t) (a) << 8) | \
+                                 ((vt100cell_t) (fg) << 16) | ((vt100cell_t) (bg) << 32))
+#define     CELL_CHAR(cell)     ((char) ((cell) & 0xff))
+#define     CELL_ATTR(cell)     ((int) (((cell) >> 8) & 0xff))
+#define     CELL_FG(cell)       ((uint16_t) ((cell) >> 16))
+#define     CELL_BG(cell)       ((uint16_t) ((cell) >> 32))
+
+#define     CELL_TRANSPARENT    0x01        // cell attribute, character drawn without background
+#define     CELL_UNKNOWN        ((vt100cell_t) -1)  // frame buffer content of the cell is not known
+
+#define     VT100_FIELDS        16          // registered numeric fields
+#define     VT100_FIELD_DEC     9           // most decimals of a fixed point field
+
+/* a numeric field is a fixed text cell range that is updated
+ * with a value, without a format string or escape codes
+ */
+typedef struct
+{
+    uint8_t     row;
+    uint8_t     col;
+    uint8_t     width;
+    uint8_t     decimals;
+    uint8_t     flags;
+    uint16_t    fg;
+    uint16_t    bg;
+} vt100field_t;
+
 /* -----------------------------------------
    module globals
 ----------------------------------------- */
@@ -49,13 +86,29 @@ static uint8_t          vt100maxCols;
 static uint8_t          vt100lineWrap;
 static int              vt100fontScale;
 
+static vt100cell_t      vt100cells[VT100_MAX_ROWS][VT100_MAX_COLS];     // text on the terminal
+static vt100cell_t      vt100drawn[VT100_MAX_ROWS][VT100_MAX_COLS];     // text rasterized in the frame buffer
+static int              vt100touchFirst[VT100_MAX_ROWS];                // cells written since the last flush,
+static int              vt100touchLast[VT100_MAX_ROWS];                 // a column range per row, empty if first > last
+
+static vt100field_t     vt100fields[VT100_FIELDS];
+static int              vt100fieldCount;
+
+static const double     fieldScale[VT100_FIELD_DEC + 1] =
+                            {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
 /* -----------------------------------------
    static functions
 ----------------------------------------- */
-static uint8_t  parseEscapeSeq(uint8_t*, int, char);
+static void     processChar(uint16_t*, int, char);
+static void     setCell(uint16_t*, int, int, vt100cell_t);
+static void     flushCells(uint16_t*);
+static void     formatFixed(char*, int, int, int, long);
+static void     writeField(uint16_t*, int, const char*);
+static uint8_t  parseEscapeSeq(uint16_t*, int, char);
 static void     getEscapeParam(char*, int*, int*);
 static uint16_t converToColor(int);
-static void     clearScreen(uint8_t*);
+static void     clearScreen(uint16_t*);
 
 /* -----------------------------------------
    API functions
@@ -71,6 +124,8 @@ static void     clearScreen(uint8_t*);
  */
 void vt100_lcd_init(int rotation, int scale, uint16_t bg, uint16_t fg)
 {
+    int     row, col;
+
     // initialize display rotation
     lcdSetRotation(rotation);
     
@@ -85,6 +140,34 @@ void vt100_lcd_init(int rotation, int scale, uint16_t bg, uint16_t fg)
     vt100maxRows = lcdHeight() / FONT_PIX_HIGH / scale;
     vt100maxCols = lcdWidth() / FONT_PIX_WIDE / scale;
     vt100fontScale = scale;
+
+    // the terminal is blank, and the frame buffer content is not known yet
+    for ( row = 0; row < VT100_MAX_ROWS; row++ )
+    {
+        for ( col = 0; col < VT100_MAX_COLS; col++ )
+            vt100cells[row][col] = CELL(ASCII_SPC, 0, fg, bg);
+        vt100touchFirst[row] = VT100_MAX_COLS;
+        vt100touchLast[row] = -1;
+    }
+    vt100_lcd_invalidate();
+    vt100_lcd_field_reset();
+}
+
+/*------------------------------------------------
+ * vt100_lcd_invalidate()
+ *
+ *  mark the text in the frame buffer as not known, so that all
+ *  cells are rasterized again when they are written.
+ *  call after drawing over the text area with anything other
+ *  than this module, such as clearing the frame buffer or
+ *  rendering a map under transparent text
+ *
+ * param:  none
+ * return: none
+ */
+void vt100_lcd_invalidate(void)
+{
+    memset(vt100drawn, 0xff, sizeof(vt100drawn));
 }
 
 /*------------------------------------------------
@@ -123,9 +206,173 @@ int vt100_lcd_rows(void)
  *         character code to output, and can include VT100 escape codes to change color and move cursor
  * return: none
  */
-void vt100_lcd_putc(uint8_t* frameBuff, int transparent, char c)
+void vt100_lcd_putc(uint16_t* frameBuff, int transparent, char c)
+{
+    processChar(frameBuff, transparent, c);
+    flushCells(frameBuff);
+}
+
+/*------------------------------------------------
+ * vt100_lcd_printf()
+ *
+ * A printf() style command for text output to LCD or frame buffer,
+ * with VT100 support.
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         transparent '0' paint background color, '1' transparent background only when writing to buffer
+ *         format      A printf() style format string including VT100 escape codes
+ *         ...         Zero or more variables to format and print
+ * return: Number of characters actually printed, '-1' on failure
+ *
+ */
+int vt100_lcd_printf(uint16_t* frameBuff, int transparent, const char* format, ...)
+{
+    va_list arg;
+    int     i = 0;
+    int     char_printer;
+    char    str[VT100_LINE_LEN] = {0};
+
+    va_start(arg, format);
+
+    char_printer = vsnprintf(str, VT100_LINE_LEN, format, arg);
+    while ( str[i] )
+    {
+        processChar(frameBuff, transparent, str[i]);
+        i++;
+    }
+
+    flushCells(frameBuff);
+
+    va_end(arg);
+
+    return char_printer;
+}
+
+/*------------------------------------------------
+ * vt100_lcd_field()
+ *
+ *  register a numeric field, a fixed range of text cells on one row
+ *  that is updated with a value by vt100_lcd_field_int() or vt100_lcd_field_float().
+ *  numbers are right aligned and padded with spaces unless the flags
+ *  select left alignment or leading zeros. a value that does not fit
+ *  the field is shown as '*' characters
+ *
+ * param:  row, col    first text cell of the field
+ *         width       field width in characters, up to VT100_FIELD_WIDTH
+ *         decimals    digits after the decimal point, '0' for an integer field
+ *         flags       VT100_FIELD_LEFT, VT100_FIELD_ZERO, VT100_FIELD_TRANSPARENT
+ *         fg, bg      foreground and background colors
+ * return: field handle, '-1' if the field is not on the screen or no more fields are available
+ */
+int vt100_lcd_field(int row, int col, int width, int decimals, int flags, uint16_t fg, uint16_t bg)
+{
+    vt100field_t*   field;
+
+    if ( vt100fieldCount == VT100_FIELDS )
+        return -1;
+
+    if ( row < 0 || row >= vt100maxRows || col < 0 || width < 1 || width > VT100_FIELD_WIDTH ||
+         (col + width) > vt100maxCols || decimals < 0 || decimals > VT100_FIELD_DEC )
+        return -1;
+
+    field = &vt100fields[vt100fieldCount];
+    field->row = row;
+    field->col = col;
+    field->width = width;
+    field->decimals = decimals;
+    field->flags = flags;
+    field->fg = fg;
+    field->bg = bg;
+
+    return vt100fieldCount++;
+}
+
+/*------------------------------------------------
+ * vt100_lcd_field_int()
+ *
+ *  update a field with a fixed point value, the field decimals
+ *  are the low digits of the value. only characters that changed
+ *  are drawn
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         handle      field handle
+ *         value       value scaled by 10 to the power of the field decimals
+ * return: none
+ */
+void vt100_lcd_field_int(uint16_t* frameBuff, int handle, long value)
+{
+    vt100field_t*   field;
+    char            text[VT100_FIELD_WIDTH];
+
+    if ( handle < 0 || handle >= vt100fieldCount )
+        return;
+
+    field = &vt100fields[handle];
+    formatFixed(text, field->width, field->decimals, field->flags, value);
+    writeField(frameBuff, handle, text);
+}
+
+/*------------------------------------------------
+ * vt100_lcd_field_float()
+ *
+ *  update a field with a value rounded to the field decimals
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         handle      field handle
+ *         value       value to show
+ * return: none
+ */
+void vt100_lcd_field_float(uint16_t* frameBuff, int handle, double value)
+{
+    vt100field_t*   field;
+    char            text[VT100_FIELD_WIDTH];
+    double          scaled;
+
+    if ( handle < 0 || handle >= vt100fieldCount )
+        return;
+
+    field = &vt100fields[handle];
+    scaled = value * fieldScale[field->decimals];
+
+    // also true for NaN
+    if ( !(scaled > LONG_MIN && scaled < LONG_MAX) )
+    {
+        memset(text, '*', field->width);
+        writeField(frameBuff, handle, text);
+        return;
+    }
+
+    formatFixed(text, field->width, field->decimals, field->flags, lround(scaled));
+    writeField(frameBuff, handle, text);
+}
+
+/*------------------------------------------------
+ * vt100_lcd_field_reset()
+ *
+ *  remove all fields, the text in the field cells stays on the screen
+ *
+ * param:  none
+ * return: none
+ */
+void vt100_lcd_field_reset(void)
+{
+    vt100fieldCount = 0;
+}
+
+/*------------------------------------------------
+ * processChar()
+ *
+ *  process a character through the VT100 driver, escape codes
+ *  change the terminal state and printable characters are
+ *  written to the text cells
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         transparent '0' paint background color, '1' transparent background only when writing to buffer
+ *         character code to process
+ * return: none
+ */
+static void processChar(uint16_t* frameBuff, int transparent, char c)
 {
-    uint16_t        x, y;
     static uint8_t  vt100escape = ESC_NONE;
 
     /* parse input character for VT100 escape code and process
@@ -185,10 +432,8 @@ void vt100_lcd_putc(uint8_t* frameBuff, int transparent, char c)
                 break;
 
             default:
-                x = vt100cursCol * FONT_PIX_WIDE;
-                y = vt100cursRow * FONT_PIX_HIGH;
-
-                lcdDrawChar(frameBuff, x, y, c, vt100foregroundColor, vt100backgroundColor, vt100fontScale, transparent);
+                setCell(frameBuff, vt100cursRow, vt100cursCol,
+                        CELL(c, transparent ? CELL_TRANSPARENT : 0, vt100foregroundColor, vt100backgroundColor));
                 vt100cursCol++;
 
                 /* handle behavior at end of line. either wrap text to next row
@@ -213,37 +458,166 @@ void vt100_lcd_putc(uint8_t* frameBuff, int transparent, char c)
 }
 
 /*------------------------------------------------
- * vt100_lcd_printf()
+ * setCell()
  *
- * A printf() style command for text output to LCD or frame buffer,
- * with VT100 support.
+ *  write a character with its attributes and colors to a text cell.
+ *  frame buffer cells are rasterized by the next flushCells(),
+ *  direct screen writes are drawn right away and not retained
  *
  * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
- *         transparent '0' paint background color, '1' transparent background only when writing to buffer
- *         format      A printf() style format string including VT100 escape codes
- *         ...         Zero or more variables to format and print
- * return: Number of characters actually printed, '-1' on failure
+ *         row, col    text cell
+ *         cell        character, attributes and colors packed with CELL()
+ * return: none
+ */
+static void setCell(uint16_t* frameBuff, int row, int col, vt100cell_t cell)
+{
+    if ( row >= vt100maxRows || col >= vt100maxCols )
+        return;
+
+    vt100cells[row][col] = cell;
+
+    if ( frameBuff == NULL )
+    {
+        lcdDrawChar(NULL, col * FONT_PIX_WIDE, row * FONT_PIX_HIGH, CELL_CHAR(cell), CELL_FG(cell), CELL_BG(cell),
+                    vt100fontScale, CELL_ATTR(cell) & CELL_TRANSPARENT);
+        vt100drawn[row][col] = CELL_UNKNOWN;
+        return;
+    }
+
+    if ( col < vt100touchFirst[row] )
+        vt100touchFirst[row] = col;
+    if ( col > vt100touchLast[row] )
+        vt100touchLast[row] = col;
+}
+
+/*------------------------------------------------
+ * flushCells()
  *
+ *  rasterize the text cells written since the last flush into the
+ *  frame buffer, only cells that differ from the rasterized text are
+ *  drawn and marked dirty. rewriting unchanged text costs one compare per cell
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL there is nothing to flush
+ * return: none
  */
-int vt100_lcd_printf(uint8_t* frameBuff, int transparent, const char* format, ...)
+static void flushCells(uint16_t* frameBuff)
 {
-    va_list arg;
-    int     i = 0;
-    int     char_printer;
-    char    str[VT100_LINE_LEN] = {0};
+    int             row, col;
+    vt100cell_t     cell;
 
-    va_start(arg, format);
+    if ( frameBuff == NULL )
+        return;
 
-    char_printer = vsnprintf(str, VT100_LINE_LEN, format, arg);
-    while ( str[i] )
+    for ( row = 0; row < vt100maxRows; row++ )
     {
-        vt100_lcd_putc(frameBuff, transparent, str[i]);
-        i++;
+        for ( col = vt100touchFirst[row]; col <= vt100touchLast[row]; col++ )
+        {
+            cell = vt100cells[row][col];
+            if ( cell == vt100drawn[row][col] )
+                continue;
+
+            lcdDrawChar(frameBuff, col * FONT_PIX_WIDE, row * FONT_PIX_HIGH, CELL_CHAR(cell), CELL_FG(cell), CELL_BG(cell),
+                        vt100fontScale, CELL_ATTR(cell) & CELL_TRANSPARENT);
+            vt100drawn[row][col] = cell;
+        }
+
+        vt100touchFirst[row] = VT100_MAX_COLS;
+        vt100touchLast[row] = -1;
     }
+}
 
-    va_end(arg);
+/*------------------------------------------------
+ * formatFixed()
+ *
+ *  format a fixed point value into exactly 'width' characters,
+ *  same text as printf() "%*.*f" with the value divided by 10 to the
+ *  power of decimals, "%-*.*f" for left alignment or "%0*.*f" for leading zeros.
+ *  the text is not zero terminated, and is all '*' if the value does not fit
+ *
+ * param:  text        output characters
+ *         width       field width
+ *         decimals    digits after the decimal point
+ *         flags       VT100_FIELD_LEFT, VT100_FIELD_ZERO
+ *         value       value scaled by 10 to the power of decimals
+ * return: none
+ */
+static void formatFixed(char* text, int width, int decimals, int flags, long value)
+{
+    char            digits[24];
+    unsigned long   magnitude;
+    int             count = 0;
+    int             i = 0;
+    int             negative, length, pad;
 
-    return char_printer;
+    negative = (value < 0);
+    magnitude = negative ? (0UL - (unsigned long) value) : (unsigned long) value;
+
+    // digits in reverse order, with at least one digit before the decimal point
+    do
+    {
+        digits[count++] = '0' + (magnitude % 10);
+        magnitude /= 10;
+    }
+    while ( magnitude || count <= decimals );
+
+    length = count + negative + (decimals ? 1 : 0);
+    if ( length > width )
+    {
+        memset(text, '*', width);
+        return;
+    }
+
+    pad = width - length;
+
+    // spaces go before the sign and leading zeros after it
+    if ( !(flags & (VT100_FIELD_LEFT | VT100_FIELD_ZERO)) )
+    {
+        for ( ; pad > 0; pad-- )
+            text[i++] = ASCII_SPC;
+    }
+
+    if ( negative )
+        text[i++] = '-';
+
+    if ( !(flags & VT100_FIELD_LEFT) )
+    {
+        for ( ; pad > 0; pad-- )
+            text[i++] = '0';
+    }
+
+    while ( count > 0 )
+    {
+        if ( count == decimals )
+            text[i++] = '.';
+        text[i++] = digits[--count];
+    }
+
+    for ( ; pad > 0; pad-- )
+        text[i++] = ASCII_SPC;
+}
+
+/*------------------------------------------------
+ * writeField()
+ *
+ *  write field text to its text cells and draw the cells that changed
+ *
+ * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
+ *         handle      valid field handle
+ *         text        field width characters
+ * return: none
+ */
+static void writeField(uint16_t* frameBuff, int handle, const char* text)
+{
+    vt100field_t*   field;
+    int             i, attr;
+
+    field = &vt100fields[handle];
+    attr = (field->flags & VT100_FIELD_TRANSPARENT) ? CELL_TRANSPARENT : 0;
+
+    for ( i = 0; i < field->width; i++ )
+        setCell(frameBuff, field->row, field->col + i, CELL(text[i], attr, field->fg, field->bg));
+
+    flushCells(frameBuff);
 }
 
 /*------------------------------------------------
@@ -270,14 +644,13 @@ int vt100_lcd_printf(uint8_t* frameBuff, int transparent, const char* format, ..
  *         character code
  * return: ESC_NONE = done, ESC_BRACKET = need more characters
  */
-static uint8_t parseEscapeSeq(uint8_t* frameBuff, int transparent, char c)
+static uint8_t parseEscapeSeq(uint16_t* frameBuff, int transparent, char c)
 {
     static uint8_t  parseState = STATE_NONE;
     static char     codeString[CODE_BUFF];
     static uint8_t  i;
 
     uint8_t         j, st, en;
-    uint16_t        x, y;
     int             n1, n2;
 
     /* initialize the VT100 code buffer before using it
@@ -435,11 +808,8 @@ static uint8_t parseEscapeSeq(uint8_t* frameBuff, int transparent, char c)
                 }
 
                 for ( j = st; j < en; j++ )
-                {
-                    x = j * FONT_PIX_WIDE;
-                    y = vt100cursRow * FONT_PIX_HIGH;
-                    lcdDrawChar(frameBuff, x, y, ASCII_SPC, vt100foregroundColor, vt100backgroundColor, vt100fontScale, transparent);
-                }
+                    setCell(frameBuff, vt100cursRow, j,
+                            CELL(ASCII_SPC, transparent ? CELL_TRANSPARENT : 0, vt100foregroundColor, vt100backgroundColor));
                 break;
 
             /*  Erase Down          <ESC>[J                 Erases the screen from the current line down to the bottom of the screen.
@@ -545,7 +915,7 @@ static void getEscapeParam(char* s, int* n1, int* n2)
  */
 static uint16_t converToColor(int vt100colorCode)
 {
-    uint16_t    color;
+    uint16_t    color = ST7735_BLACK;
 
     switch ( vt100colorCode )
     {
@@ -582,19 +952,29 @@ static uint16_t converToColor(int vt100colorCode)
 /*------------------------------------------------
  * clearScreen()
  *
- *  clear screen to background color
+ *  clear screen to background color and all text cells to blanks
+ *  a frame buffer is only cleared, it is sent to the LCD with the caller's next push
  *
  * param:  frameBuff   pointer to allocated frame buffer, if NULL the function writes direct to screen
  * return: none
  */
-static void clearScreen(uint8_t* frameBuff)
+static void clearScreen(uint16_t* frameBuff)
 {
-    uint8_t*    screen;
+    uint16_t*   screen;
+    int         row, col;
+
+    for ( row = 0; row < VT100_MAX_ROWS; row++ )
+    {
+        for ( col = 0; col < VT100_MAX_COLS; col++ )
+        {
+            vt100cells[row][col] = CELL(ASCII_SPC, 0, vt100foregroundColor, vt100backgroundColor);
+            vt100drawn[row][col] = frameBuff ? vt100cells[row][col] : CELL_UNKNOWN;
+        }
+    }
 
     if ( frameBuff )
     {
         lcdFrameBufferColor(frameBuff, vt100backgroundColor);
-        lcdFrameBufferPush(frameBuff);
     }
     else
     {